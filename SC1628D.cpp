@@ -27,14 +27,9 @@ extern "C" {
 }
 
 #include <SC1628D.h>
+#include <SC1628DCore.h>
 #include <Arduino.h>
 
-#define SC1628D_DISPLAY_MODE_CMD       0x00
-#define SC1628D_DATA_SETTING_CMD_WRITE 0x40
-#define SC1628D_DATA_SETTING_CMD_READ  0x42
-#define SC1628D_DISPLAY_CONTROL_CMD    0x80
-#define SC1628D_ADDRESS_SETTING_CMD    0xC0
-
 /*
  Keyboard pinout connected to the SC1628
 
@@ -61,174 +56,83 @@ extern "C" {
          12 4 Symbols <--->    10 SG3
 */
 
-/*
- Normal segment addressing:
- 
-    [4F]         [0A]                [1A]                    [2A]                [3A]           [4A]        
-  GR7/SG3     +-GR7/SG2-+         +-GR7/SG9-+             +-GR7/SG10+         +-GR7/SG8-+      GR5/SG3
-              |         |         |         |             |         |         |         |
-             [0F]      [0B]      [1F]      [1B]         [2F]       [2B]      [3F]      [3B]
-           GR1/SG2   GR5/SG2   GR1/SG9   GR5/SG9       GR1/SG10  GR5/SG10  GR1/SG8   GR5/SG8 
-    [4E]      |  [0G]   |         |  [1G]   |    [4G]     |  [2G]   |         |  [3G]   |       [4B]  
-  GR4/SG3     +-GR6/SG2-+         +-GR6/SG9-+   GR1/SG3   +-GR6/SG10+         +-GR6/SG8-+      GR5/SG3
-              |         |         |         |             |         |         |         |
-             [0E]      [0C]      [1E]      [1C]         [2E]       [2C]      [3E]      [3C]
-           GR2/SG2   GR4/SG2   GR2/SG9   GR4/SG9       GR2/SG10  GR4/SG10  GR2/SG8   GR4/SG8 
-    [4D]      |  [0D]   |         |  [1D]   |             |  [2D]   |         |  [3D]   |       [4C]  
-  GR3/SG3     +-GR3/SG2-+         +-GR3/SG9-+             +-GR3/SG10+         +-GR3/SG8-+      GR2/SG3
+// Build the matrix of all positions. Each segment bit is turned into its
+// SG mask with a negation, so that no branch depends on the displayed data.
+void SC1628D_RenderLayout(const SC1628DLayout &layout, const uint8_t digit[], uint16_t matrix[])
+{
+	for (uint8_t k = 0; k < 7; k++)
+		matrix[k] = 0;
+	for (uint8_t pos = 0; pos < 5; pos++)
+		SC1628D_RenderPosition(layout, pos, digit[pos], matrix);
+}
+
+// Update the matrix bits of one position, the other positions are untouched
+void SC1628D_RenderPosition(const SC1628DLayout &layout, uint8_t pos, uint8_t segments, uint16_t matrix[])
+{
+	const SC1628DSegmentMap *map = layout.map[pos];
+
+	for (uint8_t s = 0; s < 7; s++) {
+		uint16_t on = -(uint16_t)((segments >> s) & 1);
+		matrix[map[s].grid] = (matrix[map[s].grid] & ~map[s].mask) | (map[s].mask & on);
+	}
+}
+
+void SC1628D_RenderLayout_P(const SC1628DLayout &layout, const uint8_t digit[], uint16_t matrix[])
+{
+	for (uint8_t k = 0; k < 7; k++)
+		matrix[k] = 0;
+	for (uint8_t pos = 0; pos < 5; pos++)
+		SC1628D_RenderPosition_P(layout, pos, digit[pos], matrix);
+}
+
+// As SC1628D_RenderPosition, each map entry being read from flash memory
+void SC1628D_RenderPosition_P(const SC1628DLayout &layout, uint8_t pos, uint8_t segments, uint16_t matrix[])
+{
+	const SC1628DSegmentMap *map = layout.map[pos];
+
+	for (uint8_t s = 0; s < 7; s++) {
+		uint8_t grid = pgm_read_byte(&map[s].grid);
+		uint16_t mask = pgm_read_word(&map[s].mask);
+		uint16_t on = -(uint16_t)((segments >> s) & 1);
+		matrix[grid] = (matrix[grid] & ~mask) | (mask & on);
+	}
+}
+
+// The table is SC1628D_NORMAL_MAP (SC1628D.h)
+const SC1628DLayout SC1628D_NORMAL_LAYOUT PROGMEM = SC1628D_NORMAL_MAP;
 
-*/
 void SC1628D_NormalDisplay(uint8_t digit[], uint16_t matrix[])
 {
-	uint16_t mask;
-
-	// Build GR1
-	mask = 0;
-	if (digit[0] & SEG_F) mask |= SG2;
-	if (digit[4] & SEG_G) mask |= SG3;
-	if (digit[3] & SEG_F) mask |= SG8;
-	if (digit[1] & SEG_F) mask |= SG9;
-	if (digit[2] & SEG_F) mask |= SG10;
-	matrix[0] = mask;
-
-	// Build GR2
-	mask = 0;
-	if (digit[0] & SEG_E) mask |= SG2;
-	if (digit[4] & SEG_C) mask |= SG3;
-	if (digit[3] & SEG_E) mask |= SG8;
-	if (digit[1] & SEG_E) mask |= SG9;
-	if (digit[2] & SEG_E) mask |= SG10;
-	matrix[1] = mask;
-
-	// Build GR3
-	mask = 0;
-	if (digit[0] & SEG_D) mask |= SG2;
-	if (digit[4] & SEG_D) mask |= SG3;
-	if (digit[3] & SEG_D) mask |= SG8;
-	if (digit[1] & SEG_D) mask |= SG9;
-	if (digit[2] & SEG_D) mask |= SG10;
-	matrix[2] = mask;
-
-	// Build GR4
-	mask = 0;
-	if (digit[0] & SEG_C) mask |= SG2;
-	if (digit[4] & SEG_E) mask |= SG3;
-	if (digit[3] & SEG_C) mask |= SG8;
-	if (digit[1] & SEG_C) mask |= SG9;
-	if (digit[2] & SEG_C) mask |= SG10;
-	matrix[3] = mask;
-
-	// Build GR5
-	mask = 0;
-	if (digit[0] & SEG_B) mask |= SG2;
-	if (digit[4] & SEG_A) mask |= SG3;
-	if (digit[3] & SEG_B) mask |= SG8;
-	if (digit[1] & SEG_B) mask |= SG9;
-	if (digit[2] & SEG_B) mask |= SG10;
-	matrix[4] = mask;
-
-	// Build GR6
-	mask = 0;
-	if (digit[0] & SEG_G) mask |= SG2;
-	if (digit[4] & SEG_B) mask |= SG3;
-	if (digit[3] & SEG_G) mask |= SG8;
-	if (digit[1] & SEG_G) mask |= SG9;
-	if (digit[2] & SEG_G) mask |= SG10;
-	matrix[5] = mask;
-
-	// Build GR7
-	mask = 0;
-	if (digit[0] & SEG_A) mask |= SG2;
-	if (digit[4] & SEG_F) mask |= SG3;
-	if (digit[3] & SEG_A) mask |= SG8;
-	if (digit[1] & SEG_A) mask |= SG9;
-	if (digit[2] & SEG_A) mask |= SG10;
-	matrix[6] = mask;
+	SC1628D_RenderLayout_P(SC1628D_NORMAL_LAYOUT, digit, matrix);
 }
 
-/*
- Inverted segment addressing:
- 
-    [4C]         [3D]                [2D]                    [1D]                [0D]           [4D]        
-  GR7/SG3     +-GR7/SG2-+         +-GR7/SG9-+             +-GR7/SG10+         +-GR7/SG8-+      GR5/SG3
-              |         |         |         |             |         |         |         |
-             [3C]      [3E]      [2C]      [2E]         [1C]       [1E]      [0C]      [0E]
-           GR1/SG2   GR5/SG2   GR1/SG9   GR5/SG9       GR1/SG10  GR5/SG10  GR1/SG8   GR5/SG8 
-    [4B]      |  [3G]   |         |  [2G]   |    [4G]     |  [1G]   |         |  [3G]   |       [4E]  
-  GR4/SG3     +-GR6/SG2-+         +-GR6/SG9-+   GR1/SG3   +-GR6/SG10+         +-GR6/SG8-+      GR5/SG3
-              |         |         |         |             |         |         |         |
-             [3B]      [3F]      [2B]      [2F]         [1B]       [1F]      [0B]      [0F]
-           GR2/SG2   GR4/SG2   GR2/SG9   GR4/SG9       GR2/SG10  GR4/SG10  GR2/SG8   GR4/SG8 
-    [4A]      |  [3A]   |         |  [2A]   |             |  [1A]   |         |  [0A]   |       [4F]  
-  GR3/SG3     +-GR3/SG2-+         +-GR3/SG9-+             +-GR3/SG10+         +-GR3/SG8-+      GR2/SG3
-*/
+#ifndef SC1628D_NO_INVERTED
+// The table is SC1628D_INVERTED_MAP (SC1628D.h)
+const SC1628DLayout SC1628D_INVERTED_LAYOUT PROGMEM = SC1628D_INVERTED_MAP;
 
 void SC1628D_InvertedDisplay(uint8_t digit[], uint16_t matrix[])
 {
-	uint16_t mask;
-
-	// Build GR1
-	mask = 0;
-	if (digit[3] & SEG_C) mask |= SG2;
-	if (digit[4] & SEG_G) mask |= SG3;
-	if (digit[0] & SEG_C) mask |= SG8;
-	if (digit[2] & SEG_C) mask |= SG9;
-	if (digit[1] & SEG_C) mask |= SG10;
-	matrix[0] = mask;
-
-	// Build GR2
-	mask = 0;
-	if (digit[3] & SEG_B) mask |= SG2;
-	if (digit[4] & SEG_F) mask |= SG3;
-	if (digit[0] & SEG_B) mask |= SG8;
-	if (digit[2] & SEG_B) mask |= SG9;
-	if (digit[1] & SEG_B) mask |= SG10;
-	matrix[1] = mask;
-
-	// Build GR3
-	mask = 0;
-	if (digit[3] & SEG_A) mask |= SG2;
-	if (digit[4] & SEG_A) mask |= SG3;
-	if (digit[0] & SEG_A) mask |= SG8;
-	if (digit[2] & SEG_A) mask |= SG9;
-	if (digit[1] & SEG_A) mask |= SG10;
-	matrix[2] = mask;
-
-	// Build GR4
-	mask = 0;
-	if (digit[3] & SEG_F) mask |= SG2;
-	if (digit[4] & SEG_B) mask |= SG3;
-	if (digit[0] & SEG_F) mask |= SG8;
-	if (digit[2] & SEG_F) mask |= SG9;
-	if (digit[1] & SEG_F) mask |= SG10;
-	matrix[3] = mask;
-
-	// Build GR5
-	mask = 0;
-	if (digit[3] & SEG_E) mask |= SG2;
-	if (digit[4] & SEG_D) mask |= SG3;
-	if (digit[0] & SEG_E) mask |= SG8;
-	if (digit[2] & SEG_E) mask |= SG9;
-	if (digit[1] & SEG_E) mask |= SG10;
-	matrix[4] = mask;
-
-	// Build GR6
-	mask = 0;
-	if (digit[3] & SEG_G) mask |= SG2;
-	if (digit[4] & SEG_E) mask |= SG3;
-	if (digit[0] & SEG_G) mask |= SG8;
-	if (digit[2] & SEG_G) mask |= SG9;
-	if (digit[1] & SEG_G) mask |= SG10;
-	matrix[5] = mask;
-
-	// Build GR7
-	mask = 0;
-	if (digit[3] & SEG_D) mask |= SG2;
-	if (digit[4] & SEG_C) mask |= SG3;
-	if (digit[0] & SEG_D) mask |= SG8;
-	if (digit[2] & SEG_D) mask |= SG9;
-	if (digit[1] & SEG_D) mask |= SG10;
-	matrix[6] = mask;
+	SC1628D_RenderLayout_P(SC1628D_INVERTED_LAYOUT, digit, matrix);
+}
+#endif
+
+uint32_t SC1628D_KeyButtons(uint8_t keys, uint8_t index)
+{
+	uint32_t buttons;
+
+	buttons  = (uint32_t)(( (keys & 0x01)       | ((keys & 0x08) >> 2))) << (2*index);       // bit 0 for K1/KS1 and bit 3 for K1/KS2
+	buttons |= (uint32_t)((((keys & 0x02) >> 1) | ((keys & 0x10) >> 3))) << (2*index + 16);  // bit 1 for K2/KS1 and bit 4 for K2/KS2
+	return buttons;
+}
+
+SC1628DTiming SC1628D_ScaleTiming(const SC1628DTiming &timing, uint8_t scale)
+{
+	SC1628DTiming scaled = {
+		(uint16_t)(timing.clockLow * scale), (uint16_t)(timing.clockHigh * scale),
+		(uint16_t)(timing.setup * scale), (uint16_t)(timing.hold * scale),
+		(uint16_t)(timing.strobe * scale), (uint16_t)(timing.wait * scale)
+	};
+	return scaled;
 }
 
 // Segment names
@@ -241,286 +145,327 @@ void SC1628D_InvertedDisplay(uint8_t digit[], uint16_t matrix[])
 //    E     C
 //    v     v
 //     <-D->
-const uint8_t SC1628D_NORMAL_FONT[] = {
-	/* 0 */  SEG_A | SEG_B | SEG_C | SEG_D | SEG_E | SEG_F,
-	/* 1 */  SEG_B | SEG_C,
-	/* 2 */  SEG_A | SEG_B | SEG_G | SEG_E | SEG_D,
-	/* 3 */  SEG_A | SEG_B | SEG_C | SEG_D | SEG_G,
-	/* 4 */  SEG_F | SEG_G | SEG_B | SEG_C,
-	/* 5 */  SEG_A | SEG_F | SEG_G | SEG_C | SEG_D,
-	/* 6 */  SEG_A | SEG_F | SEG_E | SEG_D | SEG_C | SEG_G,
-	/* 7 *//*SEG_F |*/ SEG_A | SEG_B | SEG_C,
-	/* 8 */  SEG_A | SEG_B | SEG_C | SEG_D | SEG_E | SEG_F | SEG_G,
-	/* 9 */  SEG_G | SEG_F | SEG_A | SEG_B | SEG_C | SEG_D,
-	/* A */  SEG_E | SEG_F | SEG_A | SEG_B | SEG_C | SEG_G,
-	/* b */  SEG_F | SEG_E | SEG_D | SEG_C | SEG_G,
-	/* c */  SEG_G | SEG_E | SEG_D,
-	/* d */  SEG_G | SEG_E | SEG_D | SEG_C | SEG_B,
-	/* E */  SEG_A | SEG_F | SEG_E | SEG_D | SEG_G,
-	/* F */  SEG_A | SEG_F | SEG_E | SEG_G,
-	/*   */  0,								// DIGIT_BLANK
-	/* - */  SEG_G,							// DIGIT_MINUS
-	/* ° */  SEG_A | SEG_B | SEG_G | SEG_F,	// DIGIT_DEGRE
-	/* C */  SEG_A | SEG_F | SEG_E | SEG_D,	// DIGIT_C
-	/* ? */  SEG_A | SEG_B | SEG_G | SEG_E,	// DIGIT_QUESTION
+// The inverted fonts are the normal ones turned by 180 degrees, with SC1628D_ROT180
+#define SC1628D_GLYPH(segments)         (segments),
+#define SC1628D_GLYPH_ROT180(segments)  SC1628D_ROT180(segments),
+
+#define SC1628D_DIGIT_GLYPHS(GLYPH) \
+	/* 0 */  GLYPH(SEG_A | SEG_B | SEG_C | SEG_D | SEG_E | SEG_F) \
+	/* 1 */  GLYPH(SEG_B | SEG_C) \
+	/* 2 */  GLYPH(SEG_A | SEG_B | SEG_G | SEG_E | SEG_D) \
+	/* 3 */  GLYPH(SEG_A | SEG_B | SEG_C | SEG_D | SEG_G) \
+	/* 4 */  GLYPH(SEG_F | SEG_G | SEG_B | SEG_C) \
+	/* 5 */  GLYPH(SEG_A | SEG_F | SEG_G | SEG_C | SEG_D) \
+	/* 6 */  GLYPH(SEG_A | SEG_F | SEG_E | SEG_D | SEG_C | SEG_G) \
+	/* 7 */  GLYPH(SEG_A | SEG_B | SEG_C) \
+	/* 8 */  GLYPH(SEG_A | SEG_B | SEG_C | SEG_D | SEG_E | SEG_F | SEG_G) \
+	/* 9 */  GLYPH(SEG_G | SEG_F | SEG_A | SEG_B | SEG_C | SEG_D) \
+	/* A */  GLYPH(SEG_E | SEG_F | SEG_A | SEG_B | SEG_C | SEG_G) \
+	/* b */  GLYPH(SEG_F | SEG_E | SEG_D | SEG_C | SEG_G) \
+	/* c */  GLYPH(SEG_G | SEG_E | SEG_D) \
+	/* d */  GLYPH(SEG_G | SEG_E | SEG_D | SEG_C | SEG_B) \
+	/* E */  GLYPH(SEG_A | SEG_F | SEG_E | SEG_D | SEG_G) \
+	/* F */  GLYPH(SEG_A | SEG_F | SEG_E | SEG_G) \
+	/*   */  GLYPH(0)								/* DIGIT_BLANK */ \
+	/* - */  GLYPH(SEG_G)							/* DIGIT_MINUS */ \
+	/* ° */  GLYPH(SEG_A | SEG_B | SEG_G | SEG_F)	/* DIGIT_DEGRE */ \
+	/* C */  GLYPH(SEG_A | SEG_F | SEG_E | SEG_D)	/* DIGIT_C */ \
+	/* ? */  GLYPH(SEG_A | SEG_B | SEG_G | SEG_E)	/* DIGIT_QUESTION */
+
+const uint8_t SC1628D_NORMAL_FONT[] PROGMEM = {
+	SC1628D_DIGIT_GLYPHS(SC1628D_GLYPH)
+};
+
+#ifndef SC1628D_NO_INVERTED
+const uint8_t SC1628D_INVERTED_FONT[] PROGMEM = {
+	SC1628D_DIGIT_GLYPHS(SC1628D_GLYPH_ROT180)
+};
+#endif
+
+// Printable ASCII characters, from ' ' to '~'. The letters have a single
+// shape, upper or lower case, the one the segments can draw. '.' and ':'
+// light the colon (displayText), the characters without a shape are blank.
+#define SC1628D_ASCII_GLYPHS(GLYPH) \
+	/*   */  GLYPH(0) \
+	/* ! */  GLYPH(SEG_B | SEG_C) \
+	/* " */  GLYPH(SEG_B | SEG_F) \
+	/* # */  GLYPH(0) \
+	/* $ */  GLYPH(SEG_A | SEG_F | SEG_G | SEG_C | SEG_D) \
+	/* % */  GLYPH(0) \
+	/* & */  GLYPH(0) \
+	/* ' */  GLYPH(SEG_B) \
+	/* ( */  GLYPH(SEG_A | SEG_F | SEG_E | SEG_D) \
+	/* ) */  GLYPH(SEG_A | SEG_B | SEG_C | SEG_D) \
+	/* * */  GLYPH(0) \
+	/* + */  GLYPH(0) \
+	/* , */  GLYPH(SEG_C) \
+	/* - */  GLYPH(SEG_G) \
+	/* . */  GLYPH(0) \
+	/* / */  GLYPH(SEG_B | SEG_G | SEG_E) \
+	/* 0 */  GLYPH(SEG_A | SEG_B | SEG_C | SEG_D | SEG_E | SEG_F) \
+	/* 1 */  GLYPH(SEG_B | SEG_C) \
+	/* 2 */  GLYPH(SEG_A | SEG_B | SEG_G | SEG_E | SEG_D) \
+	/* 3 */  GLYPH(SEG_A | SEG_B | SEG_C | SEG_D | SEG_G) \
+	/* 4 */  GLYPH(SEG_F | SEG_G | SEG_B | SEG_C) \
+	/* 5 */  GLYPH(SEG_A | SEG_F | SEG_G | SEG_C | SEG_D) \
+	/* 6 */  GLYPH(SEG_A | SEG_F | SEG_E | SEG_D | SEG_C | SEG_G) \
+	/* 7 */  GLYPH(SEG_A | SEG_B | SEG_C) \
+	/* 8 */  GLYPH(SEG_A | SEG_B | SEG_C | SEG_D | SEG_E | SEG_F | SEG_G) \
+	/* 9 */  GLYPH(SEG_G | SEG_F | SEG_A | SEG_B | SEG_C | SEG_D) \
+	/* : */  GLYPH(0) \
+	/* ; */  GLYPH(0) \
+	/* < */  GLYPH(SEG_G | SEG_E | SEG_D) \
+	/* = */  GLYPH(SEG_G | SEG_D) \
+	/* > */  GLYPH(SEG_G | SEG_C | SEG_D) \
+	/* ? */  GLYPH(SEG_A | SEG_B | SEG_G | SEG_E) \
+	/* @ */  GLYPH(SEG_A | SEG_B | SEG_C | SEG_D | SEG_E | SEG_G) \
+	/* A */  GLYPH(SEG_E | SEG_F | SEG_A | SEG_B | SEG_C | SEG_G) \
+	/* b */  GLYPH(SEG_F | SEG_E | SEG_D | SEG_C | SEG_G) \
+	/* C */  GLYPH(SEG_A | SEG_F | SEG_E | SEG_D) \
+	/* d */  GLYPH(SEG_G | SEG_E | SEG_D | SEG_C | SEG_B) \
+	/* E */  GLYPH(SEG_A | SEG_F | SEG_E | SEG_D | SEG_G) \
+	/* F */  GLYPH(SEG_A | SEG_F | SEG_E | SEG_G) \
+	/* G */  GLYPH(SEG_A | SEG_F | SEG_E | SEG_D | SEG_C) \
+	/* H */  GLYPH(SEG_F | SEG_E | SEG_G | SEG_B | SEG_C) \
+	/* I */  GLYPH(SEG_F | SEG_E) \
+	/* J */  GLYPH(SEG_B | SEG_C | SEG_D | SEG_E) \
+	/* K */  GLYPH(SEG_F | SEG_E | SEG_G | SEG_A | SEG_C) \
+	/* L */  GLYPH(SEG_F | SEG_E | SEG_D) \
+	/* M */  GLYPH(SEG_A | SEG_E | SEG_C) \
+	/* n */  GLYPH(SEG_E | SEG_G | SEG_C) \
+	/* o */  GLYPH(SEG_G | SEG_E | SEG_D | SEG_C) \
+	/* P */  GLYPH(SEG_E | SEG_F | SEG_A | SEG_B | SEG_G) \
+	/* q */  GLYPH(SEG_A | SEG_B | SEG_F | SEG_G | SEG_C) \
+	/* r */  GLYPH(SEG_E | SEG_G) \
+	/* S */  GLYPH(SEG_A | SEG_F | SEG_G | SEG_C | SEG_D) \
+	/* t */  GLYPH(SEG_F | SEG_E | SEG_D | SEG_G) \
+	/* U */  GLYPH(SEG_F | SEG_E | SEG_D | SEG_C | SEG_B) \
+	/* v */  GLYPH(SEG_E | SEG_D | SEG_C) \
+	/* W */  GLYPH(SEG_F | SEG_D | SEG_B) \
+	/* X */  GLYPH(SEG_F | SEG_E | SEG_G | SEG_B | SEG_C) \
+	/* y */  GLYPH(SEG_F | SEG_G | SEG_B | SEG_C | SEG_D) \
+	/* Z */  GLYPH(SEG_A | SEG_B | SEG_G | SEG_E | SEG_D) \
+	/* [ */  GLYPH(SEG_A | SEG_F | SEG_E | SEG_D) \
+	/* \ */  GLYPH(SEG_F | SEG_G | SEG_C) \
+	/* ] */  GLYPH(SEG_A | SEG_B | SEG_C | SEG_D) \
+	/* ^ */  GLYPH(SEG_F | SEG_A | SEG_B) \
+	/* _ */  GLYPH(SEG_D) \
+	/* ` */  GLYPH(SEG_F) \
+	/* a */  GLYPH(SEG_E | SEG_F | SEG_A | SEG_B | SEG_C | SEG_G) \
+	/* b */  GLYPH(SEG_F | SEG_E | SEG_D | SEG_C | SEG_G) \
+	/* c */  GLYPH(SEG_G | SEG_E | SEG_D) \
+	/* d */  GLYPH(SEG_G | SEG_E | SEG_D | SEG_C | SEG_B) \
+	/* e */  GLYPH(SEG_A | SEG_F | SEG_E | SEG_D | SEG_G) \
+	/* f */  GLYPH(SEG_A | SEG_F | SEG_E | SEG_G) \
+	/* g */  GLYPH(SEG_A | SEG_F | SEG_E | SEG_D | SEG_C) \
+	/* h */  GLYPH(SEG_F | SEG_E | SEG_G | SEG_C) \
+	/* i */  GLYPH(SEG_E) \
+	/* j */  GLYPH(SEG_B | SEG_C | SEG_D) \
+	/* k */  GLYPH(SEG_F | SEG_E | SEG_G | SEG_A | SEG_C) \
+	/* l */  GLYPH(SEG_F | SEG_E) \
+	/* m */  GLYPH(SEG_A | SEG_E | SEG_C) \
+	/* n */  GLYPH(SEG_E | SEG_G | SEG_C) \
+	/* o */  GLYPH(SEG_G | SEG_E | SEG_D | SEG_C) \
+	/* p */  GLYPH(SEG_E | SEG_F | SEG_A | SEG_B | SEG_G) \
+	/* q */  GLYPH(SEG_A | SEG_B | SEG_F | SEG_G | SEG_C) \
+	/* r */  GLYPH(SEG_E | SEG_G) \
+	/* s */  GLYPH(SEG_A | SEG_F | SEG_G | SEG_C | SEG_D) \
+	/* t */  GLYPH(SEG_F | SEG_E | SEG_D | SEG_G) \
+	/* u */  GLYPH(SEG_E | SEG_D | SEG_C) \
+	/* v */  GLYPH(SEG_E | SEG_D | SEG_C) \
+	/* w */  GLYPH(SEG_F | SEG_D | SEG_B) \
+	/* x */  GLYPH(SEG_F | SEG_E | SEG_G | SEG_B | SEG_C) \
+	/* y */  GLYPH(SEG_F | SEG_G | SEG_B | SEG_C | SEG_D) \
+	/* z */  GLYPH(SEG_A | SEG_B | SEG_G | SEG_E | SEG_D) \
+	/* { */  GLYPH(SEG_A | SEG_F | SEG_E | SEG_D) \
+	/* | */  GLYPH(SEG_F | SEG_E) \
+	/* } */  GLYPH(SEG_A | SEG_B | SEG_C | SEG_D) \
+	/* ~ */  GLYPH(SEG_A)
+
+const uint8_t SC1628D_ASCII_FONT[] PROGMEM = {
+	SC1628D_ASCII_GLYPHS(SC1628D_GLYPH)
 };
 
-const uint8_t SC1628D_INVERTED_FONT[] = {
-	/* 0 */  SEG_A | SEG_B | SEG_C | SEG_D | SEG_E | SEG_F,
-	/* 1 */  SEG_E | SEG_F,
-	/* 2 */  SEG_A | SEG_B | SEG_G | SEG_E | SEG_D,
-	/* 3 */  SEG_A | SEG_F | SEG_E | SEG_D | SEG_G,
-	/* 4 */  SEG_C | SEG_G | SEG_F | SEG_E,
-	/* 5 */  SEG_A | SEG_F | SEG_G | SEG_C | SEG_D,
-	/* 6 */  SEG_D | SEG_E | SEG_F | SEG_A | SEG_B | SEG_G,
-	/* 7 */  SEG_D | SEG_E | SEG_F,
-	/* 8 */  SEG_A | SEG_B | SEG_C | SEG_D | SEG_E | SEG_F | SEG_G,
-	/* 9 */  SEG_G | SEG_C | SEG_D | SEG_E | SEG_F | SEG_A,
-	/* A */  SEG_B | SEG_C | SEG_D | SEG_E | SEG_F | SEG_G,
-	/* b */  SEG_C | SEG_B | SEG_A | SEG_F | SEG_G,
-	/* c */  SEG_G | SEG_B | SEG_A,
-	/* d */  SEG_G | SEG_B | SEG_A | SEG_F | SEG_D,
-	/* E */  SEG_D | SEG_C | SEG_B | SEG_A | SEG_G,
-	/* F */  SEG_D | SEG_D | SEG_B | SEG_G,
-	/*   */  0,								// DIGIT_BLANK
-	/* - */  SEG_G,							// DIGIT_MINUS
-	/* ° */  SEG_D | SEG_C | SEG_G | SEG_E,	// DIGIT_DEGRE
-	/* C */  SEG_D | SEG_C | SEG_B | SEG_A,	// DIGIT_C
-	/* ? */  SEG_D | SEG_E | SEG_G | SEG_B,	// DIGIT_QUESTION
+#ifndef SC1628D_NO_INVERTED
+const uint8_t SC1628D_INVERTED_ASCII_FONT[] PROGMEM = {
+	SC1628D_ASCII_GLYPHS(SC1628D_GLYPH_ROT180)
 };
+#endif
 
 
 //-----------------------------------------------------------------
 
 
-SC1628D::SC1628D(uint8_t pinSTB, uint8_t pinCLK, uint8_t pinDIO, unsigned int bitDelay)
+SC1628DPinBus::SC1628DPinBus(uint8_t pinSTB, uint8_t pinCLK, uint8_t pinDIO, unsigned int bitDelay)
+	: m_bitBang(pinSTB, pinCLK, pinDIO, bitDelay)
 {
-	m_font = SC1628D_NORMAL_FONT;
-	m_filter = &SC1628D_NormalDisplay;
-
-	// Copy the pin numbers
-	m_pinSTB = pinSTB;
-	m_pinCLK = pinCLK;
-	m_pinDIO = pinDIO;
-	m_bitDelay = bitDelay;
-
-	// Set the pin direction and default value.
-	// Both pins are set as inputs, allowing the pull-up resistors to pull them up
-    pinMode(m_pinSTB, OUTPUT);
-    pinMode(m_pinCLK, OUTPUT);
-    pinMode(m_pinDIO, OUTPUT);
-	digitalWrite(m_pinSTB, HIGH);
-	digitalWrite(m_pinCLK, HIGH);
-	digitalWrite(m_pinDIO, HIGH);
 }
 
-
-void SC1628D::clear()
+SC1628D::SC1628D(uint8_t pinSTB, uint8_t pinCLK, uint8_t pinDIO, unsigned int bitDelay)
+	: SC1628DPinBus(pinSTB, pinCLK, pinDIO, bitDelay), SC1628DDriver(m_bitBang)
 {
-    uint8_t data[] = { 0, 0, 0, 0, 0};
-	displayDigits(data);
 }
 
-void SC1628D::setBrightness(uint8_t brightness, bool on)
+SC1628DKeypad::SC1628DKeypad()
 {
-	m_brightness = (brightness & 0x7) | (on? 0x08 : 0x00);
+	m_interval = 0;
+	m_held = 0xff;
+	m_state = 0;
+	m_head = 0;
+	m_tail = 0;
+	setTiming(SC1628D_KEY_DEBOUNCE, SC1628D_KEY_LONG_MS, SC1628D_KEY_REPEAT_MS);
 }
 
-void SC1628D::setFont(uint8_t font[])
+void SC1628DKeypad::setTiming(uint8_t debounce, uint16_t longPress, uint16_t repeat)
 {
-	m_font = font;
+	m_debounce = debounce ? debounce : 1;
+	m_long = longPress;
+	m_repeat = repeat;
 }
 
-void SC1628D::setFilter(void (*aFilterFunction)(uint8_t digit[], uint16_t matrix[]))
+void SC1628DKeypad::queue(uint8_t type, uint8_t key)
 {
-	m_filter = aFilterFunction;
+	uint8_t head = (m_head + 1) & (SC1628D_KEY_QUEUE_SIZE - 1);
+
+	// Queue full: the event is lost
+	if (head == m_tail)
+		return;
+	m_queue[m_head].type = type;
+	m_queue[m_head].key = key;
+	m_head = head;
 }
 
-void SC1628D::displayDigit(const uint8_t digit, uint8_t pos)
+SC1628DMarquee::SC1628DMarquee()
 {
-	m_segments[pos] = m_font[digit];
-	displaySegments(m_segments);
+	m_interval = 0;
 }
 
-void SC1628D::displayDigits(const uint8_t digits[], uint8_t pos, uint8_t length)
+SC1628DAnimation::SC1628DAnimation()
 {
-	for (uint8_t i = 0; i < length; i++) {
-		m_segments[pos++] = m_font[digits[i]];
-	}
-	displaySegments(m_segments);
+	m_frames = NULL;
 }
 
-void SC1628D::displaySegment(const uint8_t segment, uint8_t pos)
+SC1628DDimmer::SC1628DDimmer()
 {
-	m_segments[pos] = segment;
-    displaySegments(m_segments);
+	memset(m_level, SC1628D_DIM_LEVELS, sizeof(m_level));
+	m_dimmed = 0;
+	m_phase = 0;
+	m_lit = 0x1f;
+	m_period = SC1628D_DIM_PERIOD_US;
+	m_time = 0;
 }
 
-void SC1628D::displaySegments(const uint8_t segments[], uint8_t pos, uint8_t length)
+SC1628DBlinker::SC1628DBlinker()
 {
-	uint16_t matrix[7];
-
-	if (segments != m_segments)
-		for (uint8_t i = 0; i < length; i++) 
-			m_segments[pos++] = segments[i];
-	m_filter(m_segments, matrix);
-	writeMatrix(matrix);
-
-	// Command 1: Set display mode (default: 7 grids - 11 segments)
-	start();
-	writeCommand(SC1628D_DISPLAY_MODE_CMD + SC1628D_7GRID_11SEG);
-	stop();
-
-	// Command 4: Set Display on/off + Brightness
-	start();
-	writeCommand(SC1628D_DISPLAY_CONTROL_CMD + (m_brightness & 0x0f));
-	stop();
+	memset(m_segments, 0, sizeof(m_segments));
+	m_positions = 0;
+	m_off = false;
+	m_time = 0;
+	setRate(SC1628D_BLINK_PERIOD_MS, SC1628D_BLINK_DUTY);
 }
 
-uint32_t SC1628D::getButtons(void)
+void SC1628DBlinker::setRate(uint16_t period, uint8_t duty)
 {
-	// Keyscan data on the SC1628 is 2x10 keys, received as an array of 5 bytes (same as TM1668).
-	// Of each byte the bits B0/B3 and B1/B4 represent status of the connection of K1 and K2 to KS1-KS10
-	// Byte1[0-1]: KS1xK1, KS1xK2
-	// The return value is a 32 bit value containing button scans for both K1 and K2, the high word is for K2 and the low word for K1.
-	uint8_t keys;
-	uint32_t buttons = 0;
-
-	start();
-	writeCommand(SC1628D_DATA_SETTING_CMD_READ);		// send read buttons command
-	for (int i = 0; i < 5; i++) {
-		keys = receiveData();
-		buttons |= (( (keys & 0x01)       | ((keys & 0x08) >> 2)) << (2*i));       // bit 0 for K1/KS1 and bit 3 for K1/KS2
-		buttons |= ((((keys & 0x02) >> 1) | ((keys & 0x10) >> 3)) << (2*i + 16));  // bit 1 for K2/KS1 and bit 4 for K2/KS2
-	}
-	stop();
-	return buttons;
+	if (period < 2)
+		period = 2;
+	if (duty < 1)
+		duty = 1;
+	if (duty > 99)
+		duty = 99;
+	m_period = period;
+	m_on = (uint32_t)period * duty / 100;
+	if (m_on == 0)
+		m_on = 1;
+	if (m_on >= period)
+		m_on = period - 1;
 }
 
 
-//-----------------------------------------------------------------
-
-
-void SC1628D::bitDelay()
+SC1628DRuntimeRender::SC1628DRuntimeRender()
 {
-	delayMicroseconds(m_bitDelay);
+	m_font = SC1628D_NORMAL_FONT;
+	m_fontFlash = true;
+	m_ascii = SC1628D_ASCII_FONT;
+	m_filter = &SC1628D_NormalDisplay;
+	m_layout = &SC1628D_NORMAL_LAYOUT;
+	m_layoutFlash = true;
 }
 
-void SC1628D::start()
+void SC1628DRuntimeRender::setFont(const uint8_t font[])
 {
-	digitalWrite(m_pinSTB, LOW);
-	bitDelay();
+	// The built-in fonts are in flash memory
+#ifndef SC1628D_NO_INVERTED
+	if (font == SC1628D_INVERTED_FONT) {
+		setFont_P(font);
+		return;
+	}
+#endif
+	if (font == SC1628D_NORMAL_FONT) {
+		setFont_P(font);
+		return;
+	}
+	m_font = font;
+	m_fontFlash = false;
+	m_ascii = SC1628D_ASCII_FONT;
 }
 
-void SC1628D::stop()
+void SC1628DRuntimeRender::setFont_P(const uint8_t font[])
 {
-	digitalWrite(m_pinSTB, HIGH);
-	bitDelay();
+	m_font = font;
+	m_fontFlash = true;
+#ifndef SC1628D_NO_INVERTED
+	if (font == SC1628D_INVERTED_FONT) {
+		m_ascii = SC1628D_INVERTED_ASCII_FONT;
+		return;
+	}
+#endif
+	m_ascii = SC1628D_ASCII_FONT;
 }
 
-void SC1628D::writeCommand(uint8_t b)
+void SC1628DRuntimeRender::setFilter(void (*aFilterFunction)(uint8_t digit[], uint16_t matrix[]))
 {
-	uint8_t data = b;
-
-	// 8 Data Bits
-	for(uint8_t i = 0; i < 8; i++) 
-	{
-		// CLK low
-		digitalWrite(m_pinCLK, LOW);
-
-		// Set data bit
-		if (data & 0x01)
-			digitalWrite(m_pinDIO, HIGH);
-		else
-			digitalWrite(m_pinDIO, LOW);
-
-		bitDelay();
-
-		// CLK high
-		digitalWrite(m_pinCLK, HIGH);
-		bitDelay();
-
-		data = data >> 1;
+	// The default filters are table driven
+	if (aFilterFunction == &SC1628D_NormalDisplay)
+		setLayout_P(SC1628D_NORMAL_LAYOUT);
+#ifndef SC1628D_NO_INVERTED
+	else if (aFilterFunction == &SC1628D_InvertedDisplay)
+		setLayout_P(SC1628D_INVERTED_LAYOUT);
+#endif
+	else {
+		m_filter = aFilterFunction;
+		m_layout = NULL;
 	}
-	bitDelay();
 }
 
-void SC1628D::writeData(uint16_t b)
+void SC1628DRuntimeRender::setLayout(const SC1628DLayout &layout)
 {
-	uint16_t data = b;
-
-	// 8 Data Bits
-	for(uint8_t i = 0; i < 16; i++) 
-	{
-		// CLK low
-		digitalWrite(m_pinCLK, LOW);
-
-		// Set data bit
-		if (data & 0x01)
-			digitalWrite(m_pinDIO, HIGH);
-		else
-			digitalWrite(m_pinDIO, LOW);
-
-		bitDelay();
-
-		// CLK high
-		digitalWrite(m_pinCLK, HIGH);
-		bitDelay();
-
-		data = data >> 1;
+	// The built-in layouts are in flash memory
+#ifndef SC1628D_NO_INVERTED
+	if (&layout == &SC1628D_INVERTED_LAYOUT) {
+		setLayout_P(layout);
+		return;
 	}
-	bitDelay();
+#endif
+	if (&layout == &SC1628D_NORMAL_LAYOUT) {
+		setLayout_P(layout);
+		return;
+	}
+	m_filter = NULL;
+	m_layout = &layout;
+	m_layoutFlash = false;
 }
 
-void SC1628D::writeMatrix(const uint16_t matrix[])
+void SC1628DRuntimeRender::setLayout_P(const SC1628DLayout &layout)
 {
-    // Command 2: Set Write data to display, in incremental mode
-	start();
-	writeCommand(SC1628D_DATA_SETTING_CMD_WRITE);
-	stop();
-
-	// Command 3: Set write address + digits data
-	start();
-	writeCommand(SC1628D_ADDRESS_SETTING_CMD);
-
-	// Write the data bytes
-	for (uint8_t k = 0; k < 7; k++)
-    {
-		writeData(matrix[k]);
-    }
-	stop();
+	m_filter = NULL;
+	m_layout = &layout;
+	m_layoutFlash = true;
 }
 
-uint8_t SC1628D::receiveData()
-{
-	uint8_t temp = 0;
-
-	// Pull-up on
-//    pinMode(m_pinDIO, INPUT);
-//	digitalWrite(m_pinDIO, HIGH);
-    pinMode(m_pinDIO, INPUT_PULLUP);
-
-	for (int i = 0; i < 8; i++) {
-		temp >>= 1;
-
-		// CLK low
-		digitalWrite(m_pinCLK, LOW);
-
-		bitDelay();
-
-		if (digitalRead(m_pinDIO)) {
-			temp |= 0x80;
-		}
+// The driver functions are in SC1628DCore.h, instantiated here for SC1628DDriver
+template class SC1628DCore<SC1628DTransportBus, SC1628DRuntimeRender>;
 
-		// CLK high
-		digitalWrite(m_pinCLK, HIGH);
-		bitDelay();
-	}
-
-	// Pull-up off
-	pinMode(m_pinDIO, OUTPUT);
-//	digitalWrite(m_pinDIO, LOW);
-
-	return temp;
+SC1628DDriver::SC1628DDriver(SC1628DTransport &transport)
+	: SC1628DCore<SC1628DTransportBus, SC1628DRuntimeRender>(SC1628DTransportBus(transport))
+{
 }
-
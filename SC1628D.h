@@ -24,6 +24,19 @@
 #define __SC1628D__
 
 #include <inttypes.h>
+#include <SC1628DTransport.h>
+#include <SC1628DMailbox.h>
+#include <SC1628DWaveform.h>
+
+// Uncomment, or define in the build flags, to enable the performance counters (getStats)
+// #define SC1628D_STATS
+
+// Uncomment, or define in the build flags, to record the bus transactions (dumpTrace)
+// #define SC1628D_TRACE
+
+// Uncomment, or define in the build flags, to leave out the inverted font and layout
+// (SC1628D_INVERTED_FONT, SC1628D_INVERTED_LAYOUT and SC1628D_InvertedDisplay)
+// #define SC1628D_NO_INVERTED
 
 #define SG1     0x001
 #define SG2     0x002
@@ -38,6 +51,15 @@
 #define SG11    0x400
 #define SG12    0x800
 
+// Grid index in the matrix
+#define GR1     0
+#define GR2     1
+#define GR3     2
+#define GR4     3
+#define GR5     4
+#define GR6     5
+#define GR7     6
+
 #define SEG_A   0b00000001
 #define SEG_B   0b00000010
 #define SEG_C   0b00000100
@@ -45,6 +67,9 @@
 #define SEG_E   0b00010000
 #define SEG_F   0b00100000
 #define SEG_G   0b01000000
+
+// A segments mask turned by 180 degrees: A and D, B and E, C and F swapped
+#define SC1628D_ROT180(segments) ((((segments) & 0x07) << 3) | (((segments) >> 3) & 0x07) | ((segments) & SEG_G))
   
 #define DIGIT_BLANK             16
 #define DIGIT_MINUS             17
@@ -52,40 +77,434 @@
 #define DIGIT_C                 19
 #define DIGIT_QUESTION          20
 
-#define SC1628D_BIT_DELAY        5
+// Symbols of the position 4
+#define SC1628D_SYM_POS          4
+#define SC1628D_SYM_COLON        SEG_G		// Between the digits 1 and 2
+
+// Number of digits used by displayNumber(), displayFixed() and displayHex()
+#define SC1628D_NUMBER_DIGITS    4
 
 #define SC1628D_6GRID_12SEG      2
 #define SC1628D_7GRID_11SEG      3
 #define SC1628D_2_FIXED_ADDR     4
 #define SC1628D_2_INCREMENT_ADDR 0
 
+#define SC1628D_DISPLAY_MODE_CMD       0x00
+#define SC1628D_DATA_SETTING_CMD_WRITE 0x40
+#define SC1628D_DATA_SETTING_CMD_READ  0x42
+#define SC1628D_DISPLAY_CONTROL_CMD    0x80
+#define SC1628D_ADDRESS_SETTING_CMD    0xC0
+
+// Above this number of modified RAM bytes, a full incremental burst is cheaper
+// than one fixed address transaction per byte (16 bits each versus 128 bits).
+#define SC1628D_DELTA_MAX_BYTES        7
+
+// Number of bytes sent by each tick() call in asynchronous mode
+#define SC1628D_TICK_BYTES       2
+
+// Key scan lines mask (setKeyScan), KS1 to KS10
+#define SC1628D_KS(n)            (1 << ((n) - 1))
+#define SC1628D_KS_ALL           0x3ff
+
+// Key events
+#define SC1628D_KEY_PRESS        0
+#define SC1628D_KEY_RELEASE      1
+#define SC1628D_KEY_LONG         2		// Still pressed after the long press delay
+#define SC1628D_KEY_REPEAT       3		// Still pressed, after each repeat period
+
+// Key event queue size, a power of 2
+#define SC1628D_KEY_QUEUE_SIZE   8
 
-// Default charaters definition
+#define SC1628D_KEY_DEBOUNCE     3		// Identical scans needed to accept a change
+#define SC1628D_KEY_LONG_MS      800
+#define SC1628D_KEY_REPEAT_MS    200
+
+// Bits of the key bytes not connected to keys, always 0
+#define SC1628D_KEY_UNUSED_BITS  0xe4
+
+// calibrate(): slowest setting tried (datasheet timings x 16), and key scans per setting
+#define SC1628D_CALIBRATE_SCALE  16
+#define SC1628D_CALIBRATE_SCANS  8
+
+// Animation modes
+#define SC1628D_ANIM_ONCE        0		// Stops on the last frame
+#define SC1628D_ANIM_LOOP        1		// Restarts from the first frame
+#define SC1628D_ANIM_PINGPONG    2		// Plays forward then backward
+
+// Bus trace: ring buffer size in bytes, each transaction takes 7 bytes plus its bytes
+#ifndef SC1628D_TRACE_SIZE
+	#define SC1628D_TRACE_SIZE   256
+#endif
+#define SC1628D_TRACE_BYTES      16		// Bytes recorded per transaction, the others are dropped
+
+// Per position intensity: sub-frames per dimming cycle, also the full intensity level
+#define SC1628D_DIM_LEVELS       4
+#define SC1628D_DIM_PERIOD_US    2500		// Sub-frame period: 100 Hz cycles
+
+#define SC1628D_BLINK_PERIOD_MS  500
+#define SC1628D_BLINK_DUTY       50			// Percent of the period lit
+
+// Bus transaction program: one byte per entry, a transaction ending where
+// the next one starts (at most 32 entries)
+#define SC1628D_TXN_SIZE         18
+#define SC1628D_OP_START         0x100		// STB low before the byte
+#if SC1628D_TXN_SIZE > 32
+#error "SC1628D_TXN_SIZE: the transaction starts are a 32-bit mask"
+#endif
+
+
+// Where a segment is wired: its grid (GR1-GR7) and segment line (SG1-SG12)
+struct SC1628DSegmentMap {
+	uint8_t grid;
+	uint16_t mask;
+};
+
+// Description of a display wiring: the place of the segments A to G of the 5 positions
+struct SC1628DLayout {
+	SC1628DSegmentMap map[5][7];
+};
+
+// The tables of the built-in layouts, shared by their copies in flash memory
+// and the compile-time layouts of SC1628DStatic.h
+
+/*
+ Normal segment addressing:
+ 
+    [4F]         [0A]                [1A]                    [2A]                [3A]           [4A]        
+  GR7/SG3     +-GR7/SG2-+         +-GR7/SG9-+             +-GR7/SG10+         +-GR7/SG8-+      GR5/SG3
+              |         |         |         |             |         |         |         |
+             [0F]      [0B]      [1F]      [1B]         [2F]       [2B]      [3F]      [3B]
+           GR1/SG2   GR5/SG2   GR1/SG9   GR5/SG9       GR1/SG10  GR5/SG10  GR1/SG8   GR5/SG8 
+    [4E]      |  [0G]   |         |  [1G]   |    [4G]     |  [2G]   |         |  [3G]   |       [4B]  
+  GR4/SG3     +-GR6/SG2-+         +-GR6/SG9-+   GR1/SG3   +-GR6/SG10+         +-GR6/SG8-+      GR5/SG3
+              |         |         |         |             |         |         |         |
+             [0E]      [0C]      [1E]      [1C]         [2E]       [2C]      [3E]      [3C]
+           GR2/SG2   GR4/SG2   GR2/SG9   GR4/SG9       GR2/SG10  GR4/SG10  GR2/SG8   GR4/SG8 
+    [4D]      |  [0D]   |         |  [1D]   |             |  [2D]   |         |  [3D]   |       [4C]  
+  GR3/SG3     +-GR3/SG2-+         +-GR3/SG9-+             +-GR3/SG10+         +-GR3/SG8-+      GR2/SG3
+
+*/
+#define SC1628D_NORMAL_MAP {{ \
+	/*  A            B            C            D            E            F            G */ \
+	{ {GR7, SG2},  {GR5, SG2},  {GR4, SG2},  {GR3, SG2},  {GR2, SG2},  {GR1, SG2},  {GR6, SG2} },	/* Position 0 */ \
+	{ {GR7, SG9},  {GR5, SG9},  {GR4, SG9},  {GR3, SG9},  {GR2, SG9},  {GR1, SG9},  {GR6, SG9} },	/* Position 1 */ \
+	{ {GR7, SG10}, {GR5, SG10}, {GR4, SG10}, {GR3, SG10}, {GR2, SG10}, {GR1, SG10}, {GR6, SG10} },	/* Position 2 */ \
+	{ {GR7, SG8},  {GR5, SG8},  {GR4, SG8},  {GR3, SG8},  {GR2, SG8},  {GR1, SG8},  {GR6, SG8} },	/* Position 3 */ \
+	{ {GR5, SG3},  {GR6, SG3},  {GR2, SG3},  {GR3, SG3},  {GR4, SG3},  {GR7, SG3},  {GR1, SG3} },	/* Position 4 */ \
+}}
+
+/*
+ Inverted segment addressing:
+ 
+    [4C]         [3D]                [2D]                    [1D]                [0D]           [4D]        
+  GR7/SG3     +-GR7/SG2-+         +-GR7/SG9-+             +-GR7/SG10+         +-GR7/SG8-+      GR5/SG3
+              |         |         |         |             |         |         |         |
+             [3C]      [3E]      [2C]      [2E]         [1C]       [1E]      [0C]      [0E]
+           GR1/SG2   GR5/SG2   GR1/SG9   GR5/SG9       GR1/SG10  GR5/SG10  GR1/SG8   GR5/SG8 
+    [4B]      |  [3G]   |         |  [2G]   |    [4G]     |  [1G]   |         |  [3G]   |       [4E]  
+  GR4/SG3     +-GR6/SG2-+         +-GR6/SG9-+   GR1/SG3   +-GR6/SG10+         +-GR6/SG8-+      GR5/SG3
+              |         |         |         |             |         |         |         |
+             [3B]      [3F]      [2B]      [2F]         [1B]       [1F]      [0B]      [0F]
+           GR2/SG2   GR4/SG2   GR2/SG9   GR4/SG9       GR2/SG10  GR4/SG10  GR2/SG8   GR4/SG8 
+    [4A]      |  [3A]   |         |  [2A]   |             |  [1A]   |         |  [0A]   |       [4F]  
+  GR3/SG3     +-GR3/SG2-+         +-GR3/SG9-+             +-GR3/SG10+         +-GR3/SG8-+      GR2/SG3
+*/
+#define SC1628D_INVERTED_MAP {{ \
+	/*  A            B            C            D            E            F            G */ \
+	{ {GR3, SG8},  {GR2, SG8},  {GR1, SG8},  {GR7, SG8},  {GR5, SG8},  {GR4, SG8},  {GR6, SG8} },	/* Position 0 */ \
+	{ {GR3, SG10}, {GR2, SG10}, {GR1, SG10}, {GR7, SG10}, {GR5, SG10}, {GR4, SG10}, {GR6, SG10} },	/* Position 1 */ \
+	{ {GR3, SG9},  {GR2, SG9},  {GR1, SG9},  {GR7, SG9},  {GR5, SG9},  {GR4, SG9},  {GR6, SG9} },	/* Position 2 */ \
+	{ {GR3, SG2},  {GR2, SG2},  {GR1, SG2},  {GR7, SG2},  {GR5, SG2},  {GR4, SG2},  {GR6, SG2} },	/* Position 3 */ \
+	{ {GR3, SG3},  {GR4, SG3},  {GR7, SG3},  {GR5, SG3},  {GR6, SG3},  {GR2, SG3},  {GR1, SG3} },	/* Position 4 */ \
+}}
+
+// Default display wiring, in flash memory (PROGMEM)
+extern const SC1628DLayout SC1628D_NORMAL_LAYOUT;
+
+#ifndef SC1628D_NO_INVERTED
+// Default display wiring on a reversed screen, in flash memory (PROGMEM)
+extern const SC1628DLayout SC1628D_INVERTED_LAYOUT;
+#endif
+
+// Build the message3's datas from the segment mask array, using a layout
+void SC1628D_RenderLayout(const SC1628DLayout &layout, const uint8_t digit[], uint16_t matrix[]);
+
+// Update the message3's datas of one position, using a layout
+void SC1628D_RenderPosition(const SC1628DLayout &layout, uint8_t pos, uint8_t segments, uint16_t matrix[]);
+
+// Build the message3's datas from the segment mask array, using a layout in flash memory (PROGMEM)
+void SC1628D_RenderLayout_P(const SC1628DLayout &layout, const uint8_t digit[], uint16_t matrix[]);
+
+// Update the message3's datas of one position, using a layout in flash memory (PROGMEM)
+void SC1628D_RenderPosition_P(const SC1628DLayout &layout, uint8_t pos, uint8_t segments, uint16_t matrix[]);
+
+// Get the getButtons() mask bits of a key scan byte
+//
+// @param keys A key scan byte
+// @param index The number of the byte from 0 (KS1-KS2) to 4 (KS9-KS10)
+//
+uint32_t SC1628D_KeyButtons(uint8_t keys, uint8_t index);
+
+// Multiply all the timings of a profile
+SC1628DTiming SC1628D_ScaleTiming(const SC1628DTiming &timing, uint8_t scale);
+
+// Default charaters definition, in flash memory (PROGMEM)
 extern const uint8_t SC1628D_NORMAL_FONT[];
 
-// Default charaters definition
+#ifndef SC1628D_NO_INVERTED
+// Default charaters definition on a reversed screen, in flash memory (PROGMEM)
 extern const uint8_t SC1628D_INVERTED_FONT[];
+#endif
+
+// Segments of the printable ASCII characters, from ' ' to '~', in flash memory (PROGMEM)
+extern const uint8_t SC1628D_ASCII_FONT[];
+
+#ifndef SC1628D_NO_INVERTED
+// Segments of the printable ASCII characters on a reversed screen, in flash memory (PROGMEM)
+extern const uint8_t SC1628D_INVERTED_ASCII_FONT[];
+#endif
 
 // Default function used to build the message3's datas from the segment mask array
 void SC1628D_NormalDisplay(uint8_t digit[], uint16_t matrix[]);
 
+#ifndef SC1628D_NO_INVERTED
 // Default function used to build the message3's datas from the segment mask array on a reversed screen
 void SC1628D_InvertedDisplay(uint8_t digit[], uint16_t matrix[]);
+#endif
 
 
-class SC1628D {
+// A key event, see pollKeyEvent()
+struct SC1628DKeyEvent {
+	uint8_t type;	// SC1628D_KEY_PRESS, _RELEASE, _LONG or _REPEAT
+	uint8_t key;	// Bit of the key in the getButtons() mask: 0-9 for K1/KS1-KS10, 16-25 for K2
+};
+
+// An animation frame of segments masks, stored in flash memory (PROGMEM)
+struct SC1628DFrame {
+	uint16_t duration;		// Milliseconds
+	uint8_t segments[5];
+};
+
+// An animation frame of display RAM words (as made by a filter), stored in flash memory (PROGMEM)
+struct SC1628DMatrixFrame {
+	uint16_t duration;		// Milliseconds
+	uint16_t matrix[7];
+};
+
+
+// The tick() engines below keep their state out of the display: a display
+// only pays the RAM of the ones attached to it, each one to a single display.
+
+// State of the scheduled key scan, see attachKeypad()
+class SC1628DKeypad {
 
 public:
-	// Initialize a SC1628D object, setting the clock and
-	// data pins.
+	// No scan, the default timings
 	//
-	// @param pinSTB - The number of the digital pin connected to the STB pin of the module
-	// @param pinCLK - The number of the digital pin connected to the clock pin of the module
-	// @param pinDIO - The number of the digital pin connected to the DIO pin of the module
-	// @param bitDelay - The delay, in microseconds, between bit transition on the serial bus
-	//                   connected to the display
-	//                  
-	SC1628D(uint8_t pinSTB, uint8_t pinCLK, uint8_t pinDIO, unsigned int bitDelay = SC1628D_BIT_DELAY);
+	SC1628DKeypad();
+
+private:
+	template <class BUS, class RENDER> friend class SC1628DCore;
+
+	void setTiming(uint8_t debounce, uint16_t longPress, uint16_t repeat);
+	void queue(uint8_t type, uint8_t key);
+
+	uint16_t m_interval;		// Scan period, 0 when not scanning
+	uint8_t m_bytes;			// Key bytes read per scan
+	uint8_t m_debounce;
+	uint8_t m_count;			// Identical scans so far
+	uint8_t m_held;				// Key of the long press/repeat events, 0xff for none
+	bool m_repeating;			// The long press event of m_held is sent
+	uint16_t m_long;
+	uint16_t m_repeat;
+	uint32_t m_mask;			// Buttons on the scanned KS lines
+	uint32_t m_last;			// Last scan
+	uint32_t m_state;			// Debounced state
+	unsigned long m_scanTime;
+	unsigned long m_heldTime;	// Time of the next long press/repeat event
+	SC1628DKeyEvent m_queue[SC1628D_KEY_QUEUE_SIZE];
+	volatile uint8_t m_head;
+	volatile uint8_t m_tail;
+};
+
+// State of the marquee, see attachMarquee()
+class SC1628DMarquee {
+
+public:
+	// Stopped
+	//
+	SC1628DMarquee();
+
+private:
+	template <class BUS, class RENDER> friend class SC1628DCore;
+
+	const uint8_t *m_text;
+	uint16_t m_length;
+	uint16_t m_pos;				// Next position of the string to enter
+	uint16_t m_interval;		// 0 when stopped
+	unsigned long m_time;
+	uint8_t m_width;
+	bool m_repeat;
+	bool m_digits;				// Digits to convert with the font
+};
+
+// State of the animations, see attachAnimation()
+class SC1628DAnimation {
+
+public:
+	// Stopped
+	//
+	SC1628DAnimation();
+
+private:
+	template <class BUS, class RENDER> friend class SC1628DCore;
+
+	const void *m_frames;		// NULL when stopped
+	uint16_t m_count;
+	uint16_t m_index;			// Next frame
+	int8_t m_step;				// 1 forward, -1 backward
+	uint8_t m_mode;
+	uint8_t m_pos;				// Positions of segments frames,
+	uint8_t m_length;			// 0 for matrix frames
+	unsigned long m_deadline;
+};
+
+// State of the per position intensity, see attachDimmer()
+class SC1628DDimmer {
+
+public:
+	// All the positions at full intensity, the default sub-frame period
+	//
+	SC1628DDimmer();
+
+private:
+	template <class BUS, class RENDER> friend class SC1628DCore;
+
+	uint8_t m_level[5];
+	uint8_t m_dimmed;			// Positions below full intensity
+	uint8_t m_phase;			// Sub-frame of the dimming cycle
+	uint8_t m_lit;				// Positions shown by the last frame composed
+	uint16_t m_period;
+	unsigned long m_time;
+};
+
+// State of the blinking segments, see attachBlinker()
+class SC1628DBlinker {
+
+public:
+	// Nothing blinking, the default period and duty cycle
+	//
+	SC1628DBlinker();
+
+private:
+	template <class BUS, class RENDER> friend class SC1628DCore;
+
+	void setRate(uint16_t period, uint8_t duty);
+
+	uint8_t m_segments[5];		// Blinking segments of each position
+	uint8_t m_positions;		// Positions with blinking segments
+	bool m_off;					// Off part of the blink period
+	uint16_t m_period;
+	uint16_t m_on;				// Lit part of the period
+	unsigned long m_time;		// Start of the current part
+};
+
+#ifdef SC1628D_STATS
+// Public calls with a latency histogram
+enum SC1628DCall {
+	SC1628D_CALL_CLEAR,
+	SC1628D_CALL_DISPLAY_DIGIT,
+	SC1628D_CALL_DISPLAY_DIGITS,
+	SC1628D_CALL_DISPLAY_SEGMENT,
+	SC1628D_CALL_DISPLAY_SEGMENTS,
+	SC1628D_CALL_GET_BUTTONS,
+	SC1628D_CALL_TICK,
+	SC1628D_CALL_DISPLAY_NUMBER,
+	SC1628D_CALL_DISPLAY_TEXT,
+	SC1628D_CALLS
+};
+
+// Latency histogram buckets: < 32 us, < 64 us, ... < 2048 us, >= 2048 us
+#define SC1628D_HISTOGRAM_BUCKETS  8
+#define SC1628D_HISTOGRAM_SHIFT    5
+
+// Performance counters
+struct SC1628DStats {
+	uint32_t frames;			// Display refreshes sent
+	uint32_t bytes;				// Bytes written or read
+	uint32_t bits;				// Clock pulses
+	uint32_t commands;			// Transactions (each one starts with a command)
+	uint32_t keyScans;			// Key scans
+	uint32_t busMicros;			// Time spent with STB low
+	uint32_t busMaxMicros;		// Longest transaction
+	uint16_t histogram[SC1628D_CALLS][SC1628D_HISTOGRAM_BUCKETS];	// Calls per duration
+};
+#endif
+
+#ifdef SC1628D_TRACE
+class Print;
+#endif
+
+
+// The bus of SC1628DDriver: a transport, called through its virtual functions
+struct SC1628DTransportBus {
+	SC1628DTransportBus(SC1628DTransport &transport) : m_transport(&transport) {}
+
+	void start() { m_transport->start(); }
+	void stop() { m_transport->stop(); }
+	void writeByte(uint8_t b) { m_transport->writeByte(b); }
+	void writeWord(uint16_t w) { m_transport->writeWord(w); }
+	uint8_t readByte(bool) { return m_transport->readByte(); }		// The transport waits before the first byte itself
+	void writeWaveform(const uint8_t steps[], uint16_t length) { m_transport->writeWaveform(steps, length); }
+	void setTiming(const SC1628DTiming &timing) { m_transport->setTiming(timing); }
+
+	SC1628DTransport *m_transport;
+};
+
+// The rendering of SC1628DDriver: a font, and a layout or a filter, chosen at run time
+struct SC1628DRuntimeRender {
+	SC1628DRuntimeRender();
+
+	uint8_t glyph(uint8_t digit) const;
+	uint8_t asciiGlyph(uint8_t c) const;		// c from ' ' to '~'
+	bool positional() const;					// Each position is rendered alone (a layout)
+	void renderPosition(uint8_t pos, uint8_t segments, uint16_t matrix[]) const;
+	void filter(uint8_t segments[], uint16_t matrix[]) const;
+
+	void setFont(const uint8_t font[]);
+	void setFont_P(const uint8_t font[]);
+	void setFilter(void (*aFilterFunction)(uint8_t digit[], uint16_t matrix[]));
+	void setLayout(const SC1628DLayout &layout);
+	void setLayout_P(const SC1628DLayout &layout);
+
+	void (*m_filter)(uint8_t digits[], uint16_t matrix[]);
+	const SC1628DLayout *m_layout;	// NULL when a custom filter is used
+	bool m_layoutFlash;				// m_layout is in flash memory
+	const uint8_t *m_font;
+	bool m_fontFlash;				// m_font is in flash memory
+	const uint8_t *m_ascii;			// ASCII font of displayText(), in flash memory
+};
+
+
+// The display driver, on a bus and a rendering given as types
+//
+// SC1628DDriver is this driver on a transport, with the font and the layout
+// chosen at run time. SC1628DStatic (SC1628DStatic.h) is the same driver on
+// pins, timings, a layout and a font fixed at compile time.
+//
+// BUS provides start(), stop(), writeByte(), writeWord(), readByte(first),
+// writeWaveform() and setTiming(), RENDER the functions of SC1628DRuntimeRender.
+// Both are base classes: a policy without members takes no RAM.
+//
+template <class BUS, class RENDER>
+class SC1628DCore : protected BUS, protected RENDER {
+
+public:
+	// Initialize the driver on its bus
+	//
+	// @param bus The bus, SC1628DTransportBus for a transport
+	//
+	SC1628DCore(const BUS &bus = BUS());
 
 	// Clear the display
 	//                  
@@ -103,9 +522,17 @@ public:
 
 	// Set the digits table to character to a segments set
 	//
-	// @param font An array of digits segments definition
+	// The built-in fonts are recognized and read from flash memory.
+	//
+	// @param font An array of digits segments definition, in RAM
 	//                  
-	void setFont(uint8_t font[] = SC1628D_NORMAL_FONT);
+	void setFont(const uint8_t font[] = SC1628D_NORMAL_FONT);
+
+	// Set the digits table, stored in flash memory (PROGMEM)
+	//
+	// @param font An array of digits segments definition, in flash memory
+	//
+	void setFont_P(const uint8_t font[]);
 
 	// Set the function to transform the 7 segment mask to the SC1628D memory map
 	//
@@ -113,6 +540,22 @@ public:
 	//                  
 	void setFilter(void (*aFilterFunction)(uint8_t digit[], uint16_t matrix[]));
 
+	// Set the layout describing how the module is wired
+	//
+	// A layout replaces the filter function. Updating a digit then only
+	// touches the bits of this digit. The built-in layouts are recognized and
+	// read from flash memory.
+	//
+	// @param layout The place of each segment of each position, in RAM
+	//
+	void setLayout(const SC1628DLayout &layout);
+
+	// Set the layout, stored in flash memory (PROGMEM)
+	//
+	// @param layout The place of each segment of each position, in flash memory
+	//
+	void setLayout_P(const SC1628DLayout &layout);
+
 	// Update a digit and refresh the screen
 	//
 	// This function receives a digit as input and update displays. 
@@ -128,6 +571,8 @@ public:
 	//
 	// @param digits An array of digits to display
 	// @param shape  The grid font for digits. This is a segments mask for each digits.
+	// @param pos The position of the first digit (0 - leftmost, 4 - rightmost), nothing is done past 4
+	// @param length The number of digits, cut at the rightmost position
 	//                  
 	void displayDigits(const uint8_t digits[], uint8_t pos = 0, uint8_t length = 5);
 
@@ -146,36 +591,563 @@ public:
 	//
 	// @param segments An array of segments to display
 	// @param pos The position from which to start the modification (0 - leftmost, 4 - rightmost)
-	// @param length The number of digits to be modified from 0 to 5
+	// @param length The number of digits to be modified from 0 to 5, cut at the rightmost position
 	//                  
 	void displaySegments(const uint8_t segments[], uint8_t pos = 0, uint8_t length = 5);
 
+	// Display a decimal number on the 4 digits
+	//
+	// Values out of the -999 to 9999 range are shown as "----". The symbols of
+	// the position 4 are not modified. Displaying the same value again does not
+	// send anything.
+	//
+	// @param value The number to display
+	// @param zeroPad true to show the leading zeros, false to blank them
+	//
+	void displayNumber(int32_t value, bool zeroPad = false);
+
+	// Display a fixed point decimal number on the 4 digits
+	//
+	// The module has no decimal points: the colon is lit for 2 decimals (as in
+	// "12:34" for 12.34). With 1 or 3 decimals there is no decimal mark at
+	// all: only the zeros before the decimals are kept, so displayFixed(-5, 1)
+	// shows "-05" and 12.5 looks like the integer 125. Scale the value to 2
+	// decimals when the mark matters. The digits before the decimals are always
+	// shown, so a negative number with 3 decimals is an overflow.
+	//
+	// @param value The number to display, multiplied by 10^decimals
+	// @param decimals The number of decimals, 0 to 3 (only 2 shows a mark)
+	// @param zeroPad true to show the leading zeros, false to blank them
+	//
+	void displayFixed(int32_t value, uint8_t decimals, bool zeroPad = false);
+
+	// Display a hexadecimal number on the 4 digits
+	//
+	// @param value The number to display
+	// @param zeroPad true to show the leading zeros, false to blank them
+	//
+	void displayHex(uint16_t value, bool zeroPad = false);
+
+	// Display a text on the 4 digits
+	//
+	// The characters are shown from the position pos to the position 3, the
+	// digits after the text are blanked and the ones before pos are kept. '.' and ':' light the colon instead of
+	// taking a digit, the other symbols of the position 4 are not modified.
+	// The text uses the inverted ASCII font when the font is
+	// SC1628D_INVERTED_FONT. Displaying the same text again does not send
+	// anything.
+	//
+	// @param text The text to display, as "Err", "HEAt" or "12:30"
+	// @param pos The position of the first character (0 - leftmost, 3 - rightmost digit)
+	//
+	void displayText(const char text[], uint8_t pos = 0);
+
+	// Display a text stored in flash memory (PSTR), as displayText()
+	//
+	void displayText_P(const char text[], uint8_t pos = 0);
+
+	// Attach the state of the marquee
+	//
+	// displayMarquee() and displayMarqueeDigits() do nothing and return false
+	// without it.
+	//
+	// @param marquee The marquee state, NULL to detach it
+	//
+	void attachMarquee(SC1628DMarquee *marquee);
+
+	// Scroll a segments string through the display, from tick()
+	//
+	// The string enters from the right and leaves on the left, one position
+	// per step. Each step shifts the displayed segments and only adds the
+	// entering position. The string is not copied: it must stay valid while
+	// scrolling.
+	//
+	// @param segments An array of segments masks
+	// @param length The number of positions of the string
+	// @param interval The step period in milliseconds
+	// @param width The number of positions used from the left, 4 (digits) or 5 (with the symbols)
+	// @param repeat true to restart when the string has left the display, false to stop
+	// @return false if no SC1628DMarquee is attached (nothing scrolls)
+	//
+	bool displayMarquee(const uint8_t segments[], uint16_t length, uint16_t interval, uint8_t width = SC1628D_NUMBER_DIGITS, bool repeat = true);
+
+	// Scroll a digits string through the display, from tick()
+	//
+	// As displayMarquee(), the digits being converted with the font when they enter the display.
+	//
+	// @param digits An array of digits
+	// @return false if no SC1628DMarquee is attached
+	//
+	bool displayMarqueeDigits(const uint8_t digits[], uint16_t length, uint16_t interval, uint8_t width = SC1628D_NUMBER_DIGITS, bool repeat = true);
+
+	// Stop scrolling, the display is left as it is
+	//
+	void stopMarquee();
+
+	// Get the marquee state
+	//
+	// @return true while a string is scrolling
+	//
+	bool isScrolling() const { return m_marquee && m_marquee->m_interval != 0; }
+
+	// Display a matrix of display RAM words, without filter
+	//
+	// The display functions show the segments again on the positions they update.
+	//
+	// @param matrix The 7 grid words, as made by a filter
+	//
+	void displayMatrix(const uint16_t matrix[]);
+
+	// Compile a frame of segments masks into a waveform, without sending it
+	//
+	// The segments go through the layout or the filter, and the waveform
+	// holds the whole display RAM and the brightness: it can be kept and sent
+	// again with sendWaveform() as long as the layout and the brightness do not
+	// change.
+	//
+	// @param waveform Receives the frame
+	// @param segments The 5 segments masks to display (0 - leftmost, 4 - rightmost)
+	//
+	void compileSegments(SC1628DWaveform &waveform, const uint8_t segments[]);
+
+	// Compile a frame of display RAM words into a waveform, without filter
+	//
+	// @param waveform Receives the frame
+	// @param matrix The 7 grid words, as made by a filter
+	//
+	void compileMatrix(SC1628DWaveform &waveform, const uint16_t matrix[]);
+
+	// Send a compiled waveform
+	//
+	// The steps are replayed by the transport without computing the bits: the
+	// bus time of a frame is always the same. A frame still pending or being
+	// sent by tick() is dropped. As with displayMatrix(), the display
+	// functions show the segments again on the positions they update.
+	//
+	// @param waveform A waveform made by compileSegments(), compileMatrix() or your own transactions
+	//
+	void sendWaveform(const SC1628DWaveform &waveform);
+
+	// Attach the state of the animations
+	//
+	// playAnimation() does nothing and returns false without it.
+	//
+	// @param animation The animation state, NULL to detach it
+	//
+	void attachAnimation(SC1628DAnimation *animation);
+
+	// Play an animation of segments frames, from tick()
+	//
+	// The frames are read from flash memory when shown. Each frame is shown at
+	// the deadline of the previous one, so the timing does not drift with the
+	// tick() period.
+	//
+	// @param frames An array of frames in flash memory (PROGMEM)
+	// @param count The number of frames
+	// @param mode SC1628D_ANIM_ONCE, SC1628D_ANIM_LOOP or SC1628D_ANIM_PINGPONG
+	// @param pos The first position updated by the frames (0 - leftmost, 4 - rightmost), nothing is played past 4
+	// @param length The number of positions updated by the frames, cut at the rightmost position
+	// @return false if no SC1628DAnimation is attached or pos is past 4 (nothing is played)
+	//
+	bool playAnimation(const SC1628DFrame frames[], uint16_t count, uint8_t mode = SC1628D_ANIM_LOOP, uint8_t pos = 0, uint8_t length = 5);
+
+	// Play an animation of matrix frames, from tick()
+	//
+	// The frames are sent as they are, without filter.
+	//
+	// @param frames An array of frames in flash memory (PROGMEM)
+	// @param count The number of frames
+	// @param mode SC1628D_ANIM_ONCE, SC1628D_ANIM_LOOP or SC1628D_ANIM_PINGPONG
+	// @return false if no SC1628DAnimation is attached
+	//
+	bool playAnimation(const SC1628DMatrixFrame frames[], uint16_t count, uint8_t mode = SC1628D_ANIM_LOOP);
+
+	// Stop the animation, the display is left as it is
+	//
+	void stopAnimation();
+
+	// Get the animation state
+	//
+	// @return true until the animation is stopped or, played once, its last frame has ended
+	//
+	bool isAnimating() const { return m_animation && m_animation->m_frames != 0; }
+
+	// Attach the state of the per position intensity
+	//
+	// setIntensity() and setDimPeriod() do nothing and return false without it.
+	// Detaching it shows the positions at full intensity.
+	//
+	// @param dimmer The intensity state, NULL to detach it
+	//
+	void attachDimmer(SC1628DDimmer *dimmer);
+
+	// Set the intensity of a position
+	//
+	// A dimmed position is blanked during a part of each dimming cycle, from
+	// tick(). Each cycle is made of SC1628D_DIM_LEVELS sub-frames, a position
+	// being shown during the first "level" sub-frames. Only the RAM bytes of the
+	// positions changing state are written between two sub-frames.
+	//
+	// @param pos The position (0 - leftmost, 4 - rightmost)
+	// @param level 0 (off) to SC1628D_DIM_LEVELS (full intensity, the default)
+	// @return false if no SC1628DDimmer is attached or pos is past 4
+	//
+	bool setIntensity(uint8_t pos, uint8_t level);
+
+	// Set the sub-frame period of the per position intensity
+	//
+	// tick() must be called at least as often. The cycle is SC1628D_DIM_LEVELS
+	// periods long, and must stay short enough (10 ms) not to flicker.
+	//
+	// @param microseconds The sub-frame period
+	// @return false if no SC1628DDimmer is attached
+	//
+	bool setDimPeriod(uint16_t microseconds = SC1628D_DIM_PERIOD_US);
+
+	// Attach the state of the blinking segments
+	//
+	// setBlink() and setBlinkRate() do nothing and return false without it.
+	// Detaching it shows the blinking segments.
+	//
+	// @param blinker The blink state, NULL to detach it
+	//
+	void attachBlinker(SC1628DBlinker *blinker);
+
+	// Blink segments of a position, from tick()
+	//
+	// The blinking segments are hidden during the off part of each period,
+	// the other ones stay lit. Only the RAM bytes of the blinking segments are
+	// written when the phase changes. The display functions keep the
+	// attributes and the phase: a value set during the off part is sent with
+	// its blinking segments already hidden.
+	//
+	// @param pos The position (0 - leftmost, 4 - rightmost)
+	// @param segments The blinking segments, 0xff for the whole position, 0 to stop
+	// @return false if no SC1628DBlinker is attached or pos is past 4
+	//
+	bool setBlink(uint8_t pos, uint8_t segments = 0xff);
+
+	// Set the blink period and duty cycle
+	//
+	// @param period The blink period in milliseconds
+	// @param duty The lit part of the period in percent (1-99)
+	// @return false if no SC1628DBlinker is attached
+	//
+	bool setBlinkRate(uint16_t period = SC1628D_BLINK_PERIOD_MS, uint8_t duty = SC1628D_BLINK_DUTY);
+
+	// Display the frames published in a mailbox, from tick()
+	//
+	// An interrupt or another task publishes complete frames without touching
+	// the bus, tick() takes the latest one and displays it on the 5 positions.
+	//
+	// @param mailbox The mailbox to take the frames from, NULL to detach it
+	//
+	void attachMailbox(SC1628DMailbox *mailbox);
+
+	// Set the serial bus timings
+	//
+	// @param timing The timings in nanoseconds, a SC1628D_TIMING_xxx profile or your own
+	//
+	void setTiming(const SC1628DTiming &timing);
+
+	// Find the fastest reliable timings for this board and wiring
+	//
+	// The datasheet timings multiplied by 16, 8, 4, 2 then 1 are tried, and kept
+	// while the key bytes read stay the same as with the slowest ones. Keep a
+	// key pressed during the calibration: with no key pressed, a late data line
+	// may go unnoticed.
+	//
+	// @return the factor kept (1 for the datasheet timings), 0 if the key reads
+	//         are not valid (the SC1628D_TIMING_LEGACY timings are then set)
+	//
+	uint8_t calibrate();
+
 	// Get pressed buttons code
 	//
+	// In asynchronous mode, the bus transaction in progress is completed first.
+	//
 	// @return a mask of pressed buttons, K1 from bit 0 to bit 9, K2 from bit 16 to bit 25.
 	//                  
     uint32_t getButtons();
 
+	// Attach the state of the scheduled key scan
+	//
+	// setKeyScan() and setKeyTiming() do nothing and return false without it,
+	// pollKeyEvent() and getKeys() find no key.
+	//
+	// @param keypad The key scan state, NULL to detach it
+	//
+	void attachKeypad(SC1628DKeypad *keypad);
+
+	// Start the scheduled key scan
+	//
+	// The keys are scanned by tick() every interval, debounced, and the changes
+	// are queued as events for pollKeyEvent(). Only the key bytes up to the last
+	// KS line used are read.
+	//
+	// @param interval The scan period in milliseconds, 0 to stop scanning
+	// @param ksMask The KS lines connected to keys, a combination of SC1628D_KS(n)
+	// @return false if no SC1628DKeypad is attached (nothing is scanned)
+	//
+	bool setKeyScan(uint16_t interval, uint16_t ksMask = SC1628D_KS_ALL);
+
+	// Set the key event timings
+	//
+	// @param debounce The number of identical scans needed to accept a change
+	// @param longPress The delay in milliseconds before a long press event, 0 for none
+	// @param repeat The period in milliseconds of the repeat events after a long press, 0 for none
+	// @return false if no SC1628DKeypad is attached
+	//
+	bool setKeyTiming(uint8_t debounce = SC1628D_KEY_DEBOUNCE, uint16_t longPress = SC1628D_KEY_LONG_MS, uint16_t repeat = SC1628D_KEY_REPEAT_MS);
+
+	// Get the next key event
+	//
+	// @param event Receives the oldest queued event
+	// @return false if no event is queued
+	//
+	bool pollKeyEvent(SC1628DKeyEvent &event);
+
+	// Get the debounced keys state of the scheduled key scan
+	//
+	// @return a mask of pressed buttons, as getButtons()
+	//
+	uint32_t getKeys() const { return m_keypad ? m_keypad->m_state : 0; }
+
+	// Set the asynchronous refresh mode
+	//
+	// In asynchronous mode, the display functions only update a back buffer and
+	// return immediately. The frame is sent a few bytes at a time by tick().
+	// Leaving the asynchronous mode sends the pending frame.
+	//
+	// @param async true to enable the asynchronous mode
+	//
+	void setAsync(bool async);
+
+	// Advance the asynchronous refresh and the scheduled key scan
+	//
+	// To be called from loop() or from a timer interrupt. The back buffer is
+	// taken at a frame boundary, so a frame on the bus is never mixed with a
+	// newer one. In synchronous mode, a tick() interrupting a display function
+	// or a key read does nothing: its work is left to the next one.
+	//
+	// @param bytes The maximum number of bytes to send during this call
+	// @return true while a frame is pending or being sent
+	//
+	bool tick(uint8_t bytes = SC1628D_TICK_BYTES);
+
+	// Send the pending frame now, without waiting for the refresh limit
+	//
+	void flush();
+
+	// Limit the display refreshes
+	//
+	// The display functions then only mark the display as modified, and tick()
+	// sends its last state once the interval since the previous frame has
+	// elapsed and the bus time stays under the budget: five digit updates in a
+	// row make one frame. tick() returns false while the display only waits
+	// for the limit, flush() and commit() send it at once.
+	//
+	// @param interval Minimum time between two frames in milliseconds, 0 for no minimum
+	// @param budget Maximum share of the time spent on the bus since the previous frame, in percent (1-100)
+	//
+	void setRefreshLimit(uint16_t interval, uint8_t budget = 100);
+
+	// Start a batch of operations
+	//
+	// Until commit(), the display functions and setBrightness() only update the
+	// buffers. commit() then sends all of them as a single frame, at once even
+	// under a refresh limit (setRefreshLimit()).
+	//
+	void begin();
+
+	// Read the keys when the batch is committed
+	//
+	void requestButtons();
+
+	// Send the batch: the modified RAM bytes, the changed commands, then the key scan
+	//
+	// In asynchronous mode, the frame is left to tick() and the keys are read now.
+	//
+	// @return the pressed buttons as getButtons() if requestButtons() was called, 0 otherwise
+	//
+	uint32_t commit();
+
+#ifdef SC1628D_STATS
+	// Get the performance counters
+	//
+	const SC1628DStats &getStats() const { return m_stats; }
+
+	// Set the performance counters to 0
+	//
+	void resetStats();
+#endif
+
+#ifdef SC1628D_TRACE
+	// Write the recorded bus transactions, oldest first, and empty the trace
+	//
+	// One line per transaction, in hexadecimal: "@W" ("@R" when key bytes were
+	// read), the micros() time of STB low, the duration in microseconds, then
+	// the bytes, command first. A "@L" line gives the number of transactions
+	// overwritten before. extras/trace/sc1628d_trace.py decodes the lines.
+	//
+	// Example: "@W 0001e240 0012 c03f000600"
+	//
+	// @param out Where to write the lines (Serial...)
+	//
+	void dumpTrace(Print &out);
+
+	// Empty the trace
+	//
+	void clearTrace();
+#endif
+
 
 protected:
-	void bitDelay();
 	void start();
 	void stop();
 	void writeCommand(uint8_t b);
 	void writeData(uint16_t b);
 	void writeMatrix(const uint16_t matrix[]);
-	uint8_t receiveData();
+	uint8_t receiveData(bool first);
 
 private:
-	void (*m_filter)(uint8_t digits[], uint16_t matrix[]);
-	uint8_t m_pinSTB;
-	uint8_t m_pinCLK;
-	uint8_t m_pinDIO;
+	friend class SC1628DPages;
+
+	void init();
+#ifdef SC1628D_TRACE
+	void traceByte(uint8_t b);
+	void traceEnd(unsigned long elapsed);
+	void tracePut(uint8_t b);
+	void traceWaveform(const SC1628DWaveform &waveform, unsigned long start, unsigned long elapsed);
+#endif
+	void render(uint8_t segments[], uint16_t matrix[]);
+	void update(uint8_t pos, uint8_t length);
+	void output();
+	void present();
+	bool refreshDue();
+	void compose(uint16_t matrix[]);
+	uint8_t litPositions();
+	void serviceDimming();
+	void serviceBlink();
+	void displayNumeric(int32_t value, uint8_t format);
+	void displayString(const char text[], uint8_t pos, bool flash);
+	void refresh(const uint16_t matrix[]);
+	void planMatrix(const uint16_t matrix[]);
+	void planFrame(const uint16_t matrix[]);
+	void planCommand(uint8_t &state, uint8_t command);
+	void txnAdd(uint16_t op);
+	bool runTxn(uint8_t count, bool yield = false);
+	bool acquireBus();
+	void releaseBus(bool taken);
+	uint32_t scanKeys(uint8_t bytes);
+	void readKeys(uint8_t keys[], uint8_t bytes);
+	void serviceKeys();
+	bool startMarquee(const uint8_t text[], uint16_t length, uint16_t interval, uint8_t width, bool repeat, bool digits);
+	void serviceMarquee();
+	void startAnimation(const void *frames, uint16_t count, uint8_t mode);
+	void serviceAnimation();
+	void serviceMailbox();
+
 	uint8_t m_brightness;
-	unsigned int m_bitDelay;
-	uint8_t m_mode;
-	uint8_t *m_font;
+
+	// Chip command state once the program is complete, 0xff when unknown:
+	// commands that would not change it are not sent
+	uint8_t m_mode;				// Command 1
+	uint8_t m_dataSetting;		// Command 2
+	uint8_t m_control;			// Command 4
+
+	// Last number displayed, its format and its segments
+	int32_t m_numberValue;
+	uint8_t m_numberFormat;		// 0xff when none, or after a font change
+	uint8_t m_numberSegments[SC1628D_NUMBER_DIGITS + 1];
+
+	// tick() engines, NULL when not attached
+	SC1628DMarquee *m_marquee;
+	SC1628DAnimation *m_animation;
+	SC1628DDimmer *m_dimmer;
+	SC1628DBlinker *m_blinker;
+	SC1628DKeypad *m_keypad;
+	SC1628DMailbox *m_mailbox;
+
+	bool m_batch;				// Between begin() and commit()
+	bool m_batchKeys;			// requestButtons() called in the batch
 	uint8_t m_segments[7];
+	uint16_t m_render[7];		// Matrix of m_segments
+	uint16_t m_matrix[7];		// Last matrix written to the display RAM
+	bool m_matrixValid;			// m_matrix matches the display RAM
+
+	uint8_t m_txn[SC1628D_TXN_SIZE];	// Bus transaction program
+	uint32_t m_txnStart;		// Entries starting a transaction
+	uint8_t m_txnLen;
+	uint8_t m_txnPos;
+	volatile bool m_txnOpen;	// STB is low between two program entries
+
+	bool m_async;
+	uint16_t m_back[7];			// Asynchronous mode back buffer
+	volatile bool m_pending;	// m_back holds a frame not sent yet
+	volatile bool m_busLock;	// tick() must not start a new transaction
+
+	uint16_t m_refreshInterval;	// Refresh limit, milliseconds
+	uint8_t m_refreshBudget;	// Refresh limit, percent of bus time
+	volatile bool m_dirty;		// m_render is not sent yet, waiting for the limit
+	unsigned long m_refreshTime;	// Start of the last frame sent
+	unsigned long m_refreshBusy;	// Bus time since, in microseconds
+
+#ifdef SC1628D_STATS
+	SC1628DStats m_stats;
+	unsigned long m_statStart;	// Start of the current transaction
+	uint8_t m_statDepth;		// Nesting of the public calls
+#endif
+
+#ifdef SC1628D_TRACE
+	uint8_t m_trace[SC1628D_TRACE_SIZE];	// Ring buffer of the transactions
+	uint16_t m_traceHead;		// Next byte written
+	uint16_t m_traceTail;		// Oldest transaction
+	uint16_t m_traceUsed;
+	uint16_t m_traceLost;		// Transactions overwritten since the last dump
+	unsigned long m_traceStart;	// Current transaction
+	uint8_t m_traceFlags;
+	uint8_t m_traceLen;
+	uint8_t m_traceBytes[SC1628D_TRACE_BYTES];
+#endif
+};
+
+// Instantiated once, in SC1628D.cpp
+extern template class SC1628DCore<SC1628DTransportBus, SC1628DRuntimeRender>;
+
+// The display driver, on a given transport. SC1628D is the same driver on three pins.
+class SC1628DDriver : public SC1628DCore<SC1628DTransportBus, SC1628DRuntimeRender> {
+
+public:
+	// Initialize a SC1628DDriver object on a given transport (hardware SPI, mock...)
+	//
+	// @param transport - The serial bus transport connected to the module
+	//
+	SC1628DDriver(SC1628DTransport &transport);
+};
+
+
+// The bit banged pins of a SC1628D, constructed before its driver part
+struct SC1628DPinBus {
+	SC1628DPinBus(uint8_t pinSTB, uint8_t pinCLK, uint8_t pinDIO, unsigned int bitDelay);
+
+	SC1628DBitBangTransport m_bitBang;
+};
+
+// The display driver on three digital pins
+class SC1628D : private SC1628DPinBus, public SC1628DDriver {
+
+public:
+	// Initialize a SC1628D object, setting the clock and
+	// data pins.
+	//
+	// @param pinSTB - The number of the digital pin connected to the STB pin of the module
+	// @param pinCLK - The number of the digital pin connected to the clock pin of the module
+	// @param pinDIO - The number of the digital pin connected to the DIO pin of the module
+	// @param bitDelay - The delay, in microseconds, between bit transition on the serial bus
+	//                   connected to the display
+	//                  
+	SC1628D(uint8_t pinSTB, uint8_t pinCLK, uint8_t pinDIO, unsigned int bitDelay = SC1628D_BIT_DELAY);
 };
 
 #endif // __SC1628D__
@@ -0,0 +1,1625 @@
+/*
+ *  SC1628DCore.h
+ *
+ *  Arduino Library for the SC1628D LED Driver IC
+ *  Functions of the SC1628DCore driver template, for the drivers instantiating it
+ *
+ *  (c) 2022/07/13 philippe.corbes@gmail.com
+ *
+ *  This library is free software; you can redistribute it and/or
+ *  modify it under the terms of the GNU Lesser General Public
+ *  License as published by the Free Software Foundation; either
+ *  version 2.1 of the License, or (at your option) any later version.
+ *
+ *  This library is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ *  Lesser General Public License for more details.
+ *
+ *  You should have received a copy of the GNU Lesser General Public
+ *  License along with this library; if not, write to the Free Software
+ *  Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  USA
+ */
+
+#ifndef __SC1628D_CORE__
+#define __SC1628D_CORE__
+
+extern "C" {
+	#include <string.h>
+	#include <inttypes.h>
+}
+
+#include <Arduino.h>
+#include <SC1628D.h>
+
+// Number formats of displayNumeric()
+#define SC1628D_NUMBER_DECIMALS  0x03
+#define SC1628D_NUMBER_ZERO_PAD  0x04
+#define SC1628D_NUMBER_HEX       0x08
+#define SC1628D_NUMBER_FIXED     0x10		// Sets the colon
+#define SC1628D_NUMBER_OVERFLOW  0x20
+
+#ifdef SC1628D_STATS
+	#define SC1628D_STAT(x)         x
+	#define SC1628D_STAT_CALL(call) SC1628DStatScope statScope(m_stats, m_statDepth, call)
+#else
+	#define SC1628D_STAT(x)
+	#define SC1628D_STAT_CALL(call)
+#endif
+
+// Bus trace records: a header byte (length and flags), the start time (4
+// bytes), the duration (2 bytes), then the bytes of the transaction
+#define SC1628D_TRACE_HEADER     7
+#define SC1628D_TRACE_LENGTH     0x1f
+#define SC1628D_TRACE_TRUNCATED  0x20		// More than SC1628D_TRACE_BYTES bytes
+#define SC1628D_TRACE_READ       0x80		// The bytes after the command were read
+
+
+#ifdef SC1628D_STATS
+// Measure the duration of the outermost public call, to its histogram
+class SC1628DStatScope {
+
+public:
+	SC1628DStatScope(SC1628DStats &stats, uint8_t &depth, SC1628DCall call) : m_stats(stats), m_depth(depth)
+	{
+		m_call = call;
+		if (m_depth++ == 0)
+			m_start = micros();
+	}
+
+	~SC1628DStatScope()
+	{
+		if (--m_depth != 0)
+			return;
+
+		unsigned long elapsed = (micros() - m_start) >> SC1628D_HISTOGRAM_SHIFT;
+		uint8_t bucket = 0;
+		while (elapsed && bucket < SC1628D_HISTOGRAM_BUCKETS - 1) {
+			elapsed >>= 1;
+			bucket++;
+		}
+		uint16_t &count = m_stats.histogram[m_call][bucket];
+		if (count != 0xffff)
+			count++;
+	}
+
+private:
+	SC1628DStats &m_stats;
+	uint8_t &m_depth;
+	SC1628DCall m_call;
+	unsigned long m_start;
+};
+#endif
+
+
+// The rendering of SC1628DDriver, inlined in the driver functions
+
+// Segments of a digit, from the font in RAM or in flash memory
+inline uint8_t SC1628DRuntimeRender::glyph(uint8_t digit) const
+{
+	return m_fontFlash ? pgm_read_byte(&m_font[digit]) : m_font[digit];
+}
+
+inline uint8_t SC1628DRuntimeRender::asciiGlyph(uint8_t c) const
+{
+	return pgm_read_byte(&m_ascii[c - ' ']);
+}
+
+inline bool SC1628DRuntimeRender::positional() const
+{
+	return m_layout != NULL;
+}
+
+// Update the matrix bits of one position with the layout in RAM or in flash memory
+inline void SC1628DRuntimeRender::renderPosition(uint8_t pos, uint8_t segments, uint16_t matrix[]) const
+{
+	if (m_layoutFlash)
+		SC1628D_RenderPosition_P(*m_layout, pos, segments, matrix);
+	else
+		SC1628D_RenderPosition(*m_layout, pos, segments, matrix);
+}
+
+inline void SC1628DRuntimeRender::filter(uint8_t segments[], uint16_t matrix[]) const
+{
+	m_filter(segments, matrix);
+}
+
+
+template <class BUS, class RENDER>
+SC1628DCore<BUS, RENDER>::SC1628DCore(const BUS &bus) : BUS(bus)
+{
+	init();
+}
+
+template <class BUS, class RENDER>
+void SC1628DCore<BUS, RENDER>::init()
+{
+	memset(m_segments, 0, sizeof(m_segments));
+	memset(m_render, 0, sizeof(m_render));
+	m_matrixValid = false;
+	m_brightness = 0x0f;
+	m_mode = 0xff;
+	m_dataSetting = 0xff;
+	m_control = 0xff;
+	m_numberFormat = 0xff;
+	m_marquee = NULL;
+	m_animation = NULL;
+	m_dimmer = NULL;
+	m_blinker = NULL;
+	m_keypad = NULL;
+	m_mailbox = NULL;
+	m_batch = false;
+	m_batchKeys = false;
+	m_txnLen = 0;
+	m_txnPos = 0;
+	m_txnStart = 0;
+	m_txnOpen = false;
+	m_async = false;
+	m_pending = false;
+	m_busLock = false;
+	m_refreshInterval = 0;
+	m_refreshBudget = 100;
+	m_dirty = false;
+	m_refreshTime = 0;
+	m_refreshBusy = 0;
+#ifdef SC1628D_STATS
+	m_statDepth = 0;
+	resetStats();
+#endif
+#ifdef SC1628D_TRACE
+	m_traceLen = 0;
+	m_traceFlags = 0;
+	clearTrace();
+#endif
+}
+
+
+template <class BUS, class RENDER>
+void SC1628DCore<BUS, RENDER>::clear()
+{
+	SC1628D_STAT_CALL(SC1628D_CALL_CLEAR);
+    uint8_t data[] = { 0, 0, 0, 0, 0};
+	displayDigits(data);
+}
+
+template <class BUS, class RENDER>
+void SC1628DCore<BUS, RENDER>::setBrightness(uint8_t brightness, bool on)
+{
+	m_brightness = (brightness & 0x7) | (on? 0x08 : 0x00);
+}
+
+template <class BUS, class RENDER>
+void SC1628DCore<BUS, RENDER>::setFont(const uint8_t font[])
+{
+	RENDER::setFont(font);
+	m_numberFormat = 0xff;
+}
+
+template <class BUS, class RENDER>
+void SC1628DCore<BUS, RENDER>::setFont_P(const uint8_t font[])
+{
+	RENDER::setFont_P(font);
+	m_numberFormat = 0xff;
+}
+
+template <class BUS, class RENDER>
+void SC1628DCore<BUS, RENDER>::setFilter(void (*aFilterFunction)(uint8_t digit[], uint16_t matrix[]))
+{
+	RENDER::setFilter(aFilterFunction);
+	render(m_segments, m_render);
+}
+
+template <class BUS, class RENDER>
+void SC1628DCore<BUS, RENDER>::setLayout(const SC1628DLayout &layout)
+{
+	RENDER::setLayout(layout);
+	render(m_segments, m_render);
+}
+
+template <class BUS, class RENDER>
+void SC1628DCore<BUS, RENDER>::setLayout_P(const SC1628DLayout &layout)
+{
+	RENDER::setLayout_P(layout);
+	render(m_segments, m_render);
+}
+
+template <class BUS, class RENDER>
+void SC1628DCore<BUS, RENDER>::displayDigit(const uint8_t digit, uint8_t pos)
+{
+	SC1628D_STAT_CALL(SC1628D_CALL_DISPLAY_DIGIT);
+	if (pos > 4)
+		return;
+	m_segments[pos] = RENDER::glyph(digit);
+	update(pos, 1);
+}
+
+template <class BUS, class RENDER>
+void SC1628DCore<BUS, RENDER>::displayDigits(const uint8_t digits[], uint8_t pos, uint8_t length)
+{
+	SC1628D_STAT_CALL(SC1628D_CALL_DISPLAY_DIGITS);
+	if (pos > 4)
+		return;
+	if (length > 5 - pos)
+		length = 5 - pos;
+	for (uint8_t i = 0; i < length; i++) {
+		m_segments[pos + i] = RENDER::glyph(digits[i]);
+	}
+	update(pos, length);
+}
+
+template <class BUS, class RENDER>
+void SC1628DCore<BUS, RENDER>::displaySegment(const uint8_t segment, uint8_t pos)
+{
+	SC1628D_STAT_CALL(SC1628D_CALL_DISPLAY_SEGMENT);
+	if (pos > 4)
+		return;
+	m_segments[pos] = segment;
+	update(pos, 1);
+}
+
+template <class BUS, class RENDER>
+void SC1628DCore<BUS, RENDER>::displaySegments(const uint8_t segments[], uint8_t pos, uint8_t length)
+{
+	SC1628D_STAT_CALL(SC1628D_CALL_DISPLAY_SEGMENTS);
+	if (segments == m_segments) {
+		pos = 0;
+		length = 5;
+	}
+	else {
+		if (pos > 4)
+			return;
+		if (length > 5 - pos)
+			length = 5 - pos;
+		for (uint8_t i = 0; i < length; i++)
+			m_segments[pos + i] = segments[i];
+	}
+	update(pos, length);
+}
+
+template <class BUS, class RENDER>
+void SC1628DCore<BUS, RENDER>::displayNumber(int32_t value, bool zeroPad)
+{
+	SC1628D_STAT_CALL(SC1628D_CALL_DISPLAY_NUMBER);
+	displayNumeric(value, zeroPad ? SC1628D_NUMBER_ZERO_PAD : 0);
+}
+
+template <class BUS, class RENDER>
+void SC1628DCore<BUS, RENDER>::displayFixed(int32_t value, uint8_t decimals, bool zeroPad)
+{
+	SC1628D_STAT_CALL(SC1628D_CALL_DISPLAY_NUMBER);
+	displayNumeric(value, SC1628D_NUMBER_FIXED | (decimals & SC1628D_NUMBER_DECIMALS) | (zeroPad ? SC1628D_NUMBER_ZERO_PAD : 0));
+}
+
+template <class BUS, class RENDER>
+void SC1628DCore<BUS, RENDER>::displayHex(uint16_t value, bool zeroPad)
+{
+	SC1628D_STAT_CALL(SC1628D_CALL_DISPLAY_NUMBER);
+	displayNumeric(value, SC1628D_NUMBER_HEX | (zeroPad ? SC1628D_NUMBER_ZERO_PAD : 0));
+}
+
+template <class BUS, class RENDER>
+void SC1628DCore<BUS, RENDER>::displayText(const char text[], uint8_t pos)
+{
+	SC1628D_STAT_CALL(SC1628D_CALL_DISPLAY_TEXT);
+	displayString(text, pos, false);
+}
+
+template <class BUS, class RENDER>
+void SC1628DCore<BUS, RENDER>::displayText_P(const char text[], uint8_t pos)
+{
+	SC1628D_STAT_CALL(SC1628D_CALL_DISPLAY_TEXT);
+	displayString(text, pos, true);
+}
+
+template <class BUS, class RENDER>
+void SC1628DCore<BUS, RENDER>::attachMarquee(SC1628DMarquee *marquee)
+{
+	m_marquee = marquee;
+}
+
+template <class BUS, class RENDER>
+bool SC1628DCore<BUS, RENDER>::displayMarquee(const uint8_t segments[], uint16_t length, uint16_t interval, uint8_t width, bool repeat)
+{
+	return startMarquee(segments, length, interval, width, repeat, false);
+}
+
+template <class BUS, class RENDER>
+bool SC1628DCore<BUS, RENDER>::displayMarqueeDigits(const uint8_t digits[], uint16_t length, uint16_t interval, uint8_t width, bool repeat)
+{
+	return startMarquee(digits, length, interval, width, repeat, true);
+}
+
+template <class BUS, class RENDER>
+void SC1628DCore<BUS, RENDER>::stopMarquee()
+{
+	if (m_marquee)
+		m_marquee->m_interval = 0;
+}
+
+template <class BUS, class RENDER>
+void SC1628DCore<BUS, RENDER>::displayMatrix(const uint16_t matrix[])
+{
+	refresh(matrix);
+}
+
+template <class BUS, class RENDER>
+void SC1628DCore<BUS, RENDER>::compileSegments(SC1628DWaveform &waveform, const uint8_t segments[])
+{
+	uint16_t matrix[7];
+	uint8_t digits[5];
+
+	// A filter may modify its input
+	memcpy(digits, segments, sizeof(digits));
+	render(digits, matrix);
+	compileMatrix(waveform, matrix);
+}
+
+template <class BUS, class RENDER>
+void SC1628DCore<BUS, RENDER>::compileMatrix(SC1628DWaveform &waveform, const uint16_t matrix[])
+{
+	waveform.compileFrame(matrix, SC1628D_DISPLAY_CONTROL_CMD | (m_brightness & 0x0f));
+}
+
+template <class BUS, class RENDER>
+void SC1628DCore<BUS, RENDER>::sendWaveform(const SC1628DWaveform &waveform)
+{
+	bool taken = acquireBus();
+
+	// The waveform replaces the frame of tick()
+	m_txnLen = m_txnPos = 0;
+	m_pending = false;
+
+	unsigned long start = micros();
+	BUS::writeWaveform(waveform.steps(), waveform.length());
+	unsigned long elapsed = micros() - start;
+	if (m_refreshBudget < 100)
+		m_refreshBusy += elapsed;
+#ifdef SC1628D_STATS
+	uint16_t bytes = (waveform.length() - 2 * waveform.transactions()) / 16;
+	m_stats.frames++;
+	m_stats.commands += waveform.transactions();
+	m_stats.bytes += bytes;
+	m_stats.bits += 8 * bytes;
+	m_stats.busMicros += elapsed;
+#endif
+#ifdef SC1628D_TRACE
+	traceWaveform(waveform, start, elapsed);
+#endif
+
+	// The chip state is known after a compiled frame, not after other transactions
+	if (waveform.isFrame()) {
+		for (uint8_t k = 0; k < 7; k++)
+			m_matrix[k] = waveform.matrix()[k];
+		m_matrixValid = true;
+		m_dataSetting = SC1628D_DATA_SETTING_CMD_WRITE | SC1628D_2_INCREMENT_ADDR;
+		m_mode = SC1628D_DISPLAY_MODE_CMD | SC1628D_7GRID_11SEG;
+		m_control = waveform.control();
+	}
+	else {
+		m_matrixValid = false;
+		m_mode = 0xff;
+		m_dataSetting = 0xff;
+		m_control = 0xff;
+	}
+	releaseBus(taken);
+}
+
+template <class BUS, class RENDER>
+void SC1628DCore<BUS, RENDER>::attachAnimation(SC1628DAnimation *animation)
+{
+	m_animation = animation;
+}
+
+template <class BUS, class RENDER>
+bool SC1628DCore<BUS, RENDER>::playAnimation(const SC1628DFrame frames[], uint16_t count, uint8_t mode, uint8_t pos, uint8_t length)
+{
+	if (!m_animation || pos > 4)
+		return false;
+	if (length > 5 - pos)
+		length = 5 - pos;
+	m_animation->m_pos = pos;
+	m_animation->m_length = length ? length : 1;
+	startAnimation(frames, count, mode);
+	return true;
+}
+
+template <class BUS, class RENDER>
+bool SC1628DCore<BUS, RENDER>::playAnimation(const SC1628DMatrixFrame frames[], uint16_t count, uint8_t mode)
+{
+	if (!m_animation)
+		return false;
+	m_animation->m_length = 0;
+	startAnimation(frames, count, mode);
+	return true;
+}
+
+template <class BUS, class RENDER>
+void SC1628DCore<BUS, RENDER>::stopAnimation()
+{
+	if (m_animation)
+		m_animation->m_frames = NULL;
+}
+
+template <class BUS, class RENDER>
+void SC1628DCore<BUS, RENDER>::attachDimmer(SC1628DDimmer *dimmer)
+{
+	m_dimmer = dimmer;
+	if (!m_batch)
+		output();
+}
+
+template <class BUS, class RENDER>
+bool SC1628DCore<BUS, RENDER>::setIntensity(uint8_t pos, uint8_t level)
+{
+	if (pos > 4 || !m_dimmer)
+		return false;
+	if (level > SC1628D_DIM_LEVELS)
+		level = SC1628D_DIM_LEVELS;
+	SC1628DDimmer &dim = *m_dimmer;
+	uint8_t dimmed = dim.m_dimmed;
+	dim.m_level[pos] = level;
+	if (level < SC1628D_DIM_LEVELS)
+		dim.m_dimmed |= 1 << pos;
+	else
+		dim.m_dimmed &= ~(1 << pos);
+	// The sub-frames start with the first dimmed position, later calls keep their phase
+	if (!dimmed && dim.m_dimmed)
+		dim.m_time = micros();
+	if (litPositions() != dim.m_lit && !m_batch)
+		output();
+	return true;
+}
+
+template <class BUS, class RENDER>
+bool SC1628DCore<BUS, RENDER>::setDimPeriod(uint16_t microseconds)
+{
+	if (!m_dimmer)
+		return false;
+	m_dimmer->m_period = microseconds;
+	return true;
+}
+
+template <class BUS, class RENDER>
+void SC1628DCore<BUS, RENDER>::attachBlinker(SC1628DBlinker *blinker)
+{
+	m_blinker = blinker;
+	if (!m_batch)
+		output();
+}
+
+template <class BUS, class RENDER>
+bool SC1628DCore<BUS, RENDER>::setBlink(uint8_t pos, uint8_t segments)
+{
+	if (pos > 4 || !m_blinker)
+		return false;
+	SC1628DBlinker &blink = *m_blinker;
+	uint8_t blinking = blink.m_positions;
+	bool changed = blink.m_off && segments != blink.m_segments[pos];
+
+	blink.m_segments[pos] = segments;
+	if (segments)
+		blink.m_positions |= 1 << pos;
+	else
+		blink.m_positions &= ~(1 << pos);
+
+	// The phase starts lit with the first blinking position, and runs on while others blink
+	if (!blinking && blink.m_positions) {
+		blink.m_off = false;
+		blink.m_time = millis();
+	}
+	if (!blink.m_positions)
+		blink.m_off = false;
+
+	// Nothing changes on the display during the lit part
+	if (changed && !m_batch)
+		output();
+	return true;
+}
+
+template <class BUS, class RENDER>
+bool SC1628DCore<BUS, RENDER>::setBlinkRate(uint16_t period, uint8_t duty)
+{
+	if (!m_blinker)
+		return false;
+	m_blinker->setRate(period, duty);
+	return true;
+}
+
+template <class BUS, class RENDER>
+void SC1628DCore<BUS, RENDER>::attachMailbox(SC1628DMailbox *mailbox)
+{
+	m_mailbox = mailbox;
+}
+
+template <class BUS, class RENDER>
+void SC1628DCore<BUS, RENDER>::setTiming(const SC1628DTiming &timing)
+{
+	BUS::setTiming(timing);
+}
+
+template <class BUS, class RENDER>
+uint8_t SC1628DCore<BUS, RENDER>::calibrate()
+{
+	uint8_t reference[5];
+	uint8_t keys[5];
+	uint8_t best = 0;
+	bool valid = true;
+
+	// The slowest setting gives the reference key bytes, their unused bits must be 0
+	BUS::setTiming(SC1628D_ScaleTiming(SC1628D_TIMING_DATASHEET, SC1628D_CALIBRATE_SCALE));
+	readKeys(reference, 5);
+	for (uint8_t i = 0; i < 5; i++)
+		if (reference[i] & SC1628D_KEY_UNUSED_BITS)
+			valid = false;
+
+	// Faster and faster, while the key bytes read stay the same
+	for (uint8_t scale = SC1628D_CALIBRATE_SCALE; scale && valid; scale >>= 1) {
+		BUS::setTiming(SC1628D_ScaleTiming(SC1628D_TIMING_DATASHEET, scale));
+		for (uint8_t n = 0; n < SC1628D_CALIBRATE_SCANS && valid; n++) {
+			readKeys(keys, 5);
+			valid = memcmp(keys, reference, 5) == 0;
+		}
+		if (valid)
+			best = scale;
+	}
+
+	if (best)
+		BUS::setTiming(SC1628D_ScaleTiming(SC1628D_TIMING_DATASHEET, best));
+	else
+		BUS::setTiming(SC1628D_TIMING_LEGACY);
+	return best;
+}
+
+template <class BUS, class RENDER>
+uint32_t SC1628DCore<BUS, RENDER>::getButtons(void)
+{
+	SC1628D_STAT_CALL(SC1628D_CALL_GET_BUTTONS);
+
+	return scanKeys(5);
+}
+
+template <class BUS, class RENDER>
+void SC1628DCore<BUS, RENDER>::attachKeypad(SC1628DKeypad *keypad)
+{
+	m_keypad = keypad;
+}
+
+template <class BUS, class RENDER>
+bool SC1628DCore<BUS, RENDER>::setKeyScan(uint16_t interval, uint16_t ksMask)
+{
+	if (!m_keypad)
+		return false;
+	SC1628DKeypad &keypad = *m_keypad;
+
+	// KSn is read in bits 0/3 (K1) and 1/4 (K2) of the key byte (n-1)/2
+	keypad.m_mask = ksMask | ((uint32_t)ksMask << 16);
+	keypad.m_bytes = 0;
+	for (uint8_t n = 0; n < 10; n++)
+		if (ksMask & (1 << n))
+			keypad.m_bytes = n/2 + 1;
+
+	keypad.m_count = 0;
+	keypad.m_last = keypad.m_state;
+	keypad.m_held = 0xff;
+	keypad.m_scanTime = millis();
+	keypad.m_interval = interval;
+	return true;
+}
+
+template <class BUS, class RENDER>
+bool SC1628DCore<BUS, RENDER>::setKeyTiming(uint8_t debounce, uint16_t longPress, uint16_t repeat)
+{
+	if (!m_keypad)
+		return false;
+	m_keypad->setTiming(debounce, longPress, repeat);
+	return true;
+}
+
+template <class BUS, class RENDER>
+bool SC1628DCore<BUS, RENDER>::pollKeyEvent(SC1628DKeyEvent &event)
+{
+	if (!m_keypad || m_keypad->m_tail == m_keypad->m_head)
+		return false;
+	SC1628DKeypad &keypad = *m_keypad;
+	event = keypad.m_queue[keypad.m_tail];
+	keypad.m_tail = (keypad.m_tail + 1) & (SC1628D_KEY_QUEUE_SIZE - 1);
+	return true;
+}
+
+template <class BUS, class RENDER>
+void SC1628DCore<BUS, RENDER>::setAsync(bool async)
+{
+	if (!async)
+		flush();
+	m_async = async;
+}
+
+template <class BUS, class RENDER>
+bool SC1628DCore<BUS, RENDER>::tick(uint8_t bytes)
+{
+	SC1628D_STAT_CALL(SC1628D_CALL_TICK);
+
+	// Interrupting a display function or a key read: in synchronous mode the
+	// engines would send their frames between its STB edges, they run at the
+	// next tick() instead
+	if (m_busLock && !m_async)
+		return m_pending;
+
+	if (m_marquee && m_marquee->m_interval)
+		serviceMarquee();
+	if (m_animation && m_animation->m_frames)
+		serviceAnimation();
+	if (m_mailbox)
+		serviceMailbox();
+	if (m_dimmer && m_dimmer->m_dimmed)
+		serviceDimming();
+	if (m_blinker && m_blinker->m_positions)
+		serviceBlink();
+
+	// The last state of the display, once the refresh limit allows it
+	if (m_dirty && !m_busLock && refreshDue())
+		present();
+
+	// Key scans are done between frames
+	if (m_keypad && m_keypad->m_interval && m_txnPos == m_txnLen && !m_busLock)
+		serviceKeys();
+
+	// At a frame boundary, take the back buffer
+	if (m_txnPos == m_txnLen) {
+		if (!m_pending || m_busLock)
+			return m_pending;
+
+		uint16_t matrix[7];
+		noInterrupts();
+		for (uint8_t k = 0; k < 7; k++)
+			matrix[k] = m_back[k];
+		m_pending = false;
+		interrupts();
+		planFrame(matrix);
+	}
+	if (m_refreshBudget < 100) {
+		unsigned long start = micros();
+		bool done = runTxn(bytes, true);
+		m_refreshBusy += micros() - start;
+		return !done || m_pending;
+	}
+	return !runTxn(bytes, true) || m_pending;
+}
+
+template <class BUS, class RENDER>
+void SC1628DCore<BUS, RENDER>::flush()
+{
+	if (m_dirty)
+		present();
+	while (tick(SC1628D_TXN_SIZE))
+		;
+}
+
+template <class BUS, class RENDER>
+void SC1628DCore<BUS, RENDER>::setRefreshLimit(uint16_t interval, uint8_t budget)
+{
+	m_refreshInterval = interval;
+	m_refreshBudget = budget < 1 ? 1 : budget > 100 ? 100 : budget;
+	m_refreshTime = micros();
+	m_refreshBusy = 0;
+
+	// Without a limit, the display functions send the frames again
+	if (!interval && m_refreshBudget == 100 && m_dirty)
+		present();
+}
+
+template <class BUS, class RENDER>
+void SC1628DCore<BUS, RENDER>::begin()
+{
+	m_batch = true;
+	m_batchKeys = false;
+}
+
+template <class BUS, class RENDER>
+void SC1628DCore<BUS, RENDER>::requestButtons()
+{
+	m_batchKeys = true;
+}
+
+template <class BUS, class RENDER>
+uint32_t SC1628DCore<BUS, RENDER>::commit()
+{
+	m_batch = false;
+
+	// Nothing is sent for the parts of the frame the chip already has, and
+	// the batch is sent even under a refresh limit
+	present();
+	if (!m_batchKeys)
+		return 0;
+	m_batchKeys = false;
+	return scanKeys(5);
+}
+
+#ifdef SC1628D_STATS
+template <class BUS, class RENDER>
+void SC1628DCore<BUS, RENDER>::resetStats()
+{
+	memset(&m_stats, 0, sizeof(m_stats));
+}
+#endif
+
+
+//-----------------------------------------------------------------
+
+
+#ifdef SC1628D_TRACE
+// Write a value in hexadecimal, on a fixed number of digits
+inline void SC1628D_TraceHex(Print &out, uint32_t value, uint8_t digits)
+{
+	while (digits--) {
+		uint8_t nibble = (value >> (digits * 4)) & 0x0f;
+		out.write(nibble < 10 ? '0' + nibble : 'a' - 10 + nibble);
+	}
+}
+
+template <class BUS, class RENDER>
+inline void SC1628DCore<BUS, RENDER>::traceByte(uint8_t b)
+{
+	if (m_traceLen < SC1628D_TRACE_BYTES)
+		m_traceBytes[m_traceLen++] = b;
+	else
+		m_traceFlags |= SC1628D_TRACE_TRUNCATED;
+}
+
+template <class BUS, class RENDER>
+inline void SC1628DCore<BUS, RENDER>::tracePut(uint8_t b)
+{
+	m_trace[m_traceHead] = b;
+	if (++m_traceHead == SC1628D_TRACE_SIZE)
+		m_traceHead = 0;
+	m_traceUsed++;
+}
+
+// Record the transaction ending, overwriting the oldest ones when the buffer is full
+template <class BUS, class RENDER>
+void SC1628DCore<BUS, RENDER>::traceEnd(unsigned long elapsed)
+{
+	uint8_t size = SC1628D_TRACE_HEADER + m_traceLen;
+
+	while (SC1628D_TRACE_SIZE - m_traceUsed < size) {
+		uint8_t oldest = SC1628D_TRACE_HEADER + (m_trace[m_traceTail] & SC1628D_TRACE_LENGTH);
+		m_traceTail += oldest;
+		if (m_traceTail >= SC1628D_TRACE_SIZE)
+			m_traceTail -= SC1628D_TRACE_SIZE;
+		m_traceUsed -= oldest;
+		if (m_traceLost < 0xffff)
+			m_traceLost++;
+	}
+	if (elapsed > 0xffff)
+		elapsed = 0xffff;
+
+	tracePut(m_traceFlags | m_traceLen);
+	tracePut(m_traceStart);
+	tracePut(m_traceStart >> 8);
+	tracePut(m_traceStart >> 16);
+	tracePut(m_traceStart >> 24);
+	tracePut(elapsed);
+	tracePut(elapsed >> 8);
+	for (uint8_t i = 0; i < m_traceLen; i++)
+		tracePut(m_traceBytes[i]);
+}
+
+// Record the transactions of a replayed waveform, each one with a share of its bus time
+template <class BUS, class RENDER>
+void SC1628DCore<BUS, RENDER>::traceWaveform(const SC1628DWaveform &waveform, unsigned long start, unsigned long elapsed)
+{
+	const uint8_t *steps = waveform.steps();
+	uint8_t previous = SC1628D_WAVE_STB | SC1628D_WAVE_CLK;
+	uint8_t b = 0, bits = 0;
+	uint8_t count = waveform.transactions() ? waveform.transactions() : 1;
+
+	for (uint16_t i = 0; i < waveform.length(); i++) {
+		uint8_t changed = steps[i] ^ previous;
+		previous = steps[i];
+
+		if ((changed & SC1628D_WAVE_STB) && !(previous & SC1628D_WAVE_STB)) {
+			m_traceStart = start;
+			m_traceLen = 0;
+			m_traceFlags = 0;
+			bits = 0;
+		}
+		else if (changed & SC1628D_WAVE_STB)
+			traceEnd(elapsed / count);
+		else if ((changed & SC1628D_WAVE_CLK) && (previous & SC1628D_WAVE_CLK)) {
+			b = (b >> 1) | ((previous & SC1628D_WAVE_DIO) ? 0x80 : 0);
+			if (++bits == 8) {
+				traceByte(b);
+				bits = 0;
+			}
+		}
+	}
+}
+
+template <class BUS, class RENDER>
+void SC1628DCore<BUS, RENDER>::dumpTrace(Print &out)
+{
+	uint8_t record[SC1628D_TRACE_HEADER + SC1628D_TRACE_BYTES];
+	uint16_t lost;
+
+	noInterrupts();
+	lost = m_traceLost;
+	m_traceLost = 0;
+	interrupts();
+	if (lost) {
+		out.write('@');
+		out.write('L');
+		out.write(' ');
+		SC1628D_TraceHex(out, lost, 4);
+		out.println();
+	}
+
+	// tick() may record transactions from an interrupt: they are taken one at a time
+	for (;;) {
+		noInterrupts();
+		if (!m_traceUsed) {
+			interrupts();
+			break;
+		}
+		uint8_t size = SC1628D_TRACE_HEADER + (m_trace[m_traceTail] & SC1628D_TRACE_LENGTH);
+		for (uint8_t i = 0; i < size; i++) {
+			record[i] = m_trace[m_traceTail];
+			if (++m_traceTail == SC1628D_TRACE_SIZE)
+				m_traceTail = 0;
+		}
+		m_traceUsed -= size;
+		interrupts();
+
+		out.write('@');
+		out.write(record[0] & SC1628D_TRACE_READ ? 'R' : 'W');
+		out.write(' ');
+		SC1628D_TraceHex(out, record[1] | (uint32_t)record[2] << 8 | (uint32_t)record[3] << 16 | (uint32_t)record[4] << 24, 8);
+		out.write(' ');
+		SC1628D_TraceHex(out, record[5] | record[6] << 8, 4);
+		out.write(' ');
+		for (uint8_t i = SC1628D_TRACE_HEADER; i < size; i++)
+			SC1628D_TraceHex(out, record[i], 2);
+		if (record[0] & SC1628D_TRACE_TRUNCATED)
+			out.write('+');
+		out.println();
+	}
+}
+
+template <class BUS, class RENDER>
+void SC1628DCore<BUS, RENDER>::clearTrace()
+{
+	noInterrupts();
+	m_traceHead = 0;
+	m_traceTail = 0;
+	m_traceUsed = 0;
+	m_traceLost = 0;
+	interrupts();
+}
+#endif
+
+
+template <class BUS, class RENDER>
+void SC1628DCore<BUS, RENDER>::start()
+{
+	SC1628D_STAT(m_stats.commands++);
+	SC1628D_STAT(m_statStart = micros());
+#ifdef SC1628D_TRACE
+	m_traceStart = micros();
+	m_traceLen = 0;
+	m_traceFlags = 0;
+#endif
+	BUS::start();
+}
+
+template <class BUS, class RENDER>
+void SC1628DCore<BUS, RENDER>::stop()
+{
+	BUS::stop();
+#ifdef SC1628D_STATS
+	unsigned long elapsed = micros() - m_statStart;
+	m_stats.busMicros += elapsed;
+	if (elapsed > m_stats.busMaxMicros)
+		m_stats.busMaxMicros = elapsed;
+#endif
+#ifdef SC1628D_TRACE
+	traceEnd(micros() - m_traceStart);
+#endif
+}
+
+template <class BUS, class RENDER>
+void SC1628DCore<BUS, RENDER>::writeCommand(uint8_t b)
+{
+	SC1628D_STAT(m_stats.bytes++);
+	SC1628D_STAT(m_stats.bits += 8);
+#ifdef SC1628D_TRACE
+	traceByte(b);
+#endif
+	BUS::writeByte(b);
+}
+
+template <class BUS, class RENDER>
+void SC1628DCore<BUS, RENDER>::writeData(uint16_t b)
+{
+	SC1628D_STAT(m_stats.bytes += 2);
+	SC1628D_STAT(m_stats.bits += 16);
+#ifdef SC1628D_TRACE
+	traceByte(b & 0xff);
+	traceByte(b >> 8);
+#endif
+	BUS::writeWord(b);
+}
+
+template <class BUS, class RENDER>
+void SC1628DCore<BUS, RENDER>::writeMatrix(const uint16_t matrix[])
+{
+	bool taken = acquireBus();
+
+	// Complete the program left by tick() before replacing it
+	runTxn(SC1628D_TXN_SIZE);
+	m_txnLen = m_txnPos = 0;
+	planMatrix(matrix);
+	runTxn(SC1628D_TXN_SIZE);
+	releaseBus(taken);
+}
+
+template <class BUS, class RENDER>
+uint8_t SC1628DCore<BUS, RENDER>::receiveData(bool first)
+{
+	SC1628D_STAT(m_stats.bytes++);
+	SC1628D_STAT(m_stats.bits += 8);
+#ifdef SC1628D_TRACE
+	uint8_t b = BUS::readByte(first);
+	m_traceFlags |= SC1628D_TRACE_READ;
+	traceByte(b);
+	return b;
+#else
+	return BUS::readByte(first);
+#endif
+}
+
+
+
+
+//-----------------------------------------------------------------
+
+
+// Render all the positions, with the layout or the filter
+template <class BUS, class RENDER>
+void SC1628DCore<BUS, RENDER>::render(uint8_t segments[], uint16_t matrix[])
+{
+	memset(matrix, 0, 7 * sizeof(matrix[0]));
+	if (RENDER::positional())
+		for (uint8_t pos = 0; pos < 5; pos++)
+			RENDER::renderPosition(pos, segments[pos], matrix);
+	else
+		RENDER::filter(segments, matrix);
+}
+
+// Render the modified positions and refresh the display
+template <class BUS, class RENDER>
+void SC1628DCore<BUS, RENDER>::update(uint8_t pos, uint8_t length)
+{
+	// The positions past the layout table are never rendered
+	if (pos > 4)
+		length = 0;
+	else if (length > 5 - pos)
+		length = 5 - pos;
+	if (RENDER::positional())
+		for (uint8_t i = 0; i < length; i++)
+			RENDER::renderPosition(pos + i, m_segments[pos + i], m_render);
+	else
+		RENDER::filter(m_segments, m_render);
+	if (!m_batch)
+		output();
+}
+
+// Send the composed frame, or leave it to tick() under a refresh limit
+template <class BUS, class RENDER>
+void SC1628DCore<BUS, RENDER>::output()
+{
+	if (m_refreshInterval || m_refreshBudget < 100) {
+		m_dirty = true;
+		return;
+	}
+	present();
+}
+
+// Send the composed frame now
+template <class BUS, class RENDER>
+void SC1628DCore<BUS, RENDER>::present()
+{
+	m_dirty = false;
+	if (m_refreshInterval || m_refreshBudget < 100) {
+		m_refreshTime = micros();
+		m_refreshBusy = 0;
+	}
+	if ((!m_dimmer || (!m_dimmer->m_dimmed && m_dimmer->m_lit == 0x1f)) && (!m_blinker || !m_blinker->m_off)) {
+		refresh(m_render);
+		return;
+	}
+	uint16_t matrix[7];
+	compose(matrix);
+	refresh(matrix);
+}
+
+// Output stage: the rendered segments, without the positions blanked in this
+// sub-frame and the segments blinking off
+template <class BUS, class RENDER>
+void SC1628DCore<BUS, RENDER>::compose(uint16_t matrix[])
+{
+	uint8_t lit = litPositions();
+	uint8_t blink = m_blinker && m_blinker->m_off ? m_blinker->m_positions : 0;
+
+	if (m_dimmer)
+		m_dimmer->m_lit = lit;
+	for (uint8_t k = 0; k < 7; k++)
+		matrix[k] = m_render[k];
+	if (lit == 0x1f && !blink)
+		return;
+
+	if (RENDER::positional()) {
+		for (uint8_t pos = 0; pos < 5; pos++)
+			if (!(lit & (1 << pos)))
+				RENDER::renderPosition(pos, 0, matrix);
+			else if (blink & (1 << pos))
+				RENDER::renderPosition(pos, m_segments[pos] & ~m_blinker->m_segments[pos], matrix);
+	}
+	else {
+		uint8_t segments[5];
+		for (uint8_t pos = 0; pos < 5; pos++)
+			segments[pos] = (lit & (1 << pos)) ? m_segments[pos] & ~(blink & (1 << pos) ? m_blinker->m_segments[pos] : 0) : 0;
+		RENDER::filter(segments, matrix);
+	}
+}
+
+// The refresh limit allows a new frame: the interval has elapsed, and the bus
+// time since the previous frame is under the budget
+template <class BUS, class RENDER>
+bool SC1628DCore<BUS, RENDER>::refreshDue()
+{
+	unsigned long elapsed = micros() - m_refreshTime;
+
+	if (elapsed < (unsigned long)m_refreshInterval * 1000)
+		return false;
+	return elapsed >= m_refreshBusy * 100UL / m_refreshBudget;
+}
+
+// Positions shown in the current sub-frame
+template <class BUS, class RENDER>
+uint8_t SC1628DCore<BUS, RENDER>::litPositions()
+{
+	uint8_t lit = 0x1f;
+
+	if (!m_dimmer)
+		return lit;
+	for (uint8_t pos = 0; pos < 5; pos++)
+		if (m_dimmer->m_phase >= m_dimmer->m_level[pos])
+			lit &= ~(1 << pos);
+	return lit;
+}
+
+// Next sub-frame of the dimming cycle, only sent when a position changes state
+template <class BUS, class RENDER>
+void SC1628DCore<BUS, RENDER>::serviceDimming()
+{
+	SC1628DDimmer &dim = *m_dimmer;
+	unsigned long now = micros();
+
+	if (now - dim.m_time < dim.m_period)
+		return;
+	dim.m_time += dim.m_period;
+	if (now - dim.m_time >= dim.m_period)
+		dim.m_time = now;
+
+	if (++dim.m_phase == SC1628D_DIM_LEVELS)
+		dim.m_phase = 0;
+
+	// The sub-frames are timed by the dimming cycle, not by the refresh limit
+	if (litPositions() != dim.m_lit && !m_batch)
+		present();
+}
+
+// Next part of the blink period, only the blinking segments change
+template <class BUS, class RENDER>
+void SC1628DCore<BUS, RENDER>::serviceBlink()
+{
+	SC1628DBlinker &blink = *m_blinker;
+	unsigned long now = millis();
+	uint16_t part = blink.m_off ? blink.m_period - blink.m_on : blink.m_on;
+
+	if (now - blink.m_time < part)
+		return;
+	blink.m_time += part;
+	if (now - blink.m_time >= blink.m_period)
+		blink.m_time = now;
+	blink.m_off = !blink.m_off;
+
+	// As the dimming sub-frames, the phases are not delayed by the refresh limit
+	if (!m_batch)
+		present();
+}
+
+// Render a number on the digits 0 to 3, and the colon for a fixed point number
+template <class BUS, class RENDER>
+void SC1628DCore<BUS, RENDER>::displayNumeric(int32_t value, uint8_t format)
+{
+	uint8_t length = (format & SC1628D_NUMBER_FIXED) ? SC1628D_NUMBER_DIGITS + 1 : SC1628D_NUMBER_DIGITS;
+
+	if (value != m_numberValue || format != m_numberFormat) {
+		uint8_t digits[SC1628D_NUMBER_DIGITS];
+		uint8_t shown;			// Digits shown even when 0
+		bool negative = false;
+		uint16_t n;
+
+		if (format & SC1628D_NUMBER_HEX)
+			n = (uint16_t)value;
+		else if (value > 9999 || value < -999 || (value < 0 && (format & SC1628D_NUMBER_DECIMALS) == 3)) {
+			// Out of range, or no room for the minus sign before the 4 digits of "0.123"
+			n = 0;
+			format |= SC1628D_NUMBER_OVERFLOW;
+		}
+		else {
+			negative = value < 0;
+			n = negative ? -value : value;
+		}
+
+		// Digits extraction without division: n/10 is (n * 0xCCCD) >> 19 for n < 81920
+		for (uint8_t i = SC1628D_NUMBER_DIGITS; i-- > 0; ) {
+			if (format & SC1628D_NUMBER_HEX) {
+				digits[i] = n & 0x0f;
+				n >>= 4;
+			}
+			else {
+				uint16_t q = ((uint32_t)n * 0xCCCD) >> 19;
+				digits[i] = n - q * 10;
+				n = q;
+			}
+		}
+
+		// Leading zeros are blanked, and replaced by the minus sign
+		shown = (format & SC1628D_NUMBER_ZERO_PAD) ? SC1628D_NUMBER_DIGITS : (format & SC1628D_NUMBER_DECIMALS) + 1;
+		uint8_t first = 0;
+		while (first < SC1628D_NUMBER_DIGITS - shown && digits[first] == 0)
+			digits[first++] = DIGIT_BLANK;
+		if (negative)
+			digits[first ? first - 1 : 0] = DIGIT_MINUS;
+
+		for (uint8_t i = 0; i < SC1628D_NUMBER_DIGITS; i++)
+			m_numberSegments[i] = RENDER::glyph((format & SC1628D_NUMBER_OVERFLOW) ? DIGIT_MINUS : digits[i]);
+		m_numberSegments[SC1628D_SYM_POS] = ((format & SC1628D_NUMBER_DECIMALS) == 2) ? SC1628D_SYM_COLON : 0;
+
+		m_numberValue = value;
+		m_numberFormat = format & ~SC1628D_NUMBER_OVERFLOW;
+	}
+
+	// The same value, still on the display: nothing to do
+	uint8_t changed = 0;
+	for (uint8_t i = 0; i < SC1628D_NUMBER_DIGITS; i++) {
+		changed |= m_segments[i] ^ m_numberSegments[i];
+		m_segments[i] = m_numberSegments[i];
+	}
+	if (length > SC1628D_NUMBER_DIGITS) {
+		uint8_t symbols = (m_segments[SC1628D_SYM_POS] & ~SC1628D_SYM_COLON) | m_numberSegments[SC1628D_SYM_POS];
+		changed |= m_segments[SC1628D_SYM_POS] ^ symbols;
+		m_segments[SC1628D_SYM_POS] = symbols;
+	}
+	if (changed)
+		update(0, length);
+}
+
+// Render a text on the digits pos to 3, '.' and ':' on the colon
+template <class BUS, class RENDER>
+void SC1628DCore<BUS, RENDER>::displayString(const char text[], uint8_t pos, bool flash)
+{
+	uint8_t segments[SC1628D_NUMBER_DIGITS];
+	uint8_t symbols = m_segments[SC1628D_SYM_POS] & ~SC1628D_SYM_COLON;
+
+	// The digits before pos are kept
+	for (uint8_t i = 0; i < SC1628D_NUMBER_DIGITS; i++)
+		segments[i] = i < pos ? m_segments[i] : 0;
+	for (;;) {
+		uint8_t c = flash ? pgm_read_byte(text) : *text;
+		if (!c)
+			break;
+		text++;
+		if (c == '.' || c == ':')
+			symbols |= SC1628D_SYM_COLON;
+		else if (pos < SC1628D_NUMBER_DIGITS) {
+			// Direct lookup, the characters out of the table are blank
+			if (c >= ' ' && c <= '~')
+				segments[pos] = RENDER::asciiGlyph(c);
+			pos++;
+		}
+	}
+
+	// The same text, still on the display: nothing to do
+	uint8_t changed = m_segments[SC1628D_SYM_POS] ^ symbols;
+	m_segments[SC1628D_SYM_POS] = symbols;
+	for (uint8_t i = 0; i < SC1628D_NUMBER_DIGITS; i++) {
+		changed |= m_segments[i] ^ segments[i];
+		m_segments[i] = segments[i];
+	}
+	if (changed)
+		update(0, SC1628D_NUMBER_DIGITS + 1);
+}
+
+// Send a frame now, or leave it to tick() in asynchronous mode
+template <class BUS, class RENDER>
+void SC1628DCore<BUS, RENDER>::refresh(const uint16_t matrix[])
+{
+	if (m_async) {
+		noInterrupts();
+		for (uint8_t k = 0; k < 7; k++)
+			m_back[k] = matrix[k];
+		m_pending = true;
+		interrupts();
+		return;
+	}
+
+	bool taken = acquireBus();
+	planFrame(matrix);
+	if (m_refreshBudget < 100) {
+		unsigned long start = micros();
+		runTxn(SC1628D_TXN_SIZE);
+		m_refreshBusy += micros() - start;
+	}
+	else
+		runTxn(SC1628D_TXN_SIZE);
+	releaseBus(taken);
+}
+
+// Append to the program the display RAM writes needed to show a matrix
+template <class BUS, class RENDER>
+void SC1628DCore<BUS, RENDER>::planMatrix(const uint16_t matrix[])
+{
+	uint8_t changed = 0;
+
+	// The display RAM is written only when it differs from the last frame sent
+	if (m_matrixValid) {
+		for (uint8_t k = 0; k < 7; k++) {
+			uint16_t diff = matrix[k] ^ m_matrix[k];
+			if (diff & 0x00ff) changed++;
+			if (diff & 0xff00) changed++;
+		}
+		if (changed == 0)
+			return;
+	}
+
+	if (!m_matrixValid || changed > SC1628D_DELTA_MAX_BYTES) {
+	    // Command 2: Set Write data to display, in incremental mode
+		planCommand(m_dataSetting, SC1628D_DATA_SETTING_CMD_WRITE | SC1628D_2_INCREMENT_ADDR);
+
+		// Command 3: Set write address + digits data
+		txnAdd(SC1628D_OP_START | SC1628D_ADDRESS_SETTING_CMD);
+		for (uint8_t k = 0; k < 7; k++) {
+			txnAdd(matrix[k] & 0xff);
+			txnAdd(matrix[k] >> 8);
+		}
+	}
+	else {
+		// Command 2: Set Write data to display, in fixed address mode
+		planCommand(m_dataSetting, SC1628D_DATA_SETTING_CMD_WRITE | SC1628D_2_FIXED_ADDR);
+
+		// Command 3: Set write address + one data byte, for each modified byte
+		for (uint8_t k = 0; k < 7; k++) {
+			uint16_t diff = matrix[k] ^ m_matrix[k];
+			if (diff & 0x00ff) {
+				txnAdd(SC1628D_OP_START | (SC1628D_ADDRESS_SETTING_CMD + 2*k));
+				txnAdd(matrix[k] & 0xff);
+			}
+			if (diff & 0xff00) {
+				txnAdd(SC1628D_OP_START | (SC1628D_ADDRESS_SETTING_CMD + 2*k + 1));
+				txnAdd(matrix[k] >> 8);
+			}
+		}
+	}
+
+	// The program is always run to its end: the RAM will hold this matrix
+	for (uint8_t k = 0; k < 7; k++)
+		m_matrix[k] = matrix[k];
+	m_matrixValid = true;
+}
+
+// Build the program of a complete display refresh
+template <class BUS, class RENDER>
+void SC1628DCore<BUS, RENDER>::planFrame(const uint16_t matrix[])
+{
+	SC1628D_STAT(m_stats.frames++);
+	m_txnLen = m_txnPos = 0;
+	planMatrix(matrix);
+
+	// Command 1: Set display mode (default: 7 grids - 11 segments)
+	planCommand(m_mode, SC1628D_DISPLAY_MODE_CMD | SC1628D_7GRID_11SEG);
+
+	// Command 4: Set Display on/off + Brightness
+	planCommand(m_control, SC1628D_DISPLAY_CONTROL_CMD | (m_brightness & 0x0f));
+}
+
+// Append a single byte command to the program, unless the chip already has it
+template <class BUS, class RENDER>
+void SC1628DCore<BUS, RENDER>::planCommand(uint8_t &state, uint8_t command)
+{
+	if (state == command)
+		return;
+	txnAdd(SC1628D_OP_START | command);
+	state = command;
+}
+
+template <class BUS, class RENDER>
+void SC1628DCore<BUS, RENDER>::txnAdd(uint16_t op)
+{
+	if (m_txnLen == 0)
+		m_txnStart = 0;
+	if (op & SC1628D_OP_START)
+		m_txnStart |= (uint32_t)1 << m_txnLen;
+	m_txn[m_txnLen++] = op;
+}
+
+// Run up to count entries of the program, return true when it is complete
+template <class BUS, class RENDER>
+bool SC1628DCore<BUS, RENDER>::runTxn(uint8_t count, bool yield)
+{
+	while (m_txnPos < m_txnLen && count > 0) {
+		bool first = m_txnStart & ((uint32_t)1 << m_txnPos);
+
+		// A new transaction is not started while getButtons() holds the bus
+		if (yield && m_busLock && first)
+			break;
+		count--;
+
+		if (first) {
+			start();
+			m_txnOpen = true;
+		}
+		writeCommand(m_txn[m_txnPos++]);
+		if (m_txnPos == m_txnLen || (m_txnStart & ((uint32_t)1 << m_txnPos))) {
+			stop();
+			m_txnOpen = false;
+		}
+	}
+	return m_txnPos == m_txnLen;
+}
+
+// Get exclusive use of the bus, tick() may be running from an interrupt
+//
+// Return false when the bus is already held by an outer call, which keeps
+// the lock until its own releaseBus()
+template <class BUS, class RENDER>
+bool SC1628DCore<BUS, RENDER>::acquireBus()
+{
+	noInterrupts();
+	bool taken = !m_busLock;
+	m_busLock = true;
+
+	// Complete the transaction left open by tick(): STB must go high before a new command
+	while (m_txnOpen)
+		runTxn(1);
+	interrupts();
+	return taken;
+}
+
+template <class BUS, class RENDER>
+void SC1628DCore<BUS, RENDER>::releaseBus(bool taken)
+{
+	if (taken)
+		m_busLock = false;
+}
+
+// Read the first key bytes, return the buttons mask
+template <class BUS, class RENDER>
+uint32_t SC1628DCore<BUS, RENDER>::scanKeys(uint8_t bytes)
+{
+	// Keyscan data on the SC1628 is 2x10 keys, received as an array of 5 bytes (same as TM1668).
+	// Of each byte the bits B0/B3 and B1/B4 represent status of the connection of K1 and K2 to KS1-KS10
+	// Byte1[0-1]: KS1xK1, KS1xK2
+	// The return value is a 32 bit value containing button scans for both K1 and K2, the high word is for K2 and the low word for K1.
+	uint8_t keys[5];
+	uint32_t buttons = 0;
+
+	readKeys(keys, bytes);
+	for (uint8_t i = 0; i < bytes; i++)
+		buttons |= SC1628D_KeyButtons(keys[i], i);
+	return buttons;
+}
+
+// Read the first key bytes
+template <class BUS, class RENDER>
+void SC1628DCore<BUS, RENDER>::readKeys(uint8_t keys[], uint8_t bytes)
+{
+	SC1628D_STAT(m_stats.keyScans++);
+	bool taken = acquireBus();
+	start();
+	writeCommand(SC1628D_DATA_SETTING_CMD_READ);		// send read buttons command
+	for (uint8_t i = 0; i < bytes; i++)
+		keys[i] = receiveData(i == 0);
+	stop();
+
+	// Between two transactions of a frame sent by tick(), the data setting
+	// of the frame is restored for its remaining RAM writes
+	if (m_txnPos < m_txnLen && m_dataSetting != 0xff && m_dataSetting != SC1628D_DATA_SETTING_CMD_READ) {
+		start();
+		writeCommand(m_dataSetting);
+		stop();
+	}
+	else
+		m_dataSetting = SC1628D_DATA_SETTING_CMD_READ;
+	releaseBus(taken);
+}
+
+// Scheduled key scan: debounce and queue the key events
+template <class BUS, class RENDER>
+void SC1628DCore<BUS, RENDER>::serviceKeys()
+{
+	SC1628DKeypad &keypad = *m_keypad;
+	unsigned long now = millis();
+
+	// Long press and repeat of the last pressed key
+	if (keypad.m_held != 0xff && (long)(now - keypad.m_heldTime) >= 0) {
+		keypad.queue(keypad.m_repeating ? SC1628D_KEY_REPEAT : SC1628D_KEY_LONG, keypad.m_held);
+		keypad.m_repeating = true;
+		if (keypad.m_repeat)
+			keypad.m_heldTime = now + keypad.m_repeat;
+		else
+			keypad.m_held = 0xff;
+	}
+
+	if (now - keypad.m_scanTime < keypad.m_interval)
+		return;
+	keypad.m_scanTime = now;
+
+	// Debounce: the same keys must be read m_debounce times in a row
+	uint32_t keys = scanKeys(keypad.m_bytes) & keypad.m_mask;
+	if (keys != keypad.m_last) {
+		keypad.m_last = keys;
+		keypad.m_count = 0;
+	}
+	if (keypad.m_count < keypad.m_debounce)
+		keypad.m_count++;
+	if (keypad.m_count < keypad.m_debounce || keys == keypad.m_state)
+		return;
+
+	// A stable change: one event per modified key
+	uint32_t changed = keys ^ keypad.m_state;
+	keypad.m_state = keys;
+	for (uint8_t k = 0; k < 32; k++) {
+		if (!(changed & ((uint32_t)1 << k)))
+			continue;
+		if (keys & ((uint32_t)1 << k)) {
+			keypad.queue(SC1628D_KEY_PRESS, k);
+			if (keypad.m_long) {
+				keypad.m_held = k;
+				keypad.m_heldTime = now + keypad.m_long;
+				keypad.m_repeating = false;
+			}
+		}
+		else {
+			keypad.queue(SC1628D_KEY_RELEASE, k);
+			if (k == keypad.m_held)
+				keypad.m_held = 0xff;
+		}
+	}
+}
+
+// Start scrolling from a blank display area
+template <class BUS, class RENDER>
+bool SC1628DCore<BUS, RENDER>::startMarquee(const uint8_t text[], uint16_t length, uint16_t interval, uint8_t width, bool repeat, bool digits)
+{
+	if (!m_marquee)
+		return false;
+	SC1628DMarquee &marquee = *m_marquee;
+	if (width == 0 || width > 5)
+		width = 5;
+	marquee.m_text = text;
+	marquee.m_length = length;
+	marquee.m_pos = 0;
+	marquee.m_width = width;
+	marquee.m_repeat = repeat;
+	marquee.m_digits = digits;
+	marquee.m_time = millis();
+	marquee.m_interval = interval ? interval : 1;
+
+	memset(m_segments, 0, width);
+	update(0, width);
+	return true;
+}
+
+// Marquee step: shift the display area left, the next position entering on the right
+template <class BUS, class RENDER>
+void SC1628DCore<BUS, RENDER>::serviceMarquee()
+{
+	SC1628DMarquee &marquee = *m_marquee;
+	unsigned long now = millis();
+
+	if (now - marquee.m_time < marquee.m_interval)
+		return;
+	marquee.m_time = now;
+
+	uint8_t last = marquee.m_width - 1;
+	uint8_t entering = 0;
+	if (marquee.m_pos < marquee.m_length) {
+		entering = marquee.m_text[marquee.m_pos];
+		if (marquee.m_digits)
+			entering = RENDER::glyph(entering);
+	}
+	memmove(m_segments, m_segments + 1, last);
+	m_segments[last] = entering;
+	update(0, marquee.m_width);
+
+	// The string has left the display
+	if (++marquee.m_pos == marquee.m_length + marquee.m_width) {
+		marquee.m_pos = 0;
+		if (!marquee.m_repeat)
+			marquee.m_interval = 0;
+	}
+}
+
+// Show the first frame now
+template <class BUS, class RENDER>
+void SC1628DCore<BUS, RENDER>::startAnimation(const void *frames, uint16_t count, uint8_t mode)
+{
+	SC1628DAnimation &anim = *m_animation;
+	anim.m_frames = count ? frames : NULL;
+	anim.m_count = count;
+	anim.m_index = 0;
+	anim.m_step = 1;
+	anim.m_mode = mode;
+	anim.m_deadline = millis();
+	serviceAnimation();
+}
+
+// Show the next frame at the deadline of the current one
+template <class BUS, class RENDER>
+void SC1628DCore<BUS, RENDER>::serviceAnimation()
+{
+	SC1628DAnimation &anim = *m_animation;
+	unsigned long now = millis();
+	uint16_t duration;
+
+	if ((long)(now - anim.m_deadline) < 0)
+		return;
+
+	// Played once: stopped at the end of the last frame
+	if (anim.m_index >= anim.m_count) {
+		anim.m_frames = NULL;
+		return;
+	}
+
+	if (anim.m_length) {
+		const SC1628DFrame *frame = (const SC1628DFrame *)anim.m_frames + anim.m_index;
+		duration = pgm_read_word(&frame->duration);
+		for (uint8_t i = anim.m_pos; i < anim.m_pos + anim.m_length; i++)
+			m_segments[i] = pgm_read_byte(&frame->segments[i]);
+		update(anim.m_pos, anim.m_length);
+	}
+	else {
+		// Sent as it is, m_render keeps the matrix of the segments
+		const SC1628DMatrixFrame *frame = (const SC1628DMatrixFrame *)anim.m_frames + anim.m_index;
+		uint16_t matrix[7];
+		duration = pgm_read_word(&frame->duration);
+		for (uint8_t k = 0; k < 7; k++)
+			matrix[k] = pgm_read_word(&frame->matrix[k]);
+		refresh(matrix);
+	}
+
+	// The next deadline is computed from the previous one, unless more than a frame late
+	anim.m_deadline += duration;
+	if ((long)(now - anim.m_deadline) >= 0)
+		anim.m_deadline = now + duration;
+
+	if (anim.m_mode == SC1628D_ANIM_PINGPONG && anim.m_count > 1) {
+		if ((anim.m_step > 0 && anim.m_index == anim.m_count - 1) || (anim.m_step < 0 && anim.m_index == 0))
+			anim.m_step = -anim.m_step;
+		anim.m_index += anim.m_step;
+	}
+	else if (++anim.m_index == anim.m_count && anim.m_mode != SC1628D_ANIM_ONCE)
+		anim.m_index = 0;
+}
+
+// Display the latest frame published, if any
+template <class BUS, class RENDER>
+void SC1628DCore<BUS, RENDER>::serviceMailbox()
+{
+	if (m_mailbox->take(m_segments))
+		update(0, 5);
+}
+
+#endif // __SC1628D_CORE__
@@ -0,0 +1,413 @@
+/*
+ *  SC1628DGroup.cpp
+ *
+ *  Arduino Library for the SC1628D LED Driver IC
+ *  Parallel refresh of several modules sharing the clock line
+ *
+ *  (c) 2022/07/13 philippe.corbes@gmail.com
+ *
+ *  This library is free software; you can redistribute it and/or
+ *  modify it under the terms of the GNU Lesser General Public
+ *  License as published by the Free Software Foundation; either
+ *  version 2.1 of the License, or (at your option) any later version.
+ *
+ *  This library is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ *  Lesser General Public License for more details.
+ *
+ *  You should have received a copy of the GNU Lesser General Public
+ *  License along with this library; if not, write to the Free Software
+ *  Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  USA
+ */
+
+#include <SC1628DGroup.h>
+#include <Arduino.h>
+#include <string.h>
+
+
+SC1628DGroup::SC1628DGroup(uint8_t pinSTB, uint8_t pinCLK, const uint8_t pinDIO[], uint8_t count, unsigned int bitDelay)
+{
+	m_stbCount = 1;
+	m_pinSTB[0].init(pinSTB);
+	init(pinCLK, pinDIO, count, bitDelay);
+}
+
+SC1628DGroup::SC1628DGroup(const uint8_t pinSTB[], uint8_t pinCLK, const uint8_t pinDIO[], uint8_t count, unsigned int bitDelay)
+{
+	if (count > SC1628D_GROUP_MAX)
+		count = SC1628D_GROUP_MAX;
+	m_stbCount = count;
+	for (uint8_t m = 0; m < count; m++)
+		m_pinSTB[m].init(pinSTB[m]);
+	init(pinCLK, pinDIO, count, bitDelay);
+}
+
+void SC1628DGroup::init(uint8_t pinCLK, const uint8_t pinDIO[], uint8_t count, unsigned int bitDelay)
+{
+	if (count > SC1628D_GROUP_MAX)
+		count = SC1628D_GROUP_MAX;
+	m_count = count;
+	m_all = (uint8_t)((1 << count) - 1);
+
+	// The same delay for every step
+	uint16_t ns = bitDelay > 65 ? 65000 : bitDelay * 1000;
+	SC1628DTiming timing = { ns, ns, ns, ns, ns, ns };
+	setTiming(timing);
+
+	m_pinCLK.init(pinCLK);
+	for (uint8_t m = 0; m < count; m++)
+		m_pinDIO[m].init(pinDIO[m]);
+
+#ifdef SC1628D_FAST_GPIO
+	// Every edge is a single port write when all the pins share the same port
+	m_fast = m_pinCLK.mask != 0;
+	m_stbMask = 0;
+	m_dioAll = 0;
+	for (uint8_t m = 0; m < m_stbCount; m++) {
+		m_fast = m_fast && m_pinSTB[m].mask && m_pinSTB[m].out == m_pinCLK.out;
+		m_stbMask |= m_pinSTB[m].mask;
+	}
+	for (uint8_t m = 0; m < count; m++) {
+		m_fast = m_fast && m_pinDIO[m].mask && m_pinDIO[m].out == m_pinCLK.out;
+		m_dioAll |= m_pinDIO[m].mask;
+	}
+#endif
+
+	// Set the default value and pin direction, levels first so that STB and CLK do not glitch low
+	for (uint8_t m = 0; m < m_stbCount; m++) {
+		digitalWrite(m_pinSTB[m].pin, HIGH);
+		pinMode(m_pinSTB[m].pin, OUTPUT);
+	}
+	digitalWrite(m_pinCLK.pin, HIGH);
+	pinMode(m_pinCLK.pin, OUTPUT);
+	for (uint8_t m = 0; m < count; m++) {
+		digitalWrite(m_pinDIO[m].pin, HIGH);
+		pinMode(m_pinDIO[m].pin, OUTPUT);
+	}
+
+	m_layout = &SC1628D_NORMAL_LAYOUT;
+	m_layoutFlash = true;
+	m_font = SC1628D_NORMAL_FONT;
+	m_fontFlash = true;
+	m_brightness = 0x0f;
+	memset(m_segments, 0, sizeof(m_segments));
+	m_matrixValid = false;
+	m_mode = 0xff;
+	m_dataSetting = 0xff;
+	m_control = 0xff;
+}
+
+void SC1628DGroup::setTiming(const SC1628DTiming &timing)
+{
+	m_low.set(timing.clockLow > timing.setup ? timing.clockLow : timing.setup);
+	m_high.set(timing.clockHigh > timing.hold ? timing.clockHigh : timing.hold);
+	m_strobe.set(timing.strobe);
+	m_wait.set(timing.wait);
+}
+
+void SC1628DGroup::setBrightness(uint8_t brightness, bool on)
+{
+	m_brightness = (brightness & 0x7) | (on? 0x08 : 0x00);
+}
+
+void SC1628DGroup::setLayout(const SC1628DLayout &layout)
+{
+	m_layout = &layout;
+	m_layoutFlash = &layout == &SC1628D_NORMAL_LAYOUT;
+#ifndef SC1628D_NO_INVERTED
+	m_layoutFlash = m_layoutFlash || &layout == &SC1628D_INVERTED_LAYOUT;
+#endif
+}
+
+void SC1628DGroup::setLayout_P(const SC1628DLayout &layout)
+{
+	m_layout = &layout;
+	m_layoutFlash = true;
+}
+
+void SC1628DGroup::setFont(const uint8_t font[])
+{
+	m_font = font;
+	m_fontFlash = font == SC1628D_NORMAL_FONT;
+#ifndef SC1628D_NO_INVERTED
+	m_fontFlash = m_fontFlash || font == SC1628D_INVERTED_FONT;
+#endif
+}
+
+void SC1628DGroup::setFont_P(const uint8_t font[])
+{
+	m_font = font;
+	m_fontFlash = true;
+}
+
+void SC1628DGroup::displayDigits(uint8_t module, const uint8_t digits[], uint8_t pos, uint8_t length)
+{
+	if (module >= m_count || pos > 4)
+		return;
+	if (length > 5 - pos)
+		length = 5 - pos;
+	for (uint8_t i = 0; i < length; i++)
+		m_segments[module][pos + i] = m_fontFlash ? pgm_read_byte(&m_font[digits[i]]) : m_font[digits[i]];
+}
+
+void SC1628DGroup::displaySegments(uint8_t module, const uint8_t segments[], uint8_t pos, uint8_t length)
+{
+	if (module >= m_count || pos > 4)
+		return;
+	if (length > 5 - pos)
+		length = 5 - pos;
+	for (uint8_t i = 0; i < length; i++)
+		m_segments[module][pos + i] = segments[i];
+}
+
+void SC1628DGroup::refresh()
+{
+	uint8_t data[SC1628D_GROUP_MAX];
+	uint16_t diff[7];
+	uint8_t changed = 0;
+
+	for (uint8_t m = 0; m < m_count; m++) {
+		if (m_layoutFlash)
+			SC1628D_RenderLayout_P(*m_layout, m_segments[m], m_render[m]);
+		else
+			SC1628D_RenderLayout(*m_layout, m_segments[m], m_render[m]);
+	}
+
+	// A RAM byte is written when it changed on any module
+	for (uint8_t k = 0; k < 7; k++) {
+		diff[k] = 0;
+		for (uint8_t m = 0; m < m_count; m++)
+			diff[k] |= m_render[m][k] ^ m_matrix[m][k];
+		if (diff[k] & 0x00ff) changed++;
+		if (diff[k] & 0xff00) changed++;
+	}
+
+	if (!m_matrixValid || changed > SC1628D_DELTA_MAX_BYTES) {
+	    // Command 2: Set Write data to display, in incremental mode
+		sendCommand(m_dataSetting, SC1628D_DATA_SETTING_CMD_WRITE | SC1628D_2_INCREMENT_ADDR);
+
+		// Command 3: Set write address + digits data
+		start();
+		writeCommand(SC1628D_ADDRESS_SETTING_CMD);
+		for (uint8_t k = 0; k < 7; k++) {
+			for (uint8_t m = 0; m < m_count; m++)
+				data[m] = m_render[m][k] & 0xff;
+			writeBytes(data);
+			for (uint8_t m = 0; m < m_count; m++)
+				data[m] = m_render[m][k] >> 8;
+			writeBytes(data);
+		}
+		stop();
+	}
+	else if (changed) {
+		// Command 2: Set Write data to display, in fixed address mode
+		sendCommand(m_dataSetting, SC1628D_DATA_SETTING_CMD_WRITE | SC1628D_2_FIXED_ADDR);
+
+		// Command 3: Set write address + one data byte, for each modified byte
+		for (uint8_t a = 0; a < 14; a++) {
+			uint8_t shift = (a & 1) ? 8 : 0;
+			if (((diff[a >> 1] >> shift) & 0xff) == 0)
+				continue;
+			for (uint8_t m = 0; m < m_count; m++)
+				data[m] = m_render[m][a >> 1] >> shift;
+			start();
+			writeCommand(SC1628D_ADDRESS_SETTING_CMD + a);
+			writeBytes(data);
+			stop();
+		}
+	}
+	memcpy(m_matrix, m_render, sizeof(m_matrix));
+	m_matrixValid = true;
+
+	// Command 1: Set display mode (default: 7 grids - 11 segments)
+	sendCommand(m_mode, SC1628D_DISPLAY_MODE_CMD | SC1628D_7GRID_11SEG);
+
+	// Command 4: Set Display on/off + Brightness
+	sendCommand(m_control, SC1628D_DISPLAY_CONTROL_CMD | (m_brightness & 0x0f));
+}
+
+void SC1628DGroup::getButtons(uint32_t buttons[])
+{
+	uint8_t keys[SC1628D_GROUP_MAX];
+
+	for (uint8_t m = 0; m < m_count; m++)
+		buttons[m] = 0;
+
+	start();
+	writeCommand(SC1628D_DATA_SETTING_CMD_READ);		// send read buttons command
+
+	// Pull-up on
+	for (uint8_t m = 0; m < m_count; m++)
+		pinMode(m_pinDIO[m].pin, INPUT_PULLUP);
+
+	// The modules need a wait time after the read command
+	m_wait.wait();
+
+	for (uint8_t i = 0; i < 5; i++) {
+		uint8_t bits[8];
+		for (uint8_t b = 0; b < 8; b++)
+			bits[b] = clockIn();
+
+		// Transpose the bits of each clock into a byte per module
+		for (uint8_t m = 0; m < m_count; m++) {
+			keys[m] = 0;
+			for (uint8_t b = 0; b < 8; b++)
+				keys[m] |= ((bits[b] >> m) & 1) << b;
+			buttons[m] |= SC1628D_KeyButtons(keys[m], i);
+		}
+	}
+
+	// Pull-up off
+	for (uint8_t m = 0; m < m_count; m++)
+		pinMode(m_pinDIO[m].pin, OUTPUT);
+	stop();
+	m_dataSetting = SC1628D_DATA_SETTING_CMD_READ;
+}
+
+//-----------------------------------------------------------------
+
+
+void SC1628DGroup::start()
+{
+#ifdef SC1628D_FAST_GPIO
+	if (m_fast) {
+#if defined(__AVR__)
+		uint8_t oldSREG = SREG;
+		cli();
+		*m_pinCLK.out &= ~m_stbMask;
+		SREG = oldSREG;
+#else
+		GPOC = m_stbMask;
+#endif
+		m_strobe.wait();
+		return;
+	}
+#endif
+	for (uint8_t m = 0; m < m_stbCount; m++)
+		m_pinSTB[m].write(LOW);
+	m_strobe.wait();
+}
+
+void SC1628DGroup::stop()
+{
+#ifdef SC1628D_FAST_GPIO
+	if (m_fast) {
+#if defined(__AVR__)
+		uint8_t oldSREG = SREG;
+		cli();
+		*m_pinCLK.out |= m_stbMask;
+		SREG = oldSREG;
+#else
+		GPOS = m_stbMask;
+#endif
+		m_strobe.wait();
+		return;
+	}
+#endif
+	for (uint8_t m = 0; m < m_stbCount; m++)
+		m_pinSTB[m].write(HIGH);
+	m_strobe.wait();
+}
+
+// Send one bit to each module: bit m of lines to module m
+void SC1628DGroup::clockOut(uint8_t lines)
+{
+#ifdef SC1628D_FAST_GPIO
+	if (m_fast) {
+		SC1628D_reg_t set = 0;
+		for (uint8_t m = 0; m < m_count; m++)
+			if (lines & (1 << m))
+				set |= m_pinDIO[m].mask;
+
+#if defined(__AVR__)
+		// CLK low and all the data bits in one write, then CLK high
+		uint8_t oldSREG = SREG;
+		cli();
+		*m_pinCLK.out = (*m_pinCLK.out & ~(m_pinCLK.mask | m_dioAll)) | set;
+		SREG = oldSREG;
+		m_low.wait();
+		oldSREG = SREG;
+		cli();
+		*m_pinCLK.out |= m_pinCLK.mask;
+		SREG = oldSREG;
+#else
+		GPOC = m_pinCLK.mask | (m_dioAll & ~set);
+		GPOS = set;
+		m_low.wait();
+		GPOS = m_pinCLK.mask;
+#endif
+		m_high.wait();
+		return;
+	}
+#endif
+	// CLK low
+	m_pinCLK.write(LOW);
+
+	// Set data bits
+	for (uint8_t m = 0; m < m_count; m++)
+		m_pinDIO[m].write((lines >> m) & 1 ? HIGH : LOW);
+
+	m_low.wait();
+
+	// CLK high
+	m_pinCLK.write(HIGH);
+	m_high.wait();
+}
+
+// Receive one bit of each module: bit m of the result from module m
+uint8_t SC1628DGroup::clockIn()
+{
+	uint8_t lines = 0;
+
+	// CLK low
+	m_pinCLK.write(LOW);
+	m_low.wait();
+
+#ifdef SC1628D_FAST_GPIO
+	if (m_fast) {
+		SC1628D_reg_t in = *m_pinCLK.in;
+		for (uint8_t m = 0; m < m_count; m++)
+			if (in & m_pinDIO[m].mask)
+				lines |= 1 << m;
+	}
+	else
+#endif
+	for (uint8_t m = 0; m < m_count; m++)
+		if (m_pinDIO[m].read())
+			lines |= 1 << m;
+
+	// CLK high
+	m_pinCLK.write(HIGH);
+	m_high.wait();
+	return lines;
+}
+
+// Send a single byte command, unless the modules already have it
+void SC1628DGroup::sendCommand(uint8_t &state, uint8_t command)
+{
+	if (state == command)
+		return;
+	start();
+	writeCommand(command);
+	stop();
+	state = command;
+}
+
+void SC1628DGroup::writeCommand(uint8_t b)
+{
+	// 8 Data Bits, the same on all the modules
+	for (uint8_t i = 0; i < 8; i++)
+		clockOut((b >> i) & 1 ? m_all : 0);
+}
+
+void SC1628DGroup::writeBytes(const uint8_t data[])
+{
+	// 8 Data Bits, one byte per module
+	for (uint8_t i = 0; i < 8; i++) {
+		uint8_t lines = 0;
+		for (uint8_t m = 0; m < m_count; m++)
+			lines |= ((data[m] >> i) & 1) << m;
+		clockOut(lines);
+	}
+}
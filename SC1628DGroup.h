@@ -0,0 +1,170 @@
+/*
+ *  SC1628DGroup.h
+ *
+ *  Arduino Library for the SC1628D LED Driver IC
+ *  Parallel refresh of several modules sharing the clock line
+ *
+ *  (c) 2022/07/13 philippe.corbes@gmail.com
+ *
+ *  This library is free software; you can redistribute it and/or
+ *  modify it under the terms of the GNU Lesser General Public
+ *  License as published by the Free Software Foundation; either
+ *  version 2.1 of the License, or (at your option) any later version.
+ *
+ *  This library is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ *  Lesser General Public License for more details.
+ *
+ *  You should have received a copy of the GNU Lesser General Public
+ *  License along with this library; if not, write to the Free Software
+ *  Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  USA
+ */
+
+#ifndef __SC1628D_GROUP__
+#define __SC1628D_GROUP__
+
+#include <SC1628D.h>
+
+#define SC1628D_GROUP_MAX        8
+
+/*
+ Group connection
+
+ CLK  ---+-----------+-----------+----  CLK of all modules
+ STB  ---+-----------+-----------+----  STB of all modules (or one STB per module)
+ DIO0 --- module 0   |           |
+ DIO1 --------------- module 1   |
+ DIO2 --------------------------- module 2 ...
+
+ All the modules receive the same commands at the same time, each one with
+ its own data on its DIO line. When CLK, STB and the DIO lines are on the same
+ port of an AVR or ESP8266, each clock edge is a single port write, so the bus
+ time of the group is about the one of a single module.
+*/
+class SC1628DGroup {
+
+public:
+	// Initialize a group of modules sharing STB and CLK
+	//
+	// @param pinSTB - The number of the digital pin connected to the STB pins of the modules
+	// @param pinCLK - The number of the digital pin connected to the clock pins of the modules
+	// @param pinDIO - The numbers of the digital pins connected to the DIO pin of each module
+	// @param count - The number of modules, up to SC1628D_GROUP_MAX
+	// @param bitDelay - The delay, in microseconds, between bit transition on the serial bus
+	//                   (up to 65), replaced by setTiming()
+	//
+	SC1628DGroup(uint8_t pinSTB, uint8_t pinCLK, const uint8_t pinDIO[], uint8_t count, unsigned int bitDelay = SC1628D_BIT_DELAY);
+
+	// Initialize a group of modules sharing CLK, with a STB pin per module
+	//
+	// @param pinSTB - The numbers of the digital pins connected to the STB pin of each module
+	//
+	SC1628DGroup(const uint8_t pinSTB[], uint8_t pinCLK, const uint8_t pinDIO[], uint8_t count, unsigned int bitDelay = SC1628D_BIT_DELAY);
+
+	// Get the number of modules
+	//
+	uint8_t count() const { return m_count; }
+
+	// Set the serial bus timings
+	//
+	// @param timing The timings in nanoseconds, a SC1628D_TIMING_xxx profile or your own
+	//
+	void setTiming(const SC1628DTiming &timing);
+
+	// Sets the brightness of all the displays, on the next refresh
+	//
+	// @param brightness A number from 0 (lowes brightness) to 7 (highest brightness)
+	// @param on Turn display on or off
+	//
+	void setBrightness(uint8_t brightness, bool on = true);
+
+	// Set the layout describing how the modules are wired
+	//
+	// The built-in layouts are recognized and read from flash memory.
+	//
+	void setLayout(const SC1628DLayout &layout);
+
+	// Set the layout, stored in flash memory (PROGMEM)
+	//
+	void setLayout_P(const SC1628DLayout &layout);
+
+	// Set the digits table to character to a segments set
+	//
+	// The built-in fonts are recognized and read from flash memory.
+	//
+	void setFont(const uint8_t font[]);
+
+	// Set the digits table, stored in flash memory (PROGMEM)
+	//
+	void setFont_P(const uint8_t font[]);
+
+	// Set digits of a module, shown on the next refresh
+	//
+	// @param module The module number
+	// @param digits An array of digits to display
+	// @param pos The position from which to display them (0 - leftmost, 4 - rightmost), nothing is done past 4
+	// @param length The number of digits, cut at the rightmost position
+	//
+	void displayDigits(uint8_t module, const uint8_t digits[], uint8_t pos = 0, uint8_t length = 5);
+
+	// Set segments of a module, shown on the next refresh
+	//
+	// @param module The module number
+	// @param segments An array of segments masks
+	// @param pos The position from which to display them (0 - leftmost, 4 - rightmost), nothing is done past 4
+	// @param length The number of positions, cut at the rightmost position
+	//
+	void displaySegments(uint8_t module, const uint8_t segments[], uint8_t pos = 0, uint8_t length = 5);
+
+	// Send the modified display RAM bytes of all the modules at once
+	//
+	void refresh();
+
+	// Scan the keys of all the modules at once
+	//
+	// @param buttons Receives a getButtons() mask per module
+	//
+	void getButtons(uint32_t buttons[]);
+
+private:
+	void init(uint8_t pinCLK, const uint8_t pinDIO[], uint8_t count, unsigned int bitDelay);
+	void start();
+	void stop();
+	void clockOut(uint8_t lines);
+	uint8_t clockIn();
+	void sendCommand(uint8_t &state, uint8_t command);
+	void writeCommand(uint8_t b);
+	void writeBytes(const uint8_t data[]);
+
+	SC1628DPin m_pinSTB[SC1628D_GROUP_MAX];
+	SC1628DPin m_pinCLK;
+	SC1628DPin m_pinDIO[SC1628D_GROUP_MAX];
+	uint8_t m_stbCount;
+	uint8_t m_count;
+	uint8_t m_all;				// Mask of the module lines
+	SC1628DDelay m_low;			// CLK low, data set up
+	SC1628DDelay m_high;		// CLK high, data held
+	SC1628DDelay m_strobe;
+	SC1628DDelay m_wait;
+#ifdef SC1628D_FAST_GPIO
+	bool m_fast;				// All the pins on the same port
+	SC1628D_reg_t m_stbMask;
+	SC1628D_reg_t m_dioAll;
+#endif
+
+	const SC1628DLayout *m_layout;
+	const uint8_t *m_font;
+	bool m_layoutFlash;			// m_layout is in flash memory
+	bool m_fontFlash;			// m_font is in flash memory
+	uint8_t m_brightness;
+	uint8_t m_segments[SC1628D_GROUP_MAX][5];
+	uint16_t m_render[SC1628D_GROUP_MAX][7];	// Matrix of m_segments
+	uint16_t m_matrix[SC1628D_GROUP_MAX][7];	// Last matrix written to the display RAM
+	bool m_matrixValid;
+	uint8_t m_mode;				// Last commands sent, 0xff when unknown
+	uint8_t m_dataSetting;
+	uint8_t m_control;
+};
+
+#endif // __SC1628D_GROUP__
@@ -0,0 +1,257 @@
+/*
+ *  SC1628DLinuxGPIOTransport.cpp
+ *
+ *  Arduino Library for the SC1628D LED Driver IC
+ *  Linux GPIO character device transport
+ *
+ *  (c) 2022/07/13 philippe.corbes@gmail.com
+ *
+ *  This library is free software; you can redistribute it and/or
+ *  modify it under the terms of the GNU Lesser General Public
+ *  License as published by the Free Software Foundation; either
+ *  version 2.1 of the License, or (at your option) any later version.
+ *
+ *  This library is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ *  Lesser General Public License for more details.
+ *
+ *  You should have received a copy of the GNU Lesser General Public
+ *  License along with this library; if not, write to the Free Software
+ *  Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  USA
+ */
+
+#include <SC1628DLinuxGPIOTransport.h>
+
+#if defined(__linux__)
+
+#include <errno.h>
+#include <fcntl.h>
+#include <string.h>
+#include <unistd.h>
+#include <sys/ioctl.h>
+
+// Bits of the lines in the request, the same as the SC1628D_WAVE_xxx levels
+#define SC1628D_GPIO_STB         0x01
+#define SC1628D_GPIO_CLK         0x02
+#define SC1628D_GPIO_DIO         0x04
+#define SC1628D_GPIO_ALL         0x07
+
+
+SC1628DLinuxGPIOTransport::SC1628DLinuxGPIOTransport(const char *chip, uint32_t lineSTB, uint32_t lineCLK, uint32_t lineDIO)
+{
+	m_chip = chip;
+	m_offsets[0] = lineSTB;
+	m_offsets[1] = lineCLK;
+	m_offsets[2] = lineDIO;
+	m_fd = -1;
+	m_levels = SC1628D_GPIO_ALL;
+	m_calls = 0;
+	m_reading = false;
+
+	// The two configurations of the lines, only their output levels change
+	memset(&m_output, 0, sizeof(m_output));
+	m_output.flags = GPIO_V2_LINE_FLAG_OUTPUT;
+	m_output.num_attrs = 1;
+	m_output.attrs[0].attr.id = GPIO_V2_LINE_ATTR_ID_OUTPUT_VALUES;
+	m_output.attrs[0].mask = SC1628D_GPIO_ALL;
+
+	memset(&m_input, 0, sizeof(m_input));
+	m_input.flags = GPIO_V2_LINE_FLAG_OUTPUT;
+	m_input.num_attrs = 2;
+	m_input.attrs[0].attr.id = GPIO_V2_LINE_ATTR_ID_FLAGS;
+	m_input.attrs[0].attr.flags = GPIO_V2_LINE_FLAG_INPUT | GPIO_V2_LINE_FLAG_BIAS_PULL_UP;
+	m_input.attrs[0].mask = SC1628D_GPIO_DIO;
+	m_input.attrs[1].attr.id = GPIO_V2_LINE_ATTR_ID_OUTPUT_VALUES;
+	m_input.attrs[1].mask = SC1628D_GPIO_STB | SC1628D_GPIO_CLK;
+
+	setTiming(SC1628D_TIMING_DATASHEET);
+}
+
+SC1628DLinuxGPIOTransport::~SC1628DLinuxGPIOTransport()
+{
+	end();
+}
+
+bool SC1628DLinuxGPIOTransport::begin()
+{
+	struct gpio_v2_line_request request;
+
+	if (m_fd >= 0)
+		return true;
+
+	// The three lines, as outputs, high
+	memset(&request, 0, sizeof(request));
+	memcpy(request.offsets, m_offsets, sizeof(m_offsets));
+	strncpy(request.consumer, SC1628D_GPIO_CONSUMER, sizeof(request.consumer) - 1);
+	request.num_lines = 3;
+	m_levels = SC1628D_GPIO_ALL;
+	m_output.attrs[0].attr.values = m_levels;
+	request.config = m_output;
+
+	m_fd = requestLines(request);
+	m_calls = 0;
+	m_reading = false;
+	return m_fd >= 0;
+}
+
+void SC1628DLinuxGPIOTransport::end()
+{
+	if (m_fd < 0)
+		return;
+	releaseLines();
+	m_fd = -1;
+}
+
+void SC1628DLinuxGPIOTransport::setTiming(const SC1628DTiming &timing)
+{
+	// DIO is set with the CLK falling edge, and changed again with the next one
+	m_low.set(timing.clockLow > timing.setup ? timing.clockLow : timing.setup);
+	m_high.set(timing.clockHigh > timing.hold ? timing.clockHigh : timing.hold);
+	m_strobe.set(timing.strobe);
+	m_wait.set(timing.wait);
+}
+
+void SC1628DLinuxGPIOTransport::start()
+{
+	setLevels(0, SC1628D_GPIO_STB);
+	m_strobe.wait();
+}
+
+void SC1628DLinuxGPIOTransport::stop()
+{
+	if (m_reading) {
+		// DIO back to an output, high, with the STB rising edge
+		m_levels = SC1628D_GPIO_ALL;
+		setDirection(false);
+	}
+	else
+		setLevels(SC1628D_GPIO_STB, SC1628D_GPIO_STB);
+	m_strobe.wait();
+}
+
+void SC1628DLinuxGPIOTransport::writeByte(uint8_t b)
+{
+	if (m_reading) {
+		m_levels |= SC1628D_GPIO_DIO;
+		setDirection(false);
+	}
+	clockByte(b);
+}
+
+void SC1628DLinuxGPIOTransport::writeWord(uint16_t w)
+{
+	writeByte(w & 0xff);
+	writeByte(w >> 8);
+}
+
+uint8_t SC1628DLinuxGPIOTransport::readByte()
+{
+	struct gpio_v2_line_values values;
+	uint8_t b = 0;
+
+	// The chip needs a wait time after the read command
+	if (!m_reading) {
+		setDirection(true);
+		m_wait.wait();
+	}
+	for (uint8_t i = 0; i < 8; i++) {
+		setLevels(0, SC1628D_GPIO_CLK);
+		m_low.wait();
+		values.bits = 0;
+		values.mask = SC1628D_GPIO_DIO;
+		if (m_fd >= 0) {
+			m_calls++;
+			control(GPIO_V2_LINE_GET_VALUES_IOCTL, &values);
+		}
+		b = (b >> 1) | ((values.bits & SC1628D_GPIO_DIO) ? 0x80 : 0);
+		setLevels(SC1628D_GPIO_CLK, SC1628D_GPIO_CLK);
+		m_high.wait();
+	}
+	return b;
+}
+
+// One ioctl per step, with the lines changed by the step
+void SC1628DLinuxGPIOTransport::writeWaveform(const uint8_t steps[], uint16_t length)
+{
+	if (m_reading) {
+		m_levels |= SC1628D_GPIO_DIO;
+		setDirection(false);
+	}
+	for (uint16_t i = 0; i < length; i++) {
+		uint8_t step = steps[i];
+		uint8_t changed = (step ^ m_levels) & SC1628D_GPIO_ALL;
+
+		if (changed)
+			setLevels(step, changed);
+		if (changed & SC1628D_GPIO_STB)
+			m_strobe.wait();
+		else if (step & SC1628D_GPIO_CLK)
+			m_high.wait();
+		else
+			m_low.wait();
+	}
+}
+
+// One ioctl per half clock period: CLK low with the data bit, then CLK high
+void SC1628DLinuxGPIOTransport::clockByte(uint8_t b)
+{
+	for (uint8_t i = 0; i < 8; i++) {
+		setLevels((b & 1) ? SC1628D_GPIO_DIO : 0, SC1628D_GPIO_CLK | SC1628D_GPIO_DIO);
+		m_low.wait();
+		setLevels(SC1628D_GPIO_CLK, SC1628D_GPIO_CLK);
+		m_high.wait();
+		b >>= 1;
+	}
+}
+
+void SC1628DLinuxGPIOTransport::setLevels(uint8_t levels, uint8_t mask)
+{
+	struct gpio_v2_line_values values;
+
+	m_levels = (m_levels & ~mask) | (levels & mask);
+	if (m_fd < 0)
+		return;
+	values.bits = m_levels;
+	values.mask = mask;
+	m_calls++;
+	control(GPIO_V2_LINE_SET_VALUES_IOCTL, &values);
+}
+
+// Switch DIO between output and input, the other lines keep their levels
+void SC1628DLinuxGPIOTransport::setDirection(bool input)
+{
+	struct gpio_v2_line_config &config = input ? m_input : m_output;
+
+	m_reading = input;
+	config.attrs[input ? 1 : 0].attr.values = m_levels;
+	if (m_fd < 0)
+		return;
+	m_calls++;
+	control(GPIO_V2_LINE_SET_CONFIG_IOCTL, &config);
+}
+
+int SC1628DLinuxGPIOTransport::requestLines(struct gpio_v2_line_request &request)
+{
+	int chip = open(m_chip, O_RDWR | O_CLOEXEC);
+	if (chip < 0)
+		return -1;
+
+	int result = ioctl(chip, GPIO_V2_GET_LINE_IOCTL, &request);
+	int error = errno;
+	close(chip);
+	errno = error;
+	return result < 0 ? -1 : request.fd;
+}
+
+int SC1628DLinuxGPIOTransport::control(unsigned long command, void *arg)
+{
+	return ioctl(m_fd, command, arg);
+}
+
+void SC1628DLinuxGPIOTransport::releaseLines()
+{
+	close(m_fd);
+}
+
+#endif // __linux__
@@ -0,0 +1,118 @@
+/*
+ *  SC1628DLinuxGPIOTransport.h
+ *
+ *  Arduino Library for the SC1628D LED Driver IC
+ *  Linux GPIO character device transport
+ *
+ *  (c) 2022/07/13 philippe.corbes@gmail.com
+ *
+ *  This library is free software; you can redistribute it and/or
+ *  modify it under the terms of the GNU Lesser General Public
+ *  License as published by the Free Software Foundation; either
+ *  version 2.1 of the License, or (at your option) any later version.
+ *
+ *  This library is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ *  Lesser General Public License for more details.
+ *
+ *  You should have received a copy of the GNU Lesser General Public
+ *  License along with this library; if not, write to the Free Software
+ *  Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  USA
+ */
+
+#ifndef __SC1628D_LINUX_GPIO_TRANSPORT__
+#define __SC1628D_LINUX_GPIO_TRANSPORT__
+
+#if defined(__linux__)
+
+#include <SC1628DTransport.h>
+#include <linux/gpio.h>
+
+#define SC1628D_GPIO_CONSUMER    "sc1628d"
+
+/*
+ Linux GPIO character device connection
+
+ STB, CLK and DIO are three lines of a /dev/gpiochipN, requested together
+ with the version 2 of the GPIO character device API (Linux 5.10 and later).
+ Each half clock period is a single ioctl: CLK goes low with the new DIO
+ level, then high. DIO becomes an input with a pull-up for the key bytes,
+ then an output again with the STB rising edge, in the same ioctl.
+
+ The bus speed is limited by the ioctl time (a few microseconds), the
+ timings only add a busy wait when they are longer. Example:
+
+   SC1628DLinuxGPIOTransport bus("/dev/gpiochip0", 17, 27, 22);
+   SC1628DDriver display(bus);
+
+   if (!bus.begin())
+     perror("sc1628d");
+*/
+class SC1628DLinuxGPIOTransport : public SC1628DTransport {
+
+public:
+	// Initialize the transport, the lines are requested by begin()
+	//
+	// @param chip - The GPIO chip device, as "/dev/gpiochip0"
+	// @param lineSTB - The offset of the line connected to the STB pin of the module
+	// @param lineCLK - The offset of the line connected to the clock pin of the module
+	// @param lineDIO - The offset of the line connected to the DIO pin of the module
+	//
+	SC1628DLinuxGPIOTransport(const char *chip, uint32_t lineSTB, uint32_t lineCLK, uint32_t lineDIO);
+	virtual ~SC1628DLinuxGPIOTransport();
+
+	// Request the lines as outputs, high
+	//
+	// @return false if the chip cannot be opened or the lines are busy, with errno set
+	//
+	bool begin();
+
+	// Release the lines
+	//
+	void end();
+
+	// Get the number of ioctl calls made on the lines since begin()
+	//
+	unsigned long calls() const { return m_calls; }
+
+	virtual void start();
+	virtual void stop();
+	virtual void writeByte(uint8_t b);
+	virtual void writeWord(uint16_t w);
+	virtual uint8_t readByte();
+	virtual void setTiming(const SC1628DTiming &timing);
+	virtual void writeWaveform(const uint8_t steps[], uint16_t length);
+
+protected:
+	// The GPIO character device calls, replaced by a stand-in chip in tests
+	//
+	// requestLines() returns the file descriptor of the lines, or -1.
+	//
+	virtual int requestLines(struct gpio_v2_line_request &request);
+	virtual int control(unsigned long command, void *arg);
+	virtual void releaseLines();
+
+	int m_fd;					// The requested lines, -1 before begin()
+
+private:
+	void setLevels(uint8_t levels, uint8_t mask);
+	void setDirection(bool input);
+	void clockByte(uint8_t b);
+
+	const char *m_chip;
+	uint32_t m_offsets[3];		// STB, CLK, DIO
+	uint8_t m_levels;			// Output levels, bit 0 STB, bit 1 CLK, bit 2 DIO
+	struct gpio_v2_line_config m_output;	// All the lines as outputs
+	struct gpio_v2_line_config m_input;		// DIO as an input with a pull-up
+	unsigned long m_calls;
+	SC1628DDelay m_low;			// CLK low, data set up
+	SC1628DDelay m_high;		// CLK high, data held
+	SC1628DDelay m_strobe;
+	SC1628DDelay m_wait;
+	bool m_reading;				// DIO is an input
+};
+
+#endif // __linux__
+
+#endif // __SC1628D_LINUX_GPIO_TRANSPORT__
@@ -0,0 +1,87 @@
+/*
+ *  SC1628DMailbox.cpp
+ *
+ *  Arduino Library for the SC1628D LED Driver IC
+ *  Lock-free frame mailbox between an interrupt or a task and the refresh
+ *
+ *  (c) 2022/07/13 philippe.corbes@gmail.com
+ *
+ *  This library is free software; you can redistribute it and/or
+ *  modify it under the terms of the GNU Lesser General Public
+ *  License as published by the Free Software Foundation; either
+ *  version 2.1 of the License, or (at your option) any later version.
+ *
+ *  This library is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ *  Lesser General Public License for more details.
+ *
+ *  You should have received a copy of the GNU Lesser General Public
+ *  License along with this library; if not, write to the Free Software
+ *  Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  USA
+ */
+
+#include <SC1628DMailbox.h>
+#include <string.h>
+
+// Byte loads and stores are atomic on every target, the builtins add the
+// ordering of the frame copies against the index updates. Sequential
+// consistency is needed by take(): its store must be visible before its load.
+#define MAILBOX_LOAD(v)          __atomic_load_n(&(v), __ATOMIC_SEQ_CST)
+#define MAILBOX_STORE(v, x)      __atomic_store_n(&(v), (x), __ATOMIC_SEQ_CST)
+
+
+SC1628DMailbox::SC1628DMailbox()
+{
+	memset(m_slot, 0, sizeof(m_slot));
+	m_latest = 0;
+	m_reading = 0;
+	m_write = 1;
+}
+
+void SC1628DMailbox::publish()
+{
+	uint8_t latest = m_write;
+
+	MAILBOX_STORE(m_latest, latest);
+
+	// The consumer can only move to the latest slot: the third one stays free
+	uint8_t reading = MAILBOX_LOAD(m_reading);
+	uint8_t write = 0;
+	while (write == latest || write == reading)
+		write++;
+	m_write = write;
+}
+
+void SC1628DMailbox::publish(const uint8_t segments[])
+{
+	memcpy(m_slot[m_write], segments, sizeof(m_slot[0]));
+	publish();
+}
+
+bool SC1628DMailbox::take(uint8_t segments[])
+{
+	uint8_t latest = MAILBOX_LOAD(m_latest);
+
+	if (latest == m_reading)
+		return false;
+
+	// A newer frame may have been published before the read is announced, and
+	// this slot given back to the producer: it is only safe to read while it is
+	// still the latest slot after the announcement
+	for (;;) {
+		MAILBOX_STORE(m_reading, latest);
+		uint8_t check = MAILBOX_LOAD(m_latest);
+		if (check == latest)
+			break;
+		latest = check;
+	}
+
+	memcpy(segments, m_slot[latest], sizeof(m_slot[0]));
+	return true;
+}
+
+bool SC1628DMailbox::available() const
+{
+	return MAILBOX_LOAD(m_latest) != m_reading;
+}
@@ -0,0 +1,93 @@
+/*
+ *  SC1628DMailbox.h
+ *
+ *  Arduino Library for the SC1628D LED Driver IC
+ *  Lock-free frame mailbox between an interrupt or a task and the refresh
+ *
+ *  (c) 2022/07/13 philippe.corbes@gmail.com
+ *
+ *  This library is free software; you can redistribute it and/or
+ *  modify it under the terms of the GNU Lesser General Public
+ *  License as published by the Free Software Foundation; either
+ *  version 2.1 of the License, or (at your option) any later version.
+ *
+ *  This library is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ *  Lesser General Public License for more details.
+ *
+ *  You should have received a copy of the GNU Lesser General Public
+ *  License along with this library; if not, write to the Free Software
+ *  Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  USA
+ */
+
+#ifndef __SC1628D_MAILBOX__
+#define __SC1628D_MAILBOX__
+
+#include <inttypes.h>
+
+#define SC1628D_MAILBOX_SLOTS    3
+
+/*
+ Triple buffer
+
+ Three frame slots: the producer fills its own slot, the consumer reads its
+ own slot, and the third one holds the latest published frame. Publishing
+ makes the filled slot the latest one, and the producer continues in a slot
+ which is neither the latest nor the one being read. Taking makes the latest
+ slot the one being read.
+
+ Neither side waits for the other or disables the interrupts: a frame
+ published while the previous one is not taken yet replaces it (latest
+ wins), and a frame being read is never overwritten. The slot indexes are
+ single bytes, accessed with the GCC atomic builtins, so it also works
+ between the two cores of an ESP32.
+*/
+
+// A mailbox of segments frames, from one producer to one consumer
+class SC1628DMailbox {
+
+public:
+	// An empty mailbox
+	//
+	SC1628DMailbox();
+
+	// Get the frame being prepared, to be filled then published
+	//
+	// Only the producer may use it, until publish().
+	//
+	// @return the 5 segments masks of the producer's slot
+	//
+	uint8_t *frame() { return m_slot[m_write]; }
+
+	// Publish the frame being prepared, replacing a frame not taken yet
+	//
+	void publish();
+
+	// Copy and publish a frame
+	//
+	// @param segments The 5 segments masks to display (0 - leftmost, 4 - rightmost)
+	//
+	void publish(const uint8_t segments[]);
+
+	// Take the latest frame published, from the consumer
+	//
+	// @param segments Receives the 5 segments masks
+	// @return false if no frame was published since the last one taken
+	//
+	bool take(uint8_t segments[]);
+
+	// Check for a frame not taken yet, from the consumer
+	//
+	// @return true if a frame was published since the last one taken
+	//
+	bool available() const;
+
+private:
+	uint8_t m_slot[SC1628D_MAILBOX_SLOTS][5];
+	uint8_t m_write;			// Producer's slot
+	uint8_t m_latest;			// Last published slot
+	uint8_t m_reading;			// Consumer's slot, the latest one when taken
+};
+
+#endif // __SC1628D_MAILBOX__
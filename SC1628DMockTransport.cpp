@@ -0,0 +1,109 @@
+/*
+ *  SC1628DMockTransport.cpp
+ *
+ *  Arduino Library for the SC1628D LED Driver IC
+ *  In-memory transport emulating the chip, for tests
+ *
+ *  (c) 2022/07/13 philippe.corbes@gmail.com
+ *
+ *  This library is free software; you can redistribute it and/or
+ *  modify it under the terms of the GNU Lesser General Public
+ *  License as published by the Free Software Foundation; either
+ *  version 2.1 of the License, or (at your option) any later version.
+ *
+ *  This library is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ *  Lesser General Public License for more details.
+ *
+ *  You should have received a copy of the GNU Lesser General Public
+ *  License along with this library; if not, write to the Free Software
+ *  Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  USA
+ */
+
+extern "C" {
+	#include <string.h>
+}
+
+#include <SC1628DMockTransport.h>
+
+
+SC1628DMockTransport::SC1628DMockTransport()
+{
+	memset(m_keys, 0, sizeof(m_keys));
+	reset();
+}
+
+void SC1628DMockTransport::reset()
+{
+	memset(ram, 0, sizeof(ram));
+	mode = 0;
+	control = 0;
+	dataSetting = 0;
+	transactions = 0;
+	bytesWritten = 0;
+	bytesRead = 0;
+	m_address = 0;
+	m_keyIndex = 0;
+	m_command = false;
+}
+
+void SC1628DMockTransport::setKeys(const uint8_t keys[])
+{
+	memcpy(m_keys, keys, sizeof(m_keys));
+}
+
+uint16_t SC1628DMockTransport::grid(uint8_t grid) const
+{
+	return ram[2*grid] | (ram[2*grid + 1] << 8);
+}
+
+void SC1628DMockTransport::start()
+{
+	transactions++;
+	m_command = true;
+	m_keyIndex = 0;
+}
+
+void SC1628DMockTransport::stop()
+{
+	m_command = false;
+}
+
+void SC1628DMockTransport::writeByte(uint8_t b)
+{
+	bytesWritten++;
+
+	// Data byte, written at the current address
+	if (!m_command) {
+		ram[m_address] = b;
+		if (!(dataSetting & 0x04))
+			m_address = (m_address + 1) % SC1628D_RAM_SIZE;
+		return;
+	}
+
+	// First byte of a transaction: the command type is given by bits 7-6
+	m_command = false;
+	switch (b & 0xc0) {
+	case 0x00:	// Command 1: display mode
+		mode = b;
+		break;
+	case 0x40:	// Command 2: data setting
+		dataSetting = b;
+		break;
+	case 0x80:	// Command 4: display control
+		control = b;
+		break;
+	case 0xc0:	// Command 3: address setting
+		m_address = (b & 0x0f) % SC1628D_RAM_SIZE;
+		break;
+	}
+}
+
+uint8_t SC1628DMockTransport::readByte()
+{
+	bytesRead++;
+	if (m_keyIndex < SC1628D_KEY_BYTES)
+		return m_keys[m_keyIndex++];
+	return 0;
+}
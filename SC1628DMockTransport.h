@@ -0,0 +1,76 @@
+/*
+ *  SC1628DMockTransport.h
+ *
+ *  Arduino Library for the SC1628D LED Driver IC
+ *  In-memory transport emulating the chip, for tests
+ *
+ *  (c) 2022/07/13 philippe.corbes@gmail.com
+ *
+ *  This library is free software; you can redistribute it and/or
+ *  modify it under the terms of the GNU Lesser General Public
+ *  License as published by the Free Software Foundation; either
+ *  version 2.1 of the License, or (at your option) any later version.
+ *
+ *  This library is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ *  Lesser General Public License for more details.
+ *
+ *  You should have received a copy of the GNU Lesser General Public
+ *  License along with this library; if not, write to the Free Software
+ *  Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  USA
+ */
+
+#ifndef __SC1628D_MOCK_TRANSPORT__
+#define __SC1628D_MOCK_TRANSPORT__
+
+#include <SC1628DTransport.h>
+
+#define SC1628D_RAM_SIZE         14
+#define SC1628D_KEY_BYTES        5
+
+// A transport without hardware: the commands are decoded as the chip would,
+// the display RAM can be inspected and the key scan bytes can be set.
+class SC1628DMockTransport : public SC1628DTransport {
+
+public:
+	SC1628DMockTransport();
+
+	// Forget the chip state and the counters
+	//
+	void reset();
+
+	// Set the key scan bytes returned by the next key reads
+	//
+	// @param keys An array of 5 key scan bytes
+	//
+	void setKeys(const uint8_t keys[]);
+
+	// Get a grid word of the display RAM
+	//
+	// @param grid The grid number from 0 (GR1) to 6 (GR7)
+	//
+	uint16_t grid(uint8_t grid) const;
+
+	uint8_t ram[SC1628D_RAM_SIZE];	// Display RAM
+	uint8_t mode;					// Last display mode command
+	uint8_t control;				// Last display control command
+	uint8_t dataSetting;			// Last data setting command
+
+	unsigned long transactions;		// Number of STB low periods
+	unsigned long bytesWritten;		// Number of bytes sent to the chip
+	unsigned long bytesRead;		// Number of bytes read from the chip
+
+	virtual void start();
+	virtual void stop();
+	virtual void writeByte(uint8_t b);
+	virtual uint8_t readByte();
+
+private:
+	uint8_t m_keys[SC1628D_KEY_BYTES];
+	uint8_t m_address;
+	uint8_t m_keyIndex;
+	bool m_command;
+};
+
+#endif // __SC1628D_MOCK_TRANSPORT__
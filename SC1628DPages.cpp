@@ -0,0 +1,197 @@
+/*
+ *  SC1628DPages.cpp
+ *
+ *  Arduino Library for the SC1628D LED Driver IC
+ *  Pages of a display, updated in the background and shown in turn
+ *
+ *  (c) 2022/07/13 philippe.corbes@gmail.com
+ *
+ *  This library is free software; you can redistribute it and/or
+ *  modify it under the terms of the GNU Lesser General Public
+ *  License as published by the Free Software Foundation; either
+ *  version 2.1 of the License, or (at your option) any later version.
+ *
+ *  This library is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ *  Lesser General Public License for more details.
+ *
+ *  You should have received a copy of the GNU Lesser General Public
+ *  License along with this library; if not, write to the Free Software
+ *  Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  USA
+ */
+
+
+#include <SC1628DPages.h>
+#include <Arduino.h>
+#include <string.h>
+
+
+SC1628DPages::SC1628DPages(SC1628DDriver &display, uint8_t count)
+{
+	if (count > SC1628D_PAGES_MAX)
+		count = SC1628D_PAGES_MAX;
+	if (count == 0)
+		count = 1;
+	m_display = &display;
+	m_count = count;
+	m_visible = 0;
+	m_batch = false;
+	m_layout = display.m_layout;
+	m_filter = display.m_filter;
+	memset(m_segments, 0, sizeof(m_segments));
+	for (uint8_t page = 1; page < count; page++)
+		render(page);
+}
+
+void SC1628DPages::show(uint8_t page)
+{
+	if (page >= m_count || page == m_visible)
+		return;
+	checkLayout();
+
+	// The new page goes to the display, and the visible one back to its buffers
+	noInterrupts();
+	swap(page);
+	interrupts();
+	memcpy(m_segments[m_visible], m_segments[page], sizeof(m_segments[0]));
+	memcpy(m_matrix[m_visible], m_matrix[page], sizeof(m_matrix[0]));
+	m_visible = page;
+
+	// Only the RAM bytes differing from the previous page are written
+	if (!m_display->m_batch)
+		m_display->output();
+}
+
+const uint8_t *SC1628DPages::segments(uint8_t page) const
+{
+	if (page == m_visible || page >= m_count)
+		return m_display->m_segments;
+	return m_segments[page];
+}
+
+void SC1628DPages::displayDigits(uint8_t page, const uint8_t digits[], uint8_t pos, uint8_t length)
+{
+	if (enter(page)) {
+		m_display->displayDigits(digits, pos, length);
+		leave(page);
+	}
+}
+
+void SC1628DPages::displaySegments(uint8_t page, const uint8_t segments[], uint8_t pos, uint8_t length)
+{
+	if (enter(page)) {
+		m_display->displaySegments(segments, pos, length);
+		leave(page);
+	}
+}
+
+void SC1628DPages::displayNumber(uint8_t page, int32_t value, bool zeroPad)
+{
+	if (enter(page)) {
+		m_display->displayNumber(value, zeroPad);
+		leave(page);
+	}
+}
+
+void SC1628DPages::displayFixed(uint8_t page, int32_t value, uint8_t decimals, bool zeroPad)
+{
+	if (enter(page)) {
+		m_display->displayFixed(value, decimals, zeroPad);
+		leave(page);
+	}
+}
+
+void SC1628DPages::displayHex(uint8_t page, uint16_t value, bool zeroPad)
+{
+	if (enter(page)) {
+		m_display->displayHex(value, zeroPad);
+		leave(page);
+	}
+}
+
+void SC1628DPages::displayText(uint8_t page, const char text[], uint8_t pos)
+{
+	if (enter(page)) {
+		m_display->displayText(text, pos);
+		leave(page);
+	}
+}
+
+void SC1628DPages::displayText_P(uint8_t page, const char text[], uint8_t pos)
+{
+	if (enter(page)) {
+		m_display->displayText_P(text, pos);
+		leave(page);
+	}
+}
+
+// Lend the buffers of a hidden page to the display, in a batch: the display
+// functions only render the positions they update. Return false for no page.
+bool SC1628DPages::enter(uint8_t page)
+{
+	if (page >= m_count)
+		return false;
+	if (page == m_visible)
+		return true;
+	checkLayout();
+	noInterrupts();
+	swap(page);
+	m_batch = m_display->m_batch;
+	m_display->m_batch = true;
+	return true;
+}
+
+void SC1628DPages::leave(uint8_t page)
+{
+	if (page == m_visible)
+		return;
+	m_display->m_batch = m_batch;
+	swap(page);
+	interrupts();
+}
+
+// Exchange the segments and the matrix of the display with the ones of a page
+void SC1628DPages::swap(uint8_t page)
+{
+	for (uint8_t pos = 0; pos < 5; pos++) {
+		uint8_t segments = m_display->m_segments[pos];
+		m_display->m_segments[pos] = m_segments[page][pos];
+		m_segments[page][pos] = segments;
+	}
+	for (uint8_t k = 0; k < 7; k++) {
+		uint16_t word = m_display->m_render[k];
+		m_display->m_render[k] = m_matrix[page][k];
+		m_matrix[page][k] = word;
+	}
+}
+
+// Render all the positions of a hidden page
+void SC1628DPages::render(uint8_t page)
+{
+	const SC1628DDriver &display = *m_display;
+
+	if (display.m_layout) {
+		if (display.m_layoutFlash)
+			SC1628D_RenderLayout_P(*display.m_layout, m_segments[page], m_matrix[page]);
+		else
+			SC1628D_RenderLayout(*display.m_layout, m_segments[page], m_matrix[page]);
+	}
+	else {
+		memset(m_matrix[page], 0, sizeof(m_matrix[page]));
+		display.m_filter(m_segments[page], m_matrix[page]);
+	}
+}
+
+// The display renders its own segments again when its layout or its filter
+// changes, the hidden pages are rendered again here
+void SC1628DPages::checkLayout()
+{
+	if (m_display->m_layout == m_layout && m_display->m_filter == m_filter)
+		return;
+	m_layout = m_display->m_layout;
+	m_filter = m_display->m_filter;
+	for (uint8_t page = 0; page < m_count; page++)
+		if (page != m_visible)
+			render(page);
+}
@@ -0,0 +1,139 @@
+/*
+ *  SC1628DPages.h
+ *
+ *  Arduino Library for the SC1628D LED Driver IC
+ *  Pages of a display, updated in the background and shown in turn
+ *
+ *  (c) 2022/07/13 philippe.corbes@gmail.com
+ *
+ *  This library is free software; you can redistribute it and/or
+ *  modify it under the terms of the GNU Lesser General Public
+ *  License as published by the Free Software Foundation; either
+ *  version 2.1 of the License, or (at your option) any later version.
+ *
+ *  This library is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ *  Lesser General Public License for more details.
+ *
+ *  You should have received a copy of the GNU Lesser General Public
+ *  License along with this library; if not, write to the Free Software
+ *  Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  USA
+ */
+
+
+#ifndef __SC1628D_PAGES__
+#define __SC1628D_PAGES__
+
+#include <SC1628D.h>
+
+#define SC1628D_PAGES_MAX        4
+
+/*
+ Pages
+
+ Each page keeps its segments and their display RAM words, rendered with
+ the font and the layout (or the filter) of the display. The visible page
+ is the display itself: its updates are sent as usual. A hidden page is
+ only rendered, on the positions updated, without any bus transaction.
+ show() makes another page visible by writing its RAM words, only the bytes
+ which differ from the previous page when they are few enough.
+
+ The functions of a hidden page borrow the display buffers with the
+ interrupts disabled, so that tick() can run from an interrupt. The
+ marquee, the animations, the mailbox, the intensities and the blinking act
+ on the visible page.
+
+ Example:
+
+   SC1628DPages pages(display, 3);
+
+   pages.displayNumber(0, temperature);		// Visible, sent now
+   pages.displayNumber(1, setpoint);			// Hidden, no bus time
+   pages.displayText(2, "On");
+   pages.show(1);
+*/
+class SC1628DPages {
+
+public:
+	// Pages of a display, the page 0 being visible
+	//
+	// The page 0 has the segments displayed, the other ones are blank.
+	//
+	// @param display The display showing the pages
+	// @param count The number of pages, up to SC1628D_PAGES_MAX
+	//
+	SC1628DPages(SC1628DDriver &display, uint8_t count = SC1628D_PAGES_MAX);
+
+	// Get the number of pages
+	//
+	uint8_t count() const { return m_count; }
+
+	// Get the visible page
+	//
+	uint8_t visible() const { return m_visible; }
+
+	// Make a page visible
+	//
+	// Its RAM words are written as they are, without rendering the segments
+	// again, unless the layout or the filter of the display changed since.
+	//
+	// @param page The page number
+	//
+	void show(uint8_t page);
+
+	// Get the segments of a page
+	//
+	// @param page The page number
+	// @return the 5 segments masks (0 - leftmost, 4 - rightmost)
+	//
+	const uint8_t *segments(uint8_t page) const;
+
+	// As SC1628DDriver::displayDigits(), on a page
+	//
+	// @param page The page number
+	//
+	void displayDigits(uint8_t page, const uint8_t digits[], uint8_t pos = 0, uint8_t length = 5);
+
+	// As SC1628DDriver::displaySegments(), on a page
+	//
+	void displaySegments(uint8_t page, const uint8_t segments[], uint8_t pos = 0, uint8_t length = 5);
+
+	// As SC1628DDriver::displayNumber(), on a page
+	//
+	void displayNumber(uint8_t page, int32_t value, bool zeroPad = false);
+
+	// As SC1628DDriver::displayFixed(), on a page
+	//
+	void displayFixed(uint8_t page, int32_t value, uint8_t decimals, bool zeroPad = false);
+
+	// As SC1628DDriver::displayHex(), on a page
+	//
+	void displayHex(uint8_t page, uint16_t value, bool zeroPad = false);
+
+	// As SC1628DDriver::displayText(), on a page
+	//
+	void displayText(uint8_t page, const char text[], uint8_t pos = 0);
+
+	// As SC1628DDriver::displayText_P(), on a page
+	//
+	void displayText_P(uint8_t page, const char text[], uint8_t pos = 0);
+
+private:
+	bool enter(uint8_t page);
+	void leave(uint8_t page);
+	void swap(uint8_t page);
+	void render(uint8_t page);
+	void checkLayout();
+
+	SC1628DDriver *m_display;
+	uint8_t m_count;
+	uint8_t m_visible;
+	bool m_batch;				// The batch state of the display, while a hidden page is updated
+	const SC1628DLayout *m_layout;	// Layout and filter the hidden pages are rendered with
+	void (*m_filter)(uint8_t digits[], uint16_t matrix[]);
+	uint8_t m_segments[SC1628D_PAGES_MAX][5];	// Hidden pages
+	uint16_t m_matrix[SC1628D_PAGES_MAX][7];	// Matrix of m_segments
+};
+
+#endif // __SC1628D_PAGES__
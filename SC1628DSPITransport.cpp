@@ -0,0 +1,110 @@
+/*
+ *  SC1628DSPITransport.cpp
+ *
+ *  Arduino Library for the SC1628D LED Driver IC
+ *  Hardware SPI transport
+ *
+ *  (c) 2022/07/13 philippe.corbes@gmail.com
+ *
+ *  This library is free software; you can redistribute it and/or
+ *  modify it under the terms of the GNU Lesser General Public
+ *  License as published by the Free Software Foundation; either
+ *  version 2.1 of the License, or (at your option) any later version.
+ *
+ *  This library is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ *  Lesser General Public License for more details.
+ *
+ *  You should have received a copy of the GNU Lesser General Public
+ *  License along with this library; if not, write to the Free Software
+ *  Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  USA
+ */
+
+#include <SC1628DSPITransport.h>
+#include <Arduino.h>
+
+
+SC1628DSPITransport::SC1628DSPITransport(uint8_t pinSTB, uint32_t clock, SPIClass &spi)
+	: m_spi(spi), m_settings(clock, LSBFIRST, SPI_MODE3)
+{
+	m_pinSTB.init(pinSTB);
+	m_strobe.set(SC1628D_TIMING_DATASHEET.strobe);
+	m_wait.set(SC1628D_TIMING_DATASHEET.wait);
+	m_reading = false;
+}
+
+void SC1628DSPITransport::setTiming(const SC1628DTiming &timing)
+{
+	uint32_t period = (uint32_t)timing.clockLow + timing.clockHigh;
+	uint32_t clock = period ? 1000000000UL / period : SC1628D_SPI_CLOCK;
+
+	// The datasheet pulse widths alone would give 1.25 MHz
+	if (clock > SC1628D_SPI_CLOCK)
+		clock = SC1628D_SPI_CLOCK;
+
+	m_settings = SPISettings(clock, LSBFIRST, SPI_MODE3);
+	m_strobe.set(timing.strobe);
+	m_wait.set(timing.wait);
+}
+
+void SC1628DSPITransport::begin()
+{
+	digitalWrite(m_pinSTB.pin, HIGH);
+	pinMode(m_pinSTB.pin, OUTPUT);
+	m_spi.begin();
+}
+
+void SC1628DSPITransport::start()
+{
+	m_spi.beginTransaction(m_settings);
+	m_pinSTB.write(LOW);
+	m_strobe.wait();
+}
+
+void SC1628DSPITransport::stop()
+{
+	if (m_reading)
+		driveDIO();
+	m_pinSTB.write(HIGH);
+	m_spi.endTransaction();
+	m_strobe.wait();
+}
+
+void SC1628DSPITransport::writeByte(uint8_t b)
+{
+	m_spi.transfer(b);
+}
+
+void SC1628DSPITransport::writeWord(uint16_t w)
+{
+	m_spi.transfer(w & 0xff);
+	m_spi.transfer(w >> 8);
+}
+
+uint8_t SC1628DSPITransport::readByte()
+{
+	// The chip drives DIO after the read command: MOSI must be released
+	// and the chip needs a wait time before the first clock.
+	if (!m_reading) {
+		releaseDIO();
+		m_wait.wait();
+	}
+	return m_spi.transfer(0xff);
+}
+
+void SC1628DSPITransport::releaseDIO()
+{
+	pinMode(MOSI, INPUT);
+	m_reading = true;
+}
+
+void SC1628DSPITransport::driveDIO()
+{
+#if defined(ESP8266)
+	pinMode(MOSI, SPECIAL);		// Give the pin back to the HSPI peripheral
+#else
+	pinMode(MOSI, OUTPUT);		// The SPI master keeps MOSI direction under user control
+#endif
+	m_reading = false;
+}
@@ -0,0 +1,82 @@
+/*
+ *  SC1628DSPITransport.h
+ *
+ *  Arduino Library for the SC1628D LED Driver IC
+ *  Hardware SPI transport
+ *
+ *  (c) 2022/07/13 philippe.corbes@gmail.com
+ *
+ *  This library is free software; you can redistribute it and/or
+ *  modify it under the terms of the GNU Lesser General Public
+ *  License as published by the Free Software Foundation; either
+ *  version 2.1 of the License, or (at your option) any later version.
+ *
+ *  This library is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ *  Lesser General Public License for more details.
+ *
+ *  You should have received a copy of the GNU Lesser General Public
+ *  License along with this library; if not, write to the Free Software
+ *  Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  USA
+ */
+
+#ifndef __SC1628D_SPI_TRANSPORT__
+#define __SC1628D_SPI_TRANSPORT__
+
+#include <SC1628DTransport.h>
+#include <SPI.h>
+
+// The chip accepts a clock up to 1 MHz
+#define SC1628D_SPI_CLOCK        1000000
+
+/*
+ Hardware SPI connection
+
+ SCK  --------------------- CLK
+ MOSI ---[ 1k ]---+-------- DIO
+ MISO ------------+
+ any pin ------------------ STB
+
+ The clock idles high and data is sampled on the rising edge (SPI mode 3),
+ LSB first. DIO is half-duplex: MOSI is released (set as input) while the
+ key scan bytes are read back through MISO.
+*/
+class SC1628DSPITransport : public SC1628DTransport {
+
+public:
+	// Initialize the transport.
+	//
+	// @param pinSTB - The number of the digital pin connected to the STB pin of the module
+	// @param clock - The SPI clock frequency in Hz
+	// @param spi - The SPI peripheral wired to CLK and DIO
+	//
+	SC1628DSPITransport(uint8_t pinSTB, uint32_t clock = SC1628D_SPI_CLOCK, SPIClass &spi = SPI);
+
+	// Start the SPI peripheral, to be called from setup()
+	//
+	void begin();
+
+	virtual void start();
+	virtual void stop();
+	virtual void writeByte(uint8_t b);
+	virtual void writeWord(uint16_t w);
+	virtual uint8_t readByte();
+
+	// Set the SPI clock from the clock pulse widths (up to SC1628D_SPI_CLOCK), the strobe and read wait times
+	//
+	virtual void setTiming(const SC1628DTiming &timing);
+
+private:
+	void releaseDIO();
+	void driveDIO();
+
+	SPIClass &m_spi;
+	SPISettings m_settings;
+	SC1628DPin m_pinSTB;
+	SC1628DDelay m_strobe;
+	SC1628DDelay m_wait;
+	bool m_reading;
+};
+
+#endif // __SC1628D_SPI_TRANSPORT__
@@ -0,0 +1,500 @@
+/*
+ *  SC1628DStatic.h
+ *
+ *  Arduino Library for the SC1628D LED Driver IC
+ *  Driver with the pins, layout and bus timings fixed at compile time
+ *
+ *  (c) 2022/07/13 philippe.corbes@gmail.com
+ *
+ *  This library is free software; you can redistribute it and/or
+ *  modify it under the terms of the GNU Lesser General Public
+ *  License as published by the Free Software Foundation; either
+ *  version 2.1 of the License, or (at your option) any later version.
+ *
+ *  This library is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ *  Lesser General Public License for more details.
+ *
+ *  You should have received a copy of the GNU Lesser General Public
+ *  License along with this library; if not, write to the Free Software
+ *  Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  USA
+ */
+
+#ifndef __SC1628D_STATIC__
+#define __SC1628D_STATIC__
+
+#include <Arduino.h>
+#include <SC1628D.h>
+#include <SC1628DCore.h>
+
+/*
+ Compile-time bus
+
+ The pin numbers and the timings are template parameters: each pin write is
+ a constant port access (a single sbi/cbi instruction on an ATmega328P, a
+ GPOS/GPOC store on an ESP8266), each delay a constant number of CPU cycles,
+ and the 8 bits of a byte are unrolled. The bus is a type: the pins are not
+ stored anywhere, and the display calls its functions directly. The layout
+ is a type too: its segment masks are constants of the rendering code.
+
+ Example, replacing SC1628D display(6, 5, 7):
+
+   typedef SC1628DStatic<6, 5, 7> Display;		// STB 6, CLK 5, DIO 7
+   Display display;
+*/
+
+// The ATmega328P/168 boards with the standard Arduino pin mapping
+#if defined(__AVR_ATmega328P__) || defined(__AVR_ATmega328__) || defined(__AVR_ATmega168__)
+	#define SC1628D_STATIC_AVR_STANDARD
+#endif
+
+
+// Bus timings in nanoseconds, as SC1628DTiming, for the compile-time bus
+template <uint16_t CLOCK_LOW, uint16_t CLOCK_HIGH, uint16_t SETUP, uint16_t HOLD, uint16_t STROBE, uint16_t WAIT>
+struct SC1628DStaticTiming {
+	enum {
+		low    = CLOCK_LOW > SETUP ? CLOCK_LOW : SETUP,		// CLK low, data set up
+		high   = CLOCK_HIGH > HOLD ? CLOCK_HIGH : HOLD,		// CLK high, data held
+		strobe = STROBE,
+		wait   = WAIT
+	};
+};
+
+// The SC1628D_TIMING_LEGACY, SC1628D_TIMING_STANDARD and SC1628D_TIMING_DATASHEET profiles
+typedef SC1628DStaticTiming<5000, 5000, 5000, 5000, 5000, 5000> SC1628DLegacyTiming;
+typedef SC1628DStaticTiming< 800,  800,  200,  200, 2000, 2000> SC1628DStandardTiming;
+typedef SC1628DStaticTiming< 400,  400,  100,  100, 1000, 1000> SC1628DDatasheetTiming;
+
+
+// A busy wait of a constant duration
+template <uint32_t NS>
+struct SC1628DStaticDelay {
+	static inline void wait() __attribute__((always_inline))
+	{
+#if defined(__AVR__)
+		if (NS * (F_CPU / 1000000UL) / 1000)
+			__builtin_avr_delay_cycles(NS * (F_CPU / 1000000UL) / 1000);
+#elif defined(ESP8266)
+		uint32_t start, now;
+		if (!(NS * (F_CPU / 1000000UL) / 1000))
+			return;
+		__asm__ __volatile__("rsr %0, ccount" : "=a"(start));
+		do {
+			__asm__ __volatile__("rsr %0, ccount" : "=a"(now));
+		} while (now - start < NS * (F_CPU / 1000000UL) / 1000);
+#elif defined(SIM_ARDUINO)
+		if (NS)
+			delayNanoseconds(NS);
+#else
+		if (NS)
+			delayMicroseconds((NS + 999) / 1000);
+#endif
+	}
+};
+
+
+// A digital pin known at compile time
+template <uint8_t PIN>
+struct SC1628DStaticPin {
+	static inline void write(uint8_t level) __attribute__((always_inline))
+	{
+#if defined(SC1628D_STATIC_AVR_STANDARD)
+		// Pins 0-7 on PORTD, 8-13 on PORTB, 14-19 (A0-A5) on PORTC
+		if (PIN < 8) {
+			if (level) PORTD |= 1 << (PIN & 7); else PORTD &= ~(1 << (PIN & 7));
+			return;
+		}
+		if (PIN < 14) {
+			if (level) PORTB |= 1 << (PIN & 7); else PORTB &= ~(1 << (PIN & 7));
+			return;
+		}
+		if (PIN < 20) {
+			if (level) PORTC |= 1 << ((PIN - 14) & 7); else PORTC &= ~(1 << ((PIN - 14) & 7));
+			return;
+		}
+#elif defined(ESP8266)
+		// GPIO16 is not part of the GPIO0-15 register block
+		if (PIN < 16) {
+			if (level) GPOS = 1UL << (PIN & 15); else GPOC = 1UL << (PIN & 15);
+			return;
+		}
+#endif
+		digitalWrite(PIN, level);
+	}
+
+	static inline uint8_t read() __attribute__((always_inline))
+	{
+#if defined(SC1628D_STATIC_AVR_STANDARD)
+		if (PIN < 8)
+			return (PIND >> (PIN & 7)) & 1;
+		if (PIN < 14)
+			return (PINB >> (PIN & 7)) & 1;
+		if (PIN < 20)
+			return (PINC >> ((PIN - 14) & 7)) & 1;
+#elif defined(ESP8266)
+		if (PIN < 16)
+			return (GPI >> (PIN & 15)) & 1;
+#endif
+		return digitalRead(PIN);
+	}
+};
+
+
+// Software (bit-banging) bus on three pins known at compile time
+//
+// A type rather than an object: its functions are static and called
+// directly, without a virtual call or a pointer to the bus. The bus of a
+// SC1628DStaticDriver may be any class with the same static functions.
+//
+template <uint8_t STB, uint8_t CLK, uint8_t DIO, class TIMING = SC1628DDatasheetTiming>
+struct SC1628DStaticBus {
+
+	// Set the pins as outputs, high
+	//
+	static void begin()
+	{
+		digitalWrite(STB, HIGH);
+		digitalWrite(CLK, HIGH);
+		digitalWrite(DIO, HIGH);
+		pinMode(STB, OUTPUT);
+		pinMode(CLK, OUTPUT);
+		pinMode(DIO, OUTPUT);
+	}
+
+	// Start a transaction (STB low)
+	//
+	static inline void start() __attribute__((always_inline))
+	{
+		SC1628DStaticPin<STB>::write(LOW);
+		SC1628DStaticDelay<TIMING::strobe>::wait();
+	}
+
+	// End a transaction (STB high)
+	//
+	static inline void stop() __attribute__((always_inline))
+	{
+		SC1628DStaticPin<STB>::write(HIGH);
+		SC1628DStaticDelay<TIMING::strobe>::wait();
+	}
+
+	// Send a command or data byte, LSB first, the 8 bits unrolled
+	//
+	static void writeByte(uint8_t b)
+	{
+		clockBit(b & 1);
+		clockBit((b >> 1) & 1);
+		clockBit((b >> 2) & 1);
+		clockBit((b >> 3) & 1);
+		clockBit((b >> 4) & 1);
+		clockBit((b >> 5) & 1);
+		clockBit((b >> 6) & 1);
+		clockBit((b >> 7) & 1);
+	}
+
+	// Send two data bytes, low byte first
+	//
+	static void writeWord(uint16_t w)
+	{
+		writeByte(w & 0xff);
+		writeByte(w >> 8);
+	}
+
+	// Receive a key scan byte, LSB first
+	//
+	// @param first true for the first byte after the read command, which needs a wait time
+	//
+	static uint8_t readByte(bool first)
+	{
+		uint8_t b = 0;
+
+		pinMode(DIO, INPUT_PULLUP);
+		if (first)
+			SC1628DStaticDelay<TIMING::wait>::wait();
+		for (uint8_t i = 0; i < 8; i++) {
+			SC1628DStaticPin<CLK>::write(LOW);
+			SC1628DStaticDelay<TIMING::low>::wait();
+			b = (b >> 1) | (SC1628DStaticPin<DIO>::read() ? 0x80 : 0);
+			SC1628DStaticPin<CLK>::write(HIGH);
+			SC1628DStaticDelay<TIMING::high>::wait();
+		}
+		pinMode(DIO, OUTPUT);
+		return b;
+	}
+
+	// Replay a compiled waveform (SC1628DWaveform)
+	//
+	static void writeWaveform(const uint8_t steps[], uint16_t length)
+	{
+		uint8_t previous = length ? ~steps[0] : 0;
+
+		for (uint16_t i = 0; i < length; i++) {
+			uint8_t step = steps[i];
+			uint8_t changed = step ^ previous;
+			previous = step;
+
+			if (changed & SC1628D_WAVE_CLK)
+				SC1628DStaticPin<CLK>::write(step & SC1628D_WAVE_CLK ? HIGH : LOW);
+			if (changed & SC1628D_WAVE_DIO)
+				SC1628DStaticPin<DIO>::write(step & SC1628D_WAVE_DIO ? HIGH : LOW);
+			if (changed & SC1628D_WAVE_STB) {
+				SC1628DStaticPin<STB>::write(step & SC1628D_WAVE_STB ? HIGH : LOW);
+				SC1628DStaticDelay<TIMING::strobe>::wait();
+			}
+			else if (step & SC1628D_WAVE_CLK)
+				SC1628DStaticDelay<TIMING::high>::wait();
+			else
+				SC1628DStaticDelay<TIMING::low>::wait();
+		}
+	}
+
+	// The timings are the TIMING template parameter: changing them does not compile
+	//
+	static void setTiming(const SC1628DTiming &)
+	{
+		static_assert(sizeof(TIMING) == 0, "the timings of SC1628DStaticBus are its TIMING parameter");
+	}
+
+private:
+	// One bit, LSB first: the chip samples DIO on the rising edge
+	static inline void clockBit(uint8_t bit) __attribute__((always_inline))
+	{
+		SC1628DStaticPin<CLK>::write(LOW);
+		SC1628DStaticPin<DIO>::write(bit);
+		SC1628DStaticDelay<TIMING::low>::wait();
+		SC1628DStaticPin<CLK>::write(HIGH);
+		SC1628DStaticDelay<TIMING::high>::wait();
+	}
+};
+
+
+// The compile-time bus as a SC1628DTransport, to use SC1628DDriver and its
+// tick() engines on it
+//
+// The timings are fixed: setTiming() has no effect.
+//
+template <uint8_t STB, uint8_t CLK, uint8_t DIO, class TIMING = SC1628DDatasheetTiming>
+class SC1628DStaticTransport : public SC1628DTransport {
+
+public:
+	// Initialize the transport, setting the pins as outputs, high
+	//
+	SC1628DStaticTransport()
+	{
+		Bus::begin();
+		m_reading = false;
+	}
+
+	virtual void start()
+	{
+		Bus::start();
+		m_reading = false;
+	}
+
+	virtual void stop()
+	{
+		Bus::stop();
+	}
+
+	virtual void writeByte(uint8_t b)
+	{
+		Bus::writeByte(b);
+	}
+
+	virtual void writeWord(uint16_t w)
+	{
+		Bus::writeByte(w & 0xff);
+		Bus::writeByte(w >> 8);
+	}
+
+	virtual uint8_t readByte()
+	{
+		uint8_t b = Bus::readByte(!m_reading);
+		m_reading = true;
+		return b;
+	}
+
+	virtual void writeWaveform(const uint8_t steps[], uint16_t length)
+	{
+		Bus::writeWaveform(steps, length);
+	}
+
+private:
+	typedef SC1628DStaticBus<STB, CLK, DIO, TIMING> Bus;
+
+	bool m_reading;				// Key bytes are being read in this transaction
+};
+
+
+// Layouts known at compile time, for SC1628DStaticDriver and SC1628DStatic
+//
+// A layout type holds a constexpr SC1628DLayout named layout: its masks become
+// constants of the code, the table is not stored. Your own wiring:
+//
+//   struct MyLayout {
+//       static constexpr SC1628DLayout layout = {{ ... }};
+//   };
+//
+struct SC1628DNormalLayout {
+	static constexpr SC1628DLayout layout = SC1628D_NORMAL_MAP;
+};
+
+#ifndef SC1628D_NO_INVERTED
+struct SC1628DInvertedLayout {
+	static constexpr SC1628DLayout layout = SC1628D_INVERTED_MAP;
+};
+#endif
+
+// The layout, the filter and the font chosen at run time with setLayout(),
+// setFilter() and setFont(), as on SC1628DDriver
+struct SC1628DRuntimeLayout {
+};
+
+
+// The segments of a position of a compile-time layout, written into the
+// display RAM words with constant masks: one segment per instantiation
+template <class LAYOUT, uint8_t POS, uint8_t SEGMENT = 0>
+struct SC1628DStaticPosition {
+	enum {
+		grid = LAYOUT::layout.map[POS][SEGMENT].grid,
+		mask = LAYOUT::layout.map[POS][SEGMENT].mask
+	};
+
+	static inline void render(uint8_t segments, uint16_t matrix[]) __attribute__((always_inline))
+	{
+		uint16_t on = -(uint16_t)((segments >> SEGMENT) & 1);
+		matrix[grid] = (matrix[grid] & (uint16_t)~mask) | (mask & on);
+		SC1628DStaticPosition<LAYOUT, POS, SEGMENT + 1>::render(segments, matrix);
+	}
+};
+
+template <class LAYOUT, uint8_t POS>
+struct SC1628DStaticPosition<LAYOUT, POS, 7> {
+	static inline void render(uint8_t, uint16_t []) __attribute__((always_inline))
+	{
+	}
+};
+
+
+// The rendering of SC1628DStaticDriver: a compile-time layout, and a font in
+// flash memory (PROGMEM) at a constant address
+//
+// Nothing is stored: the rendering of a position is a switch to its
+// constant masks, there is no filter.
+//
+template <class LAYOUT, const uint8_t *FONT>
+struct SC1628DStaticRender {
+	uint8_t glyph(uint8_t digit) const
+	{
+		return pgm_read_byte(&FONT[digit]);
+	}
+
+	uint8_t asciiGlyph(uint8_t c) const
+	{
+#ifndef SC1628D_NO_INVERTED
+		if (FONT == SC1628D_INVERTED_FONT)
+			return pgm_read_byte(&SC1628D_INVERTED_ASCII_FONT[c - ' ']);
+#endif
+		return pgm_read_byte(&SC1628D_ASCII_FONT[c - ' ']);
+	}
+
+	bool positional() const
+	{
+		return true;
+	}
+
+	void renderPosition(uint8_t pos, uint8_t segments, uint16_t matrix[]) const
+	{
+		switch (pos) {
+		case 0: SC1628DStaticPosition<LAYOUT, 0>::render(segments, matrix); break;
+		case 1: SC1628DStaticPosition<LAYOUT, 1>::render(segments, matrix); break;
+		case 2: SC1628DStaticPosition<LAYOUT, 2>::render(segments, matrix); break;
+		case 3: SC1628DStaticPosition<LAYOUT, 3>::render(segments, matrix); break;
+		default: SC1628DStaticPosition<LAYOUT, 4>::render(segments, matrix); break;
+		}
+	}
+
+	// Never called: the layout renders each position
+	void filter(uint8_t [], uint16_t []) const
+	{
+	}
+
+	// The font and the layout are template parameters: changing them does not compile
+	void setFont(const uint8_t [])
+	{
+		static_assert(sizeof(LAYOUT) == 0, "the font of SC1628DStatic is its FONT parameter, use SC1628DRuntimeLayout to set it at run time");
+	}
+
+	void setFont_P(const uint8_t [])
+	{
+		static_assert(sizeof(LAYOUT) == 0, "the font of SC1628DStatic is its FONT parameter, use SC1628DRuntimeLayout to set it at run time");
+	}
+
+	void setFilter(void (*)(uint8_t digit[], uint16_t matrix[]))
+	{
+		static_assert(sizeof(LAYOUT) == 0, "the layout of SC1628DStatic is its LAYOUT parameter, use SC1628DRuntimeLayout to set it at run time");
+	}
+
+	void setLayout(const SC1628DLayout &)
+	{
+		static_assert(sizeof(LAYOUT) == 0, "the layout of SC1628DStatic is its LAYOUT parameter, use SC1628DRuntimeLayout to set it at run time");
+	}
+
+	void setLayout_P(const SC1628DLayout &)
+	{
+		static_assert(sizeof(LAYOUT) == 0, "the layout of SC1628DStatic is its LAYOUT parameter, use SC1628DRuntimeLayout to set it at run time");
+	}
+};
+
+// The rendering of a layout type: SC1628DStaticRender, or SC1628DRuntimeRender
+// starting with FONT for SC1628DRuntimeLayout
+template <class LAYOUT, const uint8_t *FONT>
+struct SC1628DStaticRendering {
+	typedef SC1628DStaticRender<LAYOUT, FONT> type;
+};
+
+template <const uint8_t *FONT>
+struct SC1628DStaticRendering<SC1628DRuntimeLayout, FONT> {
+	struct type : SC1628DRuntimeRender {
+		type()
+		{
+			setFont_P(FONT);
+		}
+	};
+};
+
+
+// The display driver on a bus type, a layout and a font fixed at compile time
+//
+// The whole SC1628DDriver API, its tick() engines included, from the same
+// code (SC1628DCore). There is no transport, filter, font or layout pointer:
+// the bus functions are called directly, and each position is rendered with
+// the constant masks of the layout. setFont(), setFont_P(), setFilter(),
+// setLayout() and setLayout_P() only compile with SC1628DRuntimeLayout.
+//
+template <class BUS, class LAYOUT = SC1628DNormalLayout, const uint8_t *FONT = SC1628D_NORMAL_FONT>
+class SC1628DStaticDriver : public SC1628DCore<BUS, typename SC1628DStaticRendering<LAYOUT, FONT>::type> {
+
+public:
+	// Initialize the bus
+	//
+	SC1628DStaticDriver()
+	{
+		BUS::begin();
+	}
+};
+
+
+// The display driver on pins, a layout, timings and a font fixed at compile time
+//
+// The same API as SC1628D: a product switches over with a typedef. The
+// timings are a template parameter, so setTiming() and calibrate() do not
+// compile.
+//
+template <uint8_t STB, uint8_t CLK, uint8_t DIO,
+	class LAYOUT = SC1628DNormalLayout, class TIMING = SC1628DDatasheetTiming,
+	const uint8_t *FONT = SC1628D_NORMAL_FONT>
+class SC1628DStatic : public SC1628DStaticDriver<SC1628DStaticBus<STB, CLK, DIO, TIMING>, LAYOUT, FONT> {
+};
+
+#endif // __SC1628D_STATIC__
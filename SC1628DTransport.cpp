@@ -0,0 +1,385 @@
+/*
+ *  SC1628DTransport.cpp
+ *
+ *  Arduino Library for the SC1628D LED Driver IC
+ *  Serial bus transports used by the SC1628D class
+ *
+ *  (c) 2022/07/13 philippe.corbes@gmail.com
+ *
+ *  This library is free software; you can redistribute it and/or
+ *  modify it under the terms of the GNU Lesser General Public
+ *  License as published by the Free Software Foundation; either
+ *  version 2.1 of the License, or (at your option) any later version.
+ *
+ *  This library is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ *  Lesser General Public License for more details.
+ *
+ *  You should have received a copy of the GNU Lesser General Public
+ *  License along with this library; if not, write to the Free Software
+ *  Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  USA
+ */
+
+#include <SC1628DTransport.h>
+#include <Arduino.h>
+#if defined(__AVR__)
+#include <util/delay_basic.h>
+#elif defined(__linux__)
+#include <time.h>
+#endif
+
+
+// Clock low, clock high, setup, hold, strobe, wait
+const SC1628DTiming SC1628D_TIMING_LEGACY    = { 5000, 5000, 5000, 5000, 5000, 5000 };
+const SC1628DTiming SC1628D_TIMING_STANDARD  = {  800,  800,  200,  200, 2000, 2000 };
+const SC1628DTiming SC1628D_TIMING_DATASHEET = {  400,  400,  100,  100, 1000, 1000 };
+
+
+void SC1628DDelay::set(uint32_t ns)
+{
+	uint32_t n;
+#if defined(__AVR__)
+	// _delay_loop_2: 4 cycles per loop
+	n = (ns * (F_CPU / 1000000UL) / 1000 + 3) / 4;
+#elif defined(ESP8266)
+	// CPU cycles
+	n = ns * (F_CPU / 1000000UL) / 1000;
+#elif defined(SIM_ARDUINO)
+	// Nanoseconds, on the simulated core
+	n = ns;
+#elif defined(__linux__)
+	// Nanoseconds, on the monotonic clock
+	n = ns;
+#else
+	n = (ns + 999) / 1000;
+#endif
+	count = n > 0xffff ? 0xffff : n;
+}
+
+void SC1628DDelay::wait() const
+{
+	if (!count)
+		return;
+#if defined(__AVR__)
+	_delay_loop_2(count);
+#elif defined(ESP8266)
+	uint32_t start, now;
+	__asm__ __volatile__("rsr %0, ccount" : "=a"(start));
+	do {
+		__asm__ __volatile__("rsr %0, ccount" : "=a"(now));
+	} while (now - start < count);
+#elif defined(SIM_ARDUINO)
+	delayNanoseconds(count);
+#elif defined(__linux__)
+	struct timespec start, now;
+	clock_gettime(CLOCK_MONOTONIC, &start);
+	do {
+		clock_gettime(CLOCK_MONOTONIC, &now);
+	} while ((now.tv_sec - start.tv_sec) * 1000000000L + (now.tv_nsec - start.tv_nsec) < count);
+#else
+	delayMicroseconds(count);
+#endif
+}
+
+
+void SC1628DPin::init(uint8_t aPin)
+{
+	pin = aPin;
+#if defined(__AVR__)
+	uint8_t port = digitalPinToPort(pin);
+	mask = 0;
+	if (port != NOT_A_PIN) {
+		mask = digitalPinToBitMask(pin);
+		out = portOutputRegister(port);
+		in = portInputRegister(port);
+	}
+#elif defined(ESP8266)
+	// GPIO16 is not part of the GPIO0-15 register block
+	mask = (pin < 16) ? (1UL << pin) : 0;
+	out = &GPO;
+	in = &GPI;
+#endif
+}
+
+void SC1628DPin::write(uint8_t level) const
+{
+#if defined(__AVR__)
+	if (mask) {
+		// Read-modify-write of the port, protected against interrupts as digitalWrite does
+		uint8_t oldSREG = SREG;
+		cli();
+		if (level)
+			*out |= mask;
+		else
+			*out &= ~mask;
+		SREG = oldSREG;
+		return;
+	}
+#elif defined(ESP8266)
+	if (mask) {
+		// Dedicated set and clear registers, no read-modify-write needed
+		if (level)
+			GPOS = mask;
+		else
+			GPOC = mask;
+		return;
+	}
+#endif
+	digitalWrite(pin, level);
+}
+
+uint8_t SC1628DPin::read() const
+{
+#ifdef SC1628D_FAST_GPIO
+	if (mask)
+		return (*in & mask) ? HIGH : LOW;
+#endif
+	return digitalRead(pin);
+}
+
+
+//-----------------------------------------------------------------
+
+
+void SC1628DTransport::writeWord(uint16_t w)
+{
+	writeByte(w & 0xff);
+	writeByte(w >> 8);
+}
+
+void SC1628DTransport::setTiming(const SC1628DTiming &)
+{
+}
+
+void SC1628DTransport::writeWaveform(const uint8_t steps[], uint16_t length)
+{
+	uint8_t previous = SC1628D_WAVE_STB | SC1628D_WAVE_CLK;
+	uint8_t b = 0, bits = 0;
+
+	// A byte is complete on its 8th CLK rising edge
+	for (uint16_t i = 0; i < length; i++) {
+		uint8_t step = steps[i];
+		uint8_t changed = step ^ previous;
+		previous = step;
+
+		if ((changed & SC1628D_WAVE_STB) && !(step & SC1628D_WAVE_STB)) {
+			start();
+			bits = 0;
+		}
+		else if (changed & SC1628D_WAVE_STB)
+			stop();
+		else if ((changed & SC1628D_WAVE_CLK) && (step & SC1628D_WAVE_CLK)) {
+			b = (b >> 1) | ((step & SC1628D_WAVE_DIO) ? 0x80 : 0);
+			if (++bits == 8) {
+				writeByte(b);
+				bits = 0;
+			}
+		}
+	}
+}
+
+
+//-----------------------------------------------------------------
+
+
+SC1628DBitBangTransport::SC1628DBitBangTransport()
+{
+	setTiming(SC1628D_TIMING_LEGACY);
+}
+
+SC1628DBitBangTransport::SC1628DBitBangTransport(uint8_t pinSTB, uint8_t pinCLK, uint8_t pinDIO, unsigned int bitDelay)
+{
+	// Copy the pin numbers and resolve their port registers
+	m_pinSTB.init(pinSTB);
+	m_pinCLK.init(pinCLK);
+	m_pinDIO.init(pinDIO);
+
+	// The same delay for every step
+	uint16_t ns = bitDelay > 65 ? 65000 : bitDelay * 1000;
+	SC1628DTiming timing = { ns, ns, ns, ns, ns, ns };
+	setTiming(timing);
+
+	// Set the default value and pin direction.
+	// The levels are written first, so that STB and CLK do not glitch low
+	digitalWrite(m_pinSTB.pin, HIGH);
+	digitalWrite(m_pinCLK.pin, HIGH);
+	digitalWrite(m_pinDIO.pin, HIGH);
+    pinMode(m_pinSTB.pin, OUTPUT);
+    pinMode(m_pinCLK.pin, OUTPUT);
+    pinMode(m_pinDIO.pin, OUTPUT);
+}
+
+void SC1628DBitBangTransport::setTiming(const SC1628DTiming &timing)
+{
+	// DIO is set just after the CLK falling edge, and changed again after the next one
+	m_low.set(timing.clockLow > timing.setup ? timing.clockLow : timing.setup);
+	m_high.set(timing.clockHigh > timing.hold ? timing.clockHigh : timing.hold);
+	m_strobe.set(timing.strobe);
+	m_wait.set(timing.wait);
+}
+
+void SC1628DBitBangTransport::start()
+{
+	m_pinSTB.write(LOW);
+	m_reading = false;
+	m_strobe.wait();
+}
+
+void SC1628DBitBangTransport::stop()
+{
+	m_pinSTB.write(HIGH);
+	m_strobe.wait();
+}
+
+void SC1628DBitBangTransport::writeByte(uint8_t b)
+{
+	uint8_t data = b;
+
+	// 8 Data Bits
+	for(uint8_t i = 0; i < 8; i++) 
+	{
+		// CLK low
+		m_pinCLK.write(LOW);
+
+		// Set data bit
+		if (data & 0x01)
+			m_pinDIO.write(HIGH);
+		else
+			m_pinDIO.write(LOW);
+
+		m_low.wait();
+
+		// CLK high
+		m_pinCLK.write(HIGH);
+		m_high.wait();
+
+		data = data >> 1;
+	}
+}
+
+void SC1628DBitBangTransport::writeWord(uint16_t b)
+{
+	uint16_t data = b;
+
+	// 16 Data Bits
+	for(uint8_t i = 0; i < 16; i++) 
+	{
+		// CLK low
+		m_pinCLK.write(LOW);
+
+		// Set data bit
+		if (data & 0x01)
+			m_pinDIO.write(HIGH);
+		else
+			m_pinDIO.write(LOW);
+
+		m_low.wait();
+
+		// CLK high
+		m_pinCLK.write(HIGH);
+		m_high.wait();
+
+		data = data >> 1;
+	}
+}
+
+// One or two pin writes per step, the levels are not computed from the bytes
+void SC1628DBitBangTransport::writeWaveform(const uint8_t steps[], uint16_t length)
+{
+	if (length == 0)
+		return;
+	uint8_t previous = ~steps[0];
+
+#ifdef SC1628D_FAST_GPIO
+	// The port value of each combination of the line levels, when they share a port
+	if (m_pinSTB.mask && m_pinCLK.mask && m_pinDIO.mask && m_pinSTB.out == m_pinCLK.out && m_pinDIO.out == m_pinCLK.out) {
+		SC1628D_reg_t port[8];
+		SC1628D_reg_t all = m_pinSTB.mask | m_pinCLK.mask | m_pinDIO.mask;
+		for (uint8_t s = 0; s < 8; s++)
+			port[s] = ((s & SC1628D_WAVE_STB) ? m_pinSTB.mask : 0) | ((s & SC1628D_WAVE_CLK) ? m_pinCLK.mask : 0)
+				| ((s & SC1628D_WAVE_DIO) ? m_pinDIO.mask : 0);
+
+		for (uint16_t i = 0; i < length; i++) {
+			uint8_t step = steps[i] & 7;
+			uint8_t changed = step ^ previous;
+			previous = step;
+#if defined(__AVR__)
+			uint8_t oldSREG = SREG;
+			cli();
+			*m_pinCLK.out = (*m_pinCLK.out & ~all) | port[step];
+			SREG = oldSREG;
+#else
+			GPOC = all & ~port[step];
+			GPOS = port[step];
+#endif
+			if (changed & SC1628D_WAVE_STB)
+				m_strobe.wait();
+			else if (step & SC1628D_WAVE_CLK)
+				m_high.wait();
+			else
+				m_low.wait();
+		}
+		return;
+	}
+#endif
+
+	for (uint16_t i = 0; i < length; i++) {
+		uint8_t step = steps[i];
+		uint8_t changed = step ^ previous;
+		previous = step;
+
+		// CLK falls before DIO changes, as in writeByte()
+		if (changed & SC1628D_WAVE_CLK)
+			m_pinCLK.write(step & SC1628D_WAVE_CLK ? HIGH : LOW);
+		if (changed & SC1628D_WAVE_DIO)
+			m_pinDIO.write(step & SC1628D_WAVE_DIO ? HIGH : LOW);
+		if (changed & SC1628D_WAVE_STB) {
+			m_pinSTB.write(step & SC1628D_WAVE_STB ? HIGH : LOW);
+			m_strobe.wait();
+		}
+		else if (step & SC1628D_WAVE_CLK)
+			m_high.wait();
+		else
+			m_low.wait();
+	}
+}
+
+uint8_t SC1628DBitBangTransport::readByte()
+{
+	uint8_t temp = 0;
+
+	// Pull-up on
+//    pinMode(m_pinDIO, INPUT);
+//	digitalWrite(m_pinDIO, HIGH);
+    pinMode(m_pinDIO.pin, INPUT_PULLUP);
+
+	// The chip needs a wait time after the read command
+	if (!m_reading) {
+		m_wait.wait();
+		m_reading = true;
+	}
+
+	for (int i = 0; i < 8; i++) {
+		temp >>= 1;
+
+		// CLK low
+		m_pinCLK.write(LOW);
+
+		m_low.wait();
+
+		if (m_pinDIO.read()) {
+			temp |= 0x80;
+		}
+
+		// CLK high
+		m_pinCLK.write(HIGH);
+		m_high.wait();
+	}
+
+	// Pull-up off
+	pinMode(m_pinDIO.pin, OUTPUT);
+//	digitalWrite(m_pinDIO, LOW);
+
+	return temp;
+}
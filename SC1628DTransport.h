@@ -0,0 +1,184 @@
+/*
+ *  SC1628DTransport.h
+ *
+ *  Arduino Library for the SC1628D LED Driver IC
+ *  Serial bus transports used by the SC1628D class
+ *
+ *  (c) 2022/07/13 philippe.corbes@gmail.com
+ *
+ *  This library is free software; you can redistribute it and/or
+ *  modify it under the terms of the GNU Lesser General Public
+ *  License as published by the Free Software Foundation; either
+ *  version 2.1 of the License, or (at your option) any later version.
+ *
+ *  This library is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ *  Lesser General Public License for more details.
+ *
+ *  You should have received a copy of the GNU Lesser General Public
+ *  License along with this library; if not, write to the Free Software
+ *  Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  USA
+ */
+
+#ifndef __SC1628D_TRANSPORT__
+#define __SC1628D_TRANSPORT__
+
+#include <inttypes.h>
+
+#define SC1628D_BIT_DELAY        5		// Microseconds, SC1628D_TIMING_LEGACY
+
+// Direct port register access is used on the platforms where the pin to
+// register mapping is known, digitalWrite/digitalRead otherwise.
+#if defined(__AVR__)
+	#define SC1628D_FAST_GPIO
+	typedef uint8_t SC1628D_reg_t;
+#elif defined(ESP8266)
+	#define SC1628D_FAST_GPIO
+	typedef uint32_t SC1628D_reg_t;
+#endif
+
+
+// A digital pin, resolved once to its port registers when supported
+struct SC1628DPin {
+	uint8_t pin;					// Arduino pin number
+#ifdef SC1628D_FAST_GPIO
+	SC1628D_reg_t mask;				// Bit of the pin in its port, 0 to use digitalWrite
+	volatile SC1628D_reg_t *out;	// Output register
+	volatile SC1628D_reg_t *in;		// Input register
+#endif
+
+	// Resolve the port registers of an Arduino pin
+	void init(uint8_t aPin);
+
+	// Set the pin level (HIGH or LOW)
+	void write(uint8_t level) const;
+
+	// Get the pin level (HIGH or LOW)
+	uint8_t read() const;
+};
+
+
+// Serial bus timings, in nanoseconds
+struct SC1628DTiming {
+	uint16_t clockLow;		// CLK low pulse width
+	uint16_t clockHigh;		// CLK high pulse width
+	uint16_t setup;			// DIO set before the CLK rising edge
+	uint16_t hold;			// DIO held after the CLK rising edge
+	uint16_t strobe;		// STB high between transactions, and STB low before the first clock
+	uint16_t wait;			// Between the key read command and the first key bit
+};
+
+// 5 us per step, as the former bitDelay default
+extern const SC1628DTiming SC1628D_TIMING_LEGACY;
+
+// Twice the datasheet minimums, for long wires
+extern const SC1628DTiming SC1628D_TIMING_STANDARD;
+
+// The datasheet minimum pulse widths (SC1628DSPITransport still limits the clock to 1 MHz)
+extern const SC1628DTiming SC1628D_TIMING_DATASHEET;
+
+
+// A busy wait of a few nanoseconds to microseconds, counted in CPU cycles
+// where the CPU clock is known at compile time, in microseconds otherwise
+struct SC1628DDelay {
+	uint16_t count;					// Loops, cycles or microseconds, 0 for no wait
+
+	// Set the duration
+	void set(uint32_t ns);
+
+	// Wait for the duration
+	void wait() const;
+};
+
+
+// Line levels of a waveform step, see SC1628DWaveform
+#define SC1628D_WAVE_STB         0x01
+#define SC1628D_WAVE_CLK         0x02
+#define SC1628D_WAVE_DIO         0x04
+
+
+// The STB/CLK/DIO serial protocol of the chip: bytes are sent LSB first,
+// STB low frames a transaction, whose first byte is a command.
+class SC1628DTransport {
+
+public:
+	virtual ~SC1628DTransport() {}
+
+	// Start a transaction (STB low)
+	//
+	virtual void start() = 0;
+
+	// End a transaction (STB high)
+	//
+	virtual void stop() = 0;
+
+	// Send a command or data byte, LSB first
+	//
+	virtual void writeByte(uint8_t b) = 0;
+
+	// Send a 16-bit data word, LSB first
+	//
+	virtual void writeWord(uint16_t w);
+
+	// Receive a key scan byte, LSB first
+	//
+	virtual uint8_t readByte() = 0;
+
+	// Replay a compiled waveform (SC1628DWaveform)
+	//
+	// Each step is held for the strobe time after a STB edge, for the CLK low
+	// or high time otherwise. The default implementation sends the bytes of
+	// the waveform with start(), writeByte() and stop().
+	//
+	// @param steps The line levels, a combination of SC1628D_WAVE_xxx per step
+	// @param length The number of steps
+	//
+	virtual void writeWaveform(const uint8_t steps[], uint16_t length);
+
+	// Set the serial bus timings
+	//
+	// @param timing The timings in nanoseconds, a SC1628D_TIMING_xxx profile or your own
+	//
+	virtual void setTiming(const SC1628DTiming &timing);
+};
+
+
+// Software (bit-banging) implementation on any three digital pins
+class SC1628DBitBangTransport : public SC1628DTransport {
+
+public:
+	// An unconnected transport, pins are not touched
+	//
+	SC1628DBitBangTransport();
+
+	// Initialize the transport, setting the strobe, clock and data pins.
+	//
+	// @param pinSTB - The number of the digital pin connected to the STB pin of the module
+	// @param pinCLK - The number of the digital pin connected to the clock pin of the module
+	// @param pinDIO - The number of the digital pin connected to the DIO pin of the module
+	// @param bitDelay - The delay, in microseconds, between bit transition on the serial bus
+	//                   (up to 65), replaced by setTiming()
+	//
+	SC1628DBitBangTransport(uint8_t pinSTB, uint8_t pinCLK, uint8_t pinDIO, unsigned int bitDelay = SC1628D_BIT_DELAY);
+
+	virtual void start();
+	virtual void stop();
+	virtual void writeByte(uint8_t b);
+	virtual void writeWord(uint16_t w);
+	virtual uint8_t readByte();
+	virtual void setTiming(const SC1628DTiming &timing);
+	virtual void writeWaveform(const uint8_t steps[], uint16_t length);
+
+protected:
+	SC1628DPin m_pinSTB;
+	SC1628DPin m_pinCLK;
+	SC1628DPin m_pinDIO;
+	SC1628DDelay m_low;			// CLK low, data set up
+	SC1628DDelay m_high;		// CLK high, data held
+	SC1628DDelay m_strobe;
+	SC1628DDelay m_wait;
+	bool m_reading;				// Key bytes are being read in this transaction
+};
+
+#endif // __SC1628D_TRANSPORT__
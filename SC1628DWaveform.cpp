@@ -0,0 +1,103 @@
+/*
+ *  SC1628DWaveform.cpp
+ *
+ *  Arduino Library for the SC1628D LED Driver IC
+ *  Bus waveform compiled ahead of time, replayed without per bit logic
+ *
+ *  (c) 2022/07/13 philippe.corbes@gmail.com
+ *
+ *  This library is free software; you can redistribute it and/or
+ *  modify it under the terms of the GNU Lesser General Public
+ *  License as published by the Free Software Foundation; either
+ *  version 2.1 of the License, or (at your option) any later version.
+ *
+ *  This library is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ *  Lesser General Public License for more details.
+ *
+ *  You should have received a copy of the GNU Lesser General Public
+ *  License along with this library; if not, write to the Free Software
+ *  Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  USA
+ */
+
+
+#include <SC1628DWaveform.h>
+#include <SC1628D.h>
+
+// Steps of a transaction: STB low, 16 per byte, STB high
+#define WAVEFORM_STEPS(bytes)    (2 + 16 * (uint16_t)(bytes))
+
+
+SC1628DWaveform::SC1628DWaveform()
+{
+	clear();
+}
+
+void SC1628DWaveform::clear()
+{
+	m_length = 0;
+	m_transactions = 0;
+	m_frame = false;
+}
+
+bool SC1628DWaveform::addTransaction(const uint8_t bytes[], uint8_t length)
+{
+	if (m_length + WAVEFORM_STEPS(length) > SC1628D_WAVEFORM_STEPS)
+		return false;
+
+	// DIO keeps the last bit sent until the next CLK falling edge, high at first
+	uint8_t dio = m_length ? (m_steps[m_length - 1] & SC1628D_WAVE_DIO) : SC1628D_WAVE_DIO;
+	uint8_t *step = &m_steps[m_length];
+
+	*step++ = dio | SC1628D_WAVE_CLK;
+	for (uint8_t i = 0; i < length; i++) {
+		uint8_t b = bytes[i];
+		for (uint8_t bit = 0; bit < 8; bit++) {
+			dio = (b & 1) ? SC1628D_WAVE_DIO : 0;
+			*step++ = dio;
+			*step++ = dio | SC1628D_WAVE_CLK;
+			b >>= 1;
+		}
+	}
+	*step++ = dio | SC1628D_WAVE_CLK | SC1628D_WAVE_STB;
+
+	m_length += WAVEFORM_STEPS(length);
+	m_transactions++;
+	m_frame = false;
+	return true;
+}
+
+void SC1628DWaveform::compileFrame(const uint16_t matrix[], uint8_t control)
+{
+	uint8_t ram[15];
+
+	// The frame already compiled
+	if (m_frame && m_control == control) {
+		uint8_t k = 0;
+		while (k < 7 && m_matrix[k] == matrix[k])
+			k++;
+		if (k == 7)
+			return;
+	}
+
+	ram[0] = SC1628D_ADDRESS_SETTING_CMD;
+	for (uint8_t k = 0; k < 7; k++) {
+		ram[1 + 2*k] = matrix[k] & 0xff;
+		ram[2 + 2*k] = matrix[k] >> 8;
+	}
+	const uint8_t dataSetting = SC1628D_DATA_SETTING_CMD_WRITE | SC1628D_2_INCREMENT_ADDR;
+	const uint8_t mode = SC1628D_DISPLAY_MODE_CMD | SC1628D_7GRID_11SEG;
+
+	// Same order as a frame planned by SC1628D
+	clear();
+	addTransaction(&dataSetting, 1);
+	addTransaction(ram, sizeof(ram));
+	addTransaction(&mode, 1);
+	addTransaction(&control, 1);
+
+	for (uint8_t k = 0; k < 7; k++)
+		m_matrix[k] = matrix[k];
+	m_control = control;
+	m_frame = true;
+}
@@ -0,0 +1,117 @@
+/*
+ *  SC1628DWaveform.h
+ *
+ *  Arduino Library for the SC1628D LED Driver IC
+ *  Bus waveform compiled ahead of time, replayed without per bit logic
+ *
+ *  (c) 2022/07/13 philippe.corbes@gmail.com
+ *
+ *  This library is free software; you can redistribute it and/or
+ *  modify it under the terms of the GNU Lesser General Public
+ *  License as published by the Free Software Foundation; either
+ *  version 2.1 of the License, or (at your option) any later version.
+ *
+ *  This library is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ *  Lesser General Public License for more details.
+ *
+ *  You should have received a copy of the GNU Lesser General Public
+ *  License along with this library; if not, write to the Free Software
+ *  Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  USA
+ */
+
+
+#ifndef __SC1628D_WAVEFORM__
+#define __SC1628D_WAVEFORM__
+
+#include <inttypes.h>
+#include <SC1628DTransport.h>
+
+// A complete frame: 18 bytes of 16 steps, 4 transactions of 2 STB steps
+#define SC1628D_WAVEFORM_STEPS   296
+
+/*
+ Waveform
+
+ Each step is the level of the STB, CLK and DIO lines (SC1628D_WAVE_STB,
+ SC1628D_WAVE_CLK and SC1628D_WAVE_DIO) until the next step. A byte is 16
+ steps, CLK low with its data bit then CLK high, LSB first; a transaction
+ adds a STB low step before its first byte and a STB high step after its
+ last one.
+
+ The bits are shifted and the framing decided when the waveform is
+ compiled: the transport replays the steps as they are, so the bus time of
+ a waveform only depends on its length. A waveform can be kept and replayed
+ again, from a tight loop, a timer interrupt or a peripheral taking a table
+ of port values.
+*/
+
+// A compiled sequence of line levels
+class SC1628DWaveform {
+
+public:
+	// An empty waveform
+	//
+	SC1628DWaveform();
+
+	// Remove all the steps
+	//
+	void clear();
+
+	// Append a transaction
+	//
+	// @param bytes The bytes to send, command first
+	// @param length The number of bytes
+	// @return false if the waveform is full, it is then left unchanged
+	//
+	bool addTransaction(const uint8_t bytes[], uint8_t length);
+
+	// Compile a complete frame
+	//
+	// The data setting (address increment), the 14 display RAM bytes from
+	// address 0, the display mode and the display control: the frame does not
+	// depend on what the chip received before. Compiling the frame already
+	// compiled does nothing.
+	//
+	// @param matrix The 7 grid words, as made by a filter
+	// @param control The display control command (SC1628D_DISPLAY_CONTROL_CMD and brightness)
+	//
+	void compileFrame(const uint16_t matrix[], uint8_t control);
+
+	// Get the steps, to be replayed by SC1628DTransport::writeWaveform()
+	//
+	const uint8_t *steps() const { return m_steps; }
+
+	// Get the number of steps
+	//
+	uint16_t length() const { return m_length; }
+
+	// Get the number of transactions
+	//
+	uint8_t transactions() const { return m_transactions; }
+
+	// Check for a frame made by compileFrame()
+	//
+	// @return false if transactions were added, or nothing compiled
+	//
+	bool isFrame() const { return m_frame; }
+
+	// Get the display RAM words of the compiled frame
+	//
+	const uint16_t *matrix() const { return m_matrix; }
+
+	// Get the display control command of the compiled frame
+	//
+	uint8_t control() const { return m_control; }
+
+private:
+	uint8_t m_steps[SC1628D_WAVEFORM_STEPS];
+	uint16_t m_length;
+	uint8_t m_transactions;
+	bool m_frame;				// m_matrix and m_control describe the steps
+	uint16_t m_matrix[7];
+	uint8_t m_control;
+};
+
+#endif // __SC1628D_WAVEFORM__
@@ -29,11 +29,35 @@
 // The amount of time (in milliseconds) between tests
 #define TEST_DELAY   2000
 
+// Bargraph frames, in flash memory
+const SC1628DFrame bars[] PROGMEM = {
+  {TEST_DELAY/8, {0, 0, 0, 0,                 SEG_C                         | SEG_G}},
+  {TEST_DELAY/8, {0, 0, 0, 0,         SEG_B | SEG_C}},
+  {TEST_DELAY/8, {0, 0, 0, 0, SEG_A | SEG_B | SEG_C | SEG_D                 | SEG_G}},
+  {TEST_DELAY/8, {0, 0, 0, 0, SEG_A | SEG_B | SEG_C | SEG_D | SEG_E}},
+  {TEST_DELAY/8, {0, 0, 0, 0,         SEG_B | SEG_C | SEG_D | SEG_E | SEG_F | SEG_G}},
+  {TEST_DELAY/8, {0, 0, 0, 0,                 SEG_C | SEG_D | SEG_E | SEG_F}},
+  {TEST_DELAY/8, {0, 0, 0, 0,                         SEG_D | SEG_E | SEG_F | SEG_G}},
+  {TEST_DELAY/8, {0, 0, 0, 0,         SEG_B | SEG_C | SEG_D | SEG_E | SEG_F}},
+  {TEST_DELAY/8, {0, 0, 0, 0,                         SEG_D | SEG_E | SEG_F | SEG_G}},
+  {TEST_DELAY/8, {0, 0, 0, 0, 0}},
+  {TEST_DELAY/8, {0, 0, 0, 0, SEG_A | SEG_B | SEG_C | SEG_D | SEG_E | SEG_F | SEG_G}},
+  {TEST_DELAY/8, {0, 0, 0, 0, 0}},
+  {TEST_DELAY/8, {0, 0, 0, 0, SEG_A | SEG_B | SEG_C | SEG_D | SEG_E | SEG_F | SEG_G}},
+  {TEST_DELAY/8, {0, 0, 0, 0, 0}},
+};
+
 SC1628D sc1628d(SC1628D_STB, SC1628D_CLK, SC1628D_DIO);
 
+// State of the animation and of the key scan run by tick()
+SC1628DAnimation animation;
+SC1628DKeypad keypad;
+
 
 void setup()
 {
+  sc1628d.attachAnimation(&animation);
+  sc1628d.attachKeypad(&keypad);
   sc1628d.setBrightness(0); // 0-7
   sc1628d.clear();
 }
@@ -70,43 +94,32 @@ void loop()
   }
   sc1628d.setBrightness(0);
   
-  // Bargraph test
-  const uint8_t bars[][2] = {
-    {                SEG_C                         | SEG_G },
-    {        SEG_B | SEG_C },
-    {SEG_A | SEG_B | SEG_C | SEG_D                 | SEG_G },
-    {SEG_A | SEG_B | SEG_C | SEG_D | SEG_E },
-    {        SEG_B | SEG_C | SEG_D | SEG_E | SEG_F | SEG_G },
-    {                SEG_C | SEG_D | SEG_E | SEG_F },
-    {                        SEG_D | SEG_E | SEG_F | SEG_G },
-    {        SEG_B | SEG_C | SEG_D | SEG_E | SEG_F },
-    {                        SEG_D | SEG_E | SEG_F | SEG_G },
-    {0},
-    {SEG_A | SEG_B | SEG_C | SEG_D | SEG_E | SEG_F | SEG_G },
-    {0},
-    {SEG_A | SEG_B | SEG_C | SEG_D | SEG_E | SEG_F | SEG_G },
-    {0},
-  };
-  for(uint8_t k = 0; k < 14; k++) {
-    sc1628d.displaySegments(bars[k], 4, 1);
-    delay(TEST_DELAY/8);
-  }
+  // Bargraph test: an animation of the position 4, played from tick()
+  sc1628d.playAnimation(bars, sizeof(bars) / sizeof(bars[0]), SC1628D_ANIM_ONCE, 4, 1);
+  while (sc1628d.isAnimating())
+    sc1628d.tick();
 
   // Test digits update
-  uint8_t keys[] = {DIGIT_BLANK, DIGIT_BLANK, DIGIT_BLANK, DIGIT_BLANK, DIGIT_BLANK};
   for(uint8_t k = 0; k <= DIGIT_QUESTION; k++) {
     sc1628d.displayDigit(k, k%4);
     delay(TEST_DELAY/8);
   }
   delay(TEST_DELAY/2);
 
-  // Test keypad
+  // Test numbers: -1.20 to 1.20, the colon as decimal point
+  for(int16_t n = -120; n <= 120; n += 3) {
+    sc1628d.displayFixed(n, 2);
+    delay(TEST_DELAY/40);
+  }
+  sc1628d.displaySegment(0, SC1628D_SYM_POS);
+
+  // Test keypad: keys on KS3 to KS6, scanned every 10 ms
+  // Displays the event type (0 press, 1 release, 2 long, 3 repeat) and the key number
+  sc1628d.setKeyScan(10, SC1628D_KS(3) | SC1628D_KS(4) | SC1628D_KS(5) | SC1628D_KS(6));
   while(1) {
-    uint32_t key = sc1628d.getButtons();
-    keys[0] = (key/256)/16;
-    keys[1] = (key/256)%16;
-    keys[2] = (key%256)/16;
-    keys[3] = (key%256)%16;
-    sc1628d.displayDigits(keys);
+    SC1628DKeyEvent event;
+    sc1628d.tick();
+    if (sc1628d.pollKeyEvent(event))
+      sc1628d.displayHex(((uint16_t)event.type << 12) | event.key, true);
   }
 }
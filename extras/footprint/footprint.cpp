@@ -0,0 +1,168 @@
+/*
+ *  footprint.cpp
+ *
+ *  Sketch built by footprint.py to measure the flash and RAM cost of each
+ *  feature of the SC1628D library: FOOTPRINT_FEATURE selects the calls made.
+ *
+ *  (c) 2022/07/13 philippe.corbes@gmail.com
+ *
+ *  This library is free software; you can redistribute it and/or
+ *  modify it under the terms of the GNU Lesser General Public
+ *  License as published by the Free Software Foundation; either
+ *  version 2.1 of the License, or (at your option) any later version.
+ *
+ *  This library is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ *  Lesser General Public License for more details.
+ *
+ *  You should have received a copy of the GNU Lesser General Public
+ *  License along with this library; if not, write to the Free Software
+ *  Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  USA
+ */
+
+#include <Arduino.h>
+#include <SC1628D.h>
+#include <SC1628DGroup.h>
+#include <SC1628DPages.h>
+#include <SC1628DStatic.h>
+
+// Features, in the order of footprint.py
+#define FOOTPRINT_EMPTY       0		// No display, the Arduino core alone
+#define FOOTPRINT_CORE        1		// displayDigits
+#define FOOTPRINT_BUTTONS     2		// getButtons
+#define FOOTPRINT_NUMBERS     3		// displayNumber, displayFixed, displayHex
+#define FOOTPRINT_MARQUEE     4		// SC1628DMarquee, displayMarqueeDigits and tick
+#define FOOTPRINT_ANIMATION   5		// SC1628DAnimation, playAnimation and tick
+#define FOOTPRINT_KEYS        6		// SC1628DKeypad, setKeyScan, pollKeyEvent and tick
+#define FOOTPRINT_DIMMING     7		// SC1628DDimmer, setIntensity and tick
+#define FOOTPRINT_ASYNC       8		// setAsync and tick
+#define FOOTPRINT_MAILBOX     9		// attachMailbox and tick
+#define FOOTPRINT_INVERTED    10	// Inverted font and layout
+#define FOOTPRINT_GROUP       11	// SC1628DGroup of 4 modules
+#define FOOTPRINT_STATIC      12	// displayDigits on SC1628DStatic
+#define FOOTPRINT_LIMIT       13	// setRefreshLimit and tick
+#define FOOTPRINT_TEXT        14	// displayText
+#define FOOTPRINT_WAVEFORM    15	// compileSegments and sendWaveform
+#define FOOTPRINT_PAGES       16	// SC1628DPages of 3 pages
+#define FOOTPRINT_BLINK       17	// SC1628DBlinker, setBlink and tick
+
+#ifndef FOOTPRINT_FEATURE
+	#define FOOTPRINT_FEATURE FOOTPRINT_CORE
+#endif
+
+#define PIN_STB 6
+#define PIN_CLK 5
+#define PIN_DIO 7
+
+#if FOOTPRINT_FEATURE == FOOTPRINT_GROUP
+const uint8_t pinDIO[] = { 7, 8, 9, 10 };
+SC1628DGroup group(PIN_STB, PIN_CLK, pinDIO, 4);
+#elif FOOTPRINT_FEATURE == FOOTPRINT_STATIC
+SC1628DStatic<PIN_STB, PIN_CLK, PIN_DIO> display;
+#elif FOOTPRINT_FEATURE != FOOTPRINT_EMPTY
+SC1628D display(PIN_STB, PIN_CLK, PIN_DIO);
+#endif
+
+uint8_t digits[5] = { 1, 2, 3, 4, DIGIT_BLANK };
+
+#if FOOTPRINT_FEATURE == FOOTPRINT_MARQUEE
+SC1628DMarquee marquee;
+const uint8_t text[] = { 1, 2, 3, 4, 5, 6, 7, 8 };
+#elif FOOTPRINT_FEATURE == FOOTPRINT_ANIMATION
+SC1628DAnimation animation;
+const SC1628DFrame frames[] PROGMEM = {
+	{ 100, { SEG_A, SEG_A, SEG_A, SEG_A, 0 } },
+	{ 100, { SEG_G, SEG_G, SEG_G, SEG_G, 0 } },
+};
+#elif FOOTPRINT_FEATURE == FOOTPRINT_KEYS
+SC1628DKeypad keypad;
+#elif FOOTPRINT_FEATURE == FOOTPRINT_DIMMING
+SC1628DDimmer dimmer;
+#elif FOOTPRINT_FEATURE == FOOTPRINT_BLINK
+SC1628DBlinker blinker;
+#elif FOOTPRINT_FEATURE == FOOTPRINT_MAILBOX
+SC1628DMailbox mailbox;
+#elif FOOTPRINT_FEATURE == FOOTPRINT_WAVEFORM
+SC1628DWaveform wave;
+#elif FOOTPRINT_FEATURE == FOOTPRINT_PAGES
+SC1628DPages pages(display, 3);
+#endif
+
+void setup()
+{
+#if FOOTPRINT_FEATURE == FOOTPRINT_MARQUEE
+	display.attachMarquee(&marquee);
+	display.displayMarqueeDigits(text, sizeof(text), 200);
+#elif FOOTPRINT_FEATURE == FOOTPRINT_ANIMATION
+	display.attachAnimation(&animation);
+	display.playAnimation(frames, 2);
+#elif FOOTPRINT_FEATURE == FOOTPRINT_KEYS
+	display.attachKeypad(&keypad);
+	display.setKeyScan(10);
+#elif FOOTPRINT_FEATURE == FOOTPRINT_DIMMING
+	display.attachDimmer(&dimmer);
+	display.setIntensity(0, 1);
+#elif FOOTPRINT_FEATURE == FOOTPRINT_ASYNC
+	display.setAsync(true);
+#elif FOOTPRINT_FEATURE == FOOTPRINT_MAILBOX
+	display.attachMailbox(&mailbox);
+#elif FOOTPRINT_FEATURE == FOOTPRINT_LIMIT
+	display.setRefreshLimit(20, 10);
+#elif FOOTPRINT_FEATURE == FOOTPRINT_BLINK
+	display.attachBlinker(&blinker);
+	display.setBlink(1);
+#elif FOOTPRINT_FEATURE == FOOTPRINT_INVERTED
+	display.setFilter(&SC1628D_InvertedDisplay);
+	display.setFont(SC1628D_INVERTED_FONT);
+#endif
+}
+
+void loop()
+{
+	uint8_t value = millis();
+
+	digits[0] = value & 0x0f;
+#if FOOTPRINT_FEATURE == FOOTPRINT_EMPTY
+	digitalWrite(PIN_DIO, digits[0] & 1);
+#elif FOOTPRINT_FEATURE == FOOTPRINT_GROUP
+	group.displayDigits(value & 3, digits);
+	group.refresh();
+#elif FOOTPRINT_FEATURE == FOOTPRINT_BUTTONS
+	digits[1] = display.getButtons() & 0x0f;
+	display.displayDigits(digits);
+#elif FOOTPRINT_FEATURE == FOOTPRINT_NUMBERS
+	display.displayNumber(value);
+	display.displayFixed(value, 2);
+	display.displayHex(value);
+#elif FOOTPRINT_FEATURE == FOOTPRINT_TEXT
+	const char text[] = { (char)('A' + (value & 0x0f)), 'r', 'r', 0 };
+	display.displayText(text);
+#elif FOOTPRINT_FEATURE == FOOTPRINT_WAVEFORM
+	const uint8_t segments[5] = { value, 0, 0, 0, 0 };
+	display.compileSegments(wave, segments);
+	display.sendWaveform(wave);
+#elif FOOTPRINT_FEATURE == FOOTPRINT_PAGES
+	pages.displayNumber(1, value);
+	pages.displayDigits(2, digits);
+	pages.show((value >> 4) % 3);
+#elif FOOTPRINT_FEATURE == FOOTPRINT_KEYS
+	SC1628DKeyEvent event;
+	if (display.pollKeyEvent(event))
+		digits[1] = event.key & 0x0f;
+	display.displayDigits(digits);
+	display.tick();
+#elif FOOTPRINT_FEATURE == FOOTPRINT_MAILBOX
+	mailbox.frame()[0] = value;
+	mailbox.publish();
+	display.tick();
+#elif FOOTPRINT_FEATURE == FOOTPRINT_MARQUEE || FOOTPRINT_FEATURE == FOOTPRINT_ANIMATION
+	display.tick();
+#elif FOOTPRINT_FEATURE == FOOTPRINT_DIMMING || FOOTPRINT_FEATURE == FOOTPRINT_ASYNC || FOOTPRINT_FEATURE == FOOTPRINT_LIMIT \
+	|| FOOTPRINT_FEATURE == FOOTPRINT_BLINK
+	display.displayDigits(digits);
+	display.tick();
+#else
+	display.displayDigits(digits);
+#endif
+}
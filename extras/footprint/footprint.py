@@ -0,0 +1,114 @@
+#!/usr/bin/env python3
+#
+#  footprint.py
+#
+#  Flash and RAM cost of each feature of the SC1628D library, for each
+#  environment of platformio.ini.
+#
+#  The footprint.cpp sketch is built with PlatformIO ("pio ci") once per
+#  feature, and the sizes reported by the build are compared with the core
+#  feature (displayDigits only). The library itself costs the difference
+#  between the "core" and "empty" rows. The +RAM column is the state of
+#  the feature: the tick() engines are objects of their own, attached to
+#  the display by the sketch.
+#
+#  Usage: extras/footprint/footprint.py [--env NAME] [--flags "-DXXX"]
+#
+#  (c) 2022/07/13 philippe.corbes@gmail.com
+#
+#  This library is free software; you can redistribute it and/or
+#  modify it under the terms of the GNU Lesser General Public
+#  License as published by the Free Software Foundation; either
+#  version 2.1 of the License, or (at your option) any later version.
+#
+
+import argparse
+import configparser
+import os
+import re
+import shutil
+import subprocess
+import sys
+
+ROOT = os.path.abspath(os.path.join(os.path.dirname(__file__), "..", ".."))
+SKETCH = os.path.join(ROOT, "extras", "footprint", "footprint.cpp")
+
+# Feature name, FOOTPRINT_FEATURE value, extra build flags
+FEATURES = [
+    ("empty",       0,  ""),
+    ("core",        1,  ""),
+    ("buttons",     2,  ""),
+    ("numbers",     3,  ""),
+    ("marquee",     4,  ""),
+    ("animation",   5,  ""),
+    ("keys",        6,  ""),
+    ("dimming",     7,  ""),
+    ("async",       8,  ""),
+    ("mailbox",     9,  ""),
+    ("inverted",    10, ""),
+    ("group",       11, ""),
+    ("static",      12, ""),
+    ("limit",       13, ""),
+    ("text",        14, ""),
+    ("waveform",    15, ""),
+    ("pages",       16, ""),
+    ("blink",       17, ""),
+    ("stats",       1,  "-DSC1628D_STATS"),
+    ("no inverted", 1,  "-DSC1628D_NO_INVERTED"),
+    ("trace",       1,  "-DSC1628D_TRACE"),
+]
+
+# "RAM:   [=         ]   9.5% (used 195 bytes from 2048 bytes)"
+SIZE_RE = re.compile(r"^(RAM|Flash):.*\(used (\d+) bytes from (\d+) bytes\)", re.MULTILINE)
+
+
+def environments(ini):
+    config = configparser.ConfigParser()
+    config.read(ini)
+    envs = []
+    for section in config.sections():
+        if section.startswith("env:"):
+            envs.append((section[4:], config[section]))
+    return envs
+
+
+def build(env, feature, flags):
+    """Build the sketch, return (flash, ram) in bytes"""
+    options = ["platform = " + env.get("platform", ""), "framework = " + env.get("framework", "arduino")]
+    options.append("build_flags = -DFOOTPRINT_FEATURE=%d %s %s" % (feature, flags, env.get("build_flags", "")))
+    command = ["pio", "ci", SKETCH, "--lib", ROOT, "--board", env["board"]]
+    for option in options:
+        command += ["--project-option", option]
+    result = subprocess.run(command, stdout=subprocess.PIPE, stderr=subprocess.STDOUT, universal_newlines=True)
+    sizes = dict((m.group(1), int(m.group(2))) for m in SIZE_RE.finditer(result.stdout))
+    if result.returncode != 0 or "Flash" not in sizes:
+        sys.stderr.write(result.stdout)
+        raise RuntimeError("build failed: feature %d %s" % (feature, flags))
+    return sizes["Flash"], sizes.get("RAM", 0)
+
+
+def main():
+    parser = argparse.ArgumentParser(description="SC1628D flash and RAM footprint per feature")
+    parser.add_argument("--env", help="only this platformio.ini environment")
+    parser.add_argument("--flags", default="", help="build flags added to every build")
+    args = parser.parse_args()
+
+    if not shutil.which("pio"):
+        sys.exit("footprint.py: PlatformIO (pio) is not installed, nothing measured")
+
+    for name, env in environments(os.path.join(ROOT, "platformio.ini")):
+        if args.env and name != args.env:
+            continue
+        print("\n[%s] board %s" % (name, env["board"]))
+        print("%-12s %8s %8s %8s %8s" % ("feature", "flash", "RAM", "+flash", "+RAM"))
+        core = None
+        for feature, number, flags in FEATURES:
+            flash, ram = build(env, number, flags + " " + args.flags)
+            if feature == "core":
+                core = (flash, ram)
+            delta = ("%+8d %+8d" % (flash - core[0], ram - core[1])) if core and feature != "core" else ""
+            print("%-12s %8d %8d %s" % (feature, flash, ram, delta))
+
+
+if __name__ == "__main__":
+    main()
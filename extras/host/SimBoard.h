@@ -0,0 +1,105 @@
+/*
+ *  SimBoard.h
+ *
+ *  Fixture of the host checks and benchmark: the virtual clock restarted,
+ *  a simulated chip on the STB/CLK/DIO pins and a SC1628D driving them.
+ *
+ *  (c) 2022/07/13 philippe.corbes@gmail.com
+ *
+ *  This library is free software; you can redistribute it and/or
+ *  modify it under the terms of the GNU Lesser General Public
+ *  License as published by the Free Software Foundation; either
+ *  version 2.1 of the License, or (at your option) any later version.
+ *
+ *  This library is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ *  Lesser General Public License for more details.
+ *
+ *  You should have received a copy of the GNU Lesser General Public
+ *  License along with this library; if not, write to the Free Software
+ *  Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  USA
+ */
+
+#ifndef __SIM_BOARD_H__
+#define __SIM_BOARD_H__
+
+#include <SC1628D.h>
+#include <SimArduino.h>
+#include <SimChip.h>
+
+#define PIN_DIO 7
+#define PIN_STB 6
+#define PIN_CLK 5
+#define PIN_GROUP_DIO 8		// Group data lines 8 to 15, then a STB per module from 16
+
+// Key bytes of the simulated chip, and the getButtons() mask they give:
+// K1/KS1, K2/KS5, K2/KS6, K1/KS8, K2/KS9
+static const uint8_t SIM_KEYS[SIM_CHIP_KEY_BYTES] = { 0x01, 0x00, 0x12, 0x08, 0x02 };
+#define SIM_BUTTONS ((1UL << 0) | (1UL << 20) | (1UL << 21) | (1UL << 7) | (1UL << 24))
+
+// The virtual clock restarted, before the chips are connected to the pins
+struct SimReset {
+	SimReset(uint32_t accessNs = 0)
+	{
+		SimArduino::reset();
+		SimArduino::setAccessTime(accessNs);
+	}
+};
+
+// The display RAM of a chip holds a matrix
+inline bool SimShows(const SimChip &chip, const uint16_t matrix[])
+{
+	for (uint8_t k = 0; k < 7; k++)
+		if (chip.grid(k) != matrix[k])
+			return false;
+	return true;
+}
+
+// The display RAM of a chip holds 5 segments masks, rendered with a layout
+inline bool SimShows(const SimChip &chip, const uint8_t segments[], const SC1628DLayout &layout = SC1628D_NORMAL_LAYOUT)
+{
+	uint16_t matrix[7];
+	SC1628D_RenderLayout_P(layout, segments, matrix);
+	return SimShows(chip, matrix);
+}
+
+// A board with a chip on PIN_STB, PIN_CLK and PIN_DIO, driven by a SC1628D
+struct SimBoard : SimReset {
+	SimChip chip;
+	SC1628D display;
+
+	// @param bitDelay The bit delay of the display, in microseconds
+	// @param accessNs The virtual duration of a pin access
+	//
+	SimBoard(unsigned int bitDelay = SC1628D_BIT_DELAY, uint32_t accessNs = 0)
+		: SimReset(accessNs), chip(PIN_STB, PIN_CLK, PIN_DIO), display(PIN_STB, PIN_CLK, PIN_DIO, bitDelay)
+	{
+	}
+
+	// The display RAM holds the segments, rendered with a layout
+	bool shows(const uint8_t segments[], const SC1628DLayout &layout = SC1628D_NORMAL_LAYOUT) const
+	{
+		return SimShows(chip, segments, layout);
+	}
+
+	// The display RAM holds a matrix
+	bool shows(const uint16_t matrix[]) const
+	{
+		return SimShows(chip, matrix);
+	}
+
+	// No protocol error and no timing violation so far
+	bool clean() const
+	{
+		return chip.errors() == 0 && chip.timingErrors() == 0;
+	}
+
+	// The number of transactions decoded so far
+	size_t sent() const
+	{
+		return chip.transactions.size();
+	}
+};
+
+#endif // __SIM_BOARD_H__
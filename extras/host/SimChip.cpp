@@ -0,0 +1,192 @@
+/*
+ *  SimChip.cpp
+ *
+ *  Simulated SC1628D chip for the host build.
+ *
+ *  (c) 2022/07/13 philippe.corbes@gmail.com
+ *
+ *  This library is free software; you can redistribute it and/or
+ *  modify it under the terms of the GNU Lesser General Public
+ *  License as published by the Free Software Foundation; either
+ *  version 2.1 of the License, or (at your option) any later version.
+ *
+ *  This library is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ *  Lesser General Public License for more details.
+ *
+ *  You should have received a copy of the GNU Lesser General Public
+ *  License along with this library; if not, write to the Free Software
+ *  Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  USA
+ */
+
+#include <SimChip.h>
+
+
+SimChip::SimChip(uint8_t pinSTB, uint8_t pinCLK, uint8_t pinDIO)
+{
+	m_pinSTB = pinSTB;
+	m_pinCLK = pinCLK;
+	m_pinDIO = pinDIO;
+	memset(m_keys, 0, sizeof(m_keys));
+	m_outputDelay = 0;
+	reset();
+	SimArduino::attach(this);
+}
+
+SimChip::~SimChip()
+{
+	SimArduino::detach(this);
+}
+
+void SimChip::reset()
+{
+	memset(ram, 0, sizeof(ram));
+	mode = 0;
+	control = 0;
+	dataSetting = 0;
+	transactions.clear();
+	m_address = 0;
+	m_shift = 0;
+	m_bit = 0;
+	m_keyIndex = 0;
+	m_selected = false;
+	m_reading = false;
+	m_errors = 0;
+	m_timingErrors = 0;
+	m_clkTime = 0;
+	m_dioTime = 0;
+	m_stbTime = 0;
+	m_commandTime = 0;
+}
+
+void SimChip::setKeys(const uint8_t keys[])
+{
+	memcpy(m_keys, keys, sizeof(m_keys));
+}
+
+uint16_t SimChip::grid(uint8_t grid) const
+{
+	return ram[2*grid] | (ram[2*grid + 1] << 8);
+}
+
+void SimChip::pinChanged(uint8_t pin, uint8_t level)
+{
+	uint64_t now = SimArduino::now();
+
+	if (pin == m_pinDIO) {
+		// Hold time after the CLK rising edge, when DIO is written
+		if (m_selected && !m_reading && SimArduino::level(m_pinCLK) == HIGH && now - m_clkTime < SIM_CHIP_HOLD)
+			m_timingErrors++;
+		m_dioTime = now;
+		return;
+	}
+
+	if (pin == m_pinSTB) {
+		if (level == LOW) {
+			if (!transactions.empty() && now - m_stbTime < SIM_CHIP_PW_STB)
+				m_timingErrors++;
+			m_clkTime = now;
+			// Start of a transaction: the first byte is a command
+			SimTransaction t;
+			t.start = SimArduino::now();
+			t.end = 0;
+			t.bits = 0;
+			transactions.push_back(t);
+			m_selected = true;
+			m_reading = false;
+			m_bit = 0;
+			m_shift = 0;
+			m_keyIndex = 0;
+		}
+		else if (m_selected) {
+			if (m_bit != 0)
+				m_errors++;
+			transactions.back().end = now;
+			m_stbTime = now;
+			m_selected = false;
+			m_reading = false;
+			SimArduino::drive(m_pinDIO, HIGH);	// Released, pull-up
+		}
+		return;
+	}
+
+	if (pin != m_pinCLK || !m_selected)
+		return;
+
+	SimTransaction &t = transactions.back();
+	if (now - m_clkTime < SIM_CHIP_PW_CLK)
+		m_timingErrors++;
+	m_clkTime = now;
+
+	if (m_reading) {
+		// The chip shifts a key bit out on the falling edge, LSB first
+		if (level == LOW) {
+			if (m_bit == 0 && m_keyIndex == 0 && now - m_commandTime < SIM_CHIP_WAIT)
+				m_timingErrors++;
+			if (m_bit == 0)
+				t.keys.push_back(m_keyIndex < SIM_CHIP_KEY_BYTES ? m_keys[m_keyIndex] : 0);
+			uint8_t b = t.keys.back();
+			SimArduino::drive(m_pinDIO, (b >> m_bit) & 1, m_outputDelay);
+		}
+		else {
+			t.bits++;
+			if (++m_bit == 8) {
+				m_bit = 0;
+				m_keyIndex++;
+			}
+		}
+		return;
+	}
+
+	// The chip samples DIO on the rising edge, LSB first
+	if (level == HIGH) {
+		if (now - m_dioTime < SIM_CHIP_SETUP)
+			m_timingErrors++;
+		t.bits++;
+		if (SimArduino::level(m_pinDIO))
+			m_shift |= 1 << m_bit;
+		if (++m_bit == 8) {
+			uint8_t b = m_shift;
+			m_bit = 0;
+			m_shift = 0;
+			t.bytes.push_back(b);
+			byteReceived(b);
+			m_commandTime = now;
+		}
+	}
+}
+
+void SimChip::byteReceived(uint8_t b)
+{
+	SimTransaction &t = transactions.back();
+
+	// Data byte, written at the current address
+	if (t.bytes.size() > 1) {
+		if ((dataSetting & 0xc3) != 0x40) {
+			m_errors++;
+			return;
+		}
+		ram[m_address] = b;
+		if (!(dataSetting & 0x04))
+			m_address = (m_address + 1) % SIM_CHIP_RAM_SIZE;
+		return;
+	}
+
+	// First byte of a transaction: the command type is given by bits 7-6
+	switch (b & 0xc0) {
+	case 0x00:	// Command 1: display mode
+		mode = b;
+		break;
+	case 0x40:	// Command 2: data setting
+		dataSetting = b;
+		m_reading = (b & 0x03) == 0x02;
+		break;
+	case 0x80:	// Command 4: display control
+		control = b;
+		break;
+	case 0xc0:	// Command 3: address setting
+		m_address = (b & 0x0f) % SIM_CHIP_RAM_SIZE;
+		break;
+	}
+}
@@ -0,0 +1,114 @@
+/*
+ *  SimChip.h
+ *
+ *  Simulated SC1628D chip for the host build: decodes the STB/CLK/DIO
+ *  transitions of the simulated pins into commands and display RAM,
+ *  and answers key reads.
+ *
+ *  (c) 2022/07/13 philippe.corbes@gmail.com
+ *
+ *  This library is free software; you can redistribute it and/or
+ *  modify it under the terms of the GNU Lesser General Public
+ *  License as published by the Free Software Foundation; either
+ *  version 2.1 of the License, or (at your option) any later version.
+ *
+ *  This library is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ *  Lesser General Public License for more details.
+ *
+ *  You should have received a copy of the GNU Lesser General Public
+ *  License along with this library; if not, write to the Free Software
+ *  Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  USA
+ */
+
+#ifndef __SIM_CHIP_H__
+#define __SIM_CHIP_H__
+
+#include <SimArduino.h>
+#include <vector>
+
+#define SIM_CHIP_RAM_SIZE       14
+#define SIM_CHIP_KEY_BYTES      5
+
+// Minimum timings checked, in nanoseconds
+#define SIM_CHIP_PW_CLK         400		// CLK pulse width
+#define SIM_CHIP_SETUP          100		// DIO set before the CLK rising edge
+#define SIM_CHIP_HOLD           100		// DIO held after the CLK rising edge
+#define SIM_CHIP_PW_STB         1000	// STB high pulse width
+#define SIM_CHIP_WAIT           1000	// Read command to the first key bit
+
+// A decoded STB transaction
+struct SimTransaction {
+	uint64_t start;					// Virtual time of STB low, in nanoseconds
+	uint64_t end;					// Virtual time of STB high
+	std::vector<uint8_t> bytes;		// Bytes written, the first one is the command
+	std::vector<uint8_t> keys;		// Bytes read
+	unsigned int bits;				// Clock pulses
+};
+
+class SimChip : public SimDevice {
+
+public:
+	// Connect a simulated chip to the pins, the pins must be set up with SimArduino::reset() first
+	//
+	SimChip(uint8_t pinSTB, uint8_t pinCLK, uint8_t pinDIO);
+	virtual ~SimChip();
+
+	// Forget the chip state and the decoded transactions
+	//
+	void reset();
+
+	// Set the key scan bytes returned by the next key reads
+	//
+	void setKeys(const uint8_t keys[]);
+
+	// Get a grid word of the display RAM
+	//
+	// @param grid The grid number from 0 (GR1) to 6 (GR7)
+	//
+	uint16_t grid(uint8_t grid) const;
+
+	// Get the number of protocol errors (incomplete bytes, data without command...)
+	//
+	unsigned long errors() const { return m_errors; }
+
+	// Get the number of timing violations
+	//
+	unsigned long timingErrors() const { return m_timingErrors; }
+
+	// Set the delay of the key bits on DIO after the CLK falling edge (wiring, pull-up)
+	//
+	void setOutputDelay(uint32_t ns) { m_outputDelay = ns; }
+
+	virtual void pinChanged(uint8_t pin, uint8_t level);
+
+	uint8_t ram[SIM_CHIP_RAM_SIZE];			// Display RAM
+	uint8_t mode;							// Last display mode command
+	uint8_t control;						// Last display control command
+	uint8_t dataSetting;					// Last data setting command
+	std::vector<SimTransaction> transactions;
+
+private:
+	void byteReceived(uint8_t b);
+
+	uint8_t m_pinSTB;
+	uint8_t m_pinCLK;
+	uint8_t m_pinDIO;
+	uint8_t m_keys[SIM_CHIP_KEY_BYTES];
+	uint8_t m_address;
+	uint8_t m_shift;
+	uint8_t m_bit;
+	uint8_t m_keyIndex;
+	bool m_selected;
+	bool m_reading;
+	unsigned long m_errors;
+	unsigned long m_timingErrors;
+	uint32_t m_outputDelay;
+	uint64_t m_clkTime;			// Last CLK edge, or STB falling edge
+	uint64_t m_dioTime;			// Last DIO change
+	uint64_t m_stbTime;			// Last STB rising edge
+	uint64_t m_commandTime;		// End of the read command
+};
+
+#endif // __SIM_CHIP_H__
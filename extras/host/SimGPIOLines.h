@@ -0,0 +1,112 @@
+/*
+ *  SimGPIOLines.h
+ *
+ *  Stand-in for the Linux GPIO character device: the line requests and
+ *  ioctls of SC1628DLinuxGPIOTransport are applied to the simulated pins,
+ *  the line offsets being the pin numbers.
+ *
+ *  (c) 2022/07/13 philippe.corbes@gmail.com
+ *
+ *  This library is free software; you can redistribute it and/or
+ *  modify it under the terms of the GNU Lesser General Public
+ *  License as published by the Free Software Foundation; either
+ *  version 2.1 of the License, or (at your option) any later version.
+ *
+ *  This library is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ *  Lesser General Public License for more details.
+ *
+ *  You should have received a copy of the GNU Lesser General Public
+ *  License along with this library; if not, write to the Free Software
+ *  Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  USA
+ */
+
+#ifndef __SIM_GPIO_LINES_H__
+#define __SIM_GPIO_LINES_H__
+
+#if defined(__linux__)
+
+#include <SC1628DLinuxGPIOTransport.h>
+#include <SimArduino.h>
+#include <string.h>
+
+class SimGPIOLines : public SC1628DLinuxGPIOTransport {
+
+public:
+	SimGPIOLines(uint8_t stb, uint8_t clk, uint8_t dio) : SC1628DLinuxGPIOTransport("sim", stb, clk, dio), m_accesses(0) {}
+	virtual ~SimGPIOLines() { end(); }
+
+	// Line reads and writes, one call each with a line by line interface
+	unsigned long accesses() const { return m_accesses; }
+
+protected:
+	virtual int requestLines(struct gpio_v2_line_request &request)
+	{
+		memcpy(m_pins, request.offsets, sizeof(m_pins));
+		configure(request.config);
+		return 0;
+	}
+
+	virtual int control(unsigned long command, void *arg)
+	{
+		if (command == GPIO_V2_LINE_SET_VALUES_IOCTL) {
+			struct gpio_v2_line_values *values = (struct gpio_v2_line_values *)arg;
+			for (uint8_t i = 0; i < 3; i++)
+				if (values->mask & (1 << i)) {
+					digitalWrite(m_pins[i], (values->bits >> i) & 1);
+					m_accesses++;
+				}
+		}
+		else if (command == GPIO_V2_LINE_GET_VALUES_IOCTL) {
+			struct gpio_v2_line_values *values = (struct gpio_v2_line_values *)arg;
+			values->bits = 0;
+			for (uint8_t i = 0; i < 3; i++)
+				if (values->mask & (1 << i)) {
+					if (digitalRead(m_pins[i]))
+						values->bits |= 1 << i;
+					m_accesses++;
+				}
+		}
+		else if (command == GPIO_V2_LINE_SET_CONFIG_IOCTL)
+			configure(*(struct gpio_v2_line_config *)arg);
+		else
+			return -1;
+		return 0;
+	}
+
+	virtual void releaseLines() {}
+
+private:
+	// The flags and the output level of each line, the attributes override the flags
+	void configure(const struct gpio_v2_line_config &config)
+	{
+		for (uint8_t i = 0; i < 3; i++) {
+			uint64_t flags = config.flags;
+			int level = -1;
+			for (uint32_t a = 0; a < config.num_attrs; a++) {
+				if (!(config.attrs[a].mask & (1 << i)))
+					continue;
+				if (config.attrs[a].attr.id == GPIO_V2_LINE_ATTR_ID_FLAGS)
+					flags = config.attrs[a].attr.flags;
+				else if (config.attrs[a].attr.id == GPIO_V2_LINE_ATTR_ID_OUTPUT_VALUES)
+					level = (config.attrs[a].attr.values >> i) & 1;
+			}
+			if (flags & GPIO_V2_LINE_FLAG_OUTPUT) {
+				if (level >= 0)
+					digitalWrite(m_pins[i], level);
+				pinMode(m_pins[i], OUTPUT);
+			}
+			else
+				pinMode(m_pins[i], (flags & GPIO_V2_LINE_FLAG_BIAS_PULL_UP) ? INPUT_PULLUP : INPUT);
+			m_accesses++;
+		}
+	}
+
+	uint32_t m_pins[3];			// STB, CLK, DIO
+	unsigned long m_accesses;
+};
+
+#endif // __linux__
+
+#endif // __SIM_GPIO_LINES_H__
@@ -0,0 +1,100 @@
+/*
+ *  SimWorkload.h
+ *
+ *  Workload shared by the host checks and benchmark: the layouts and bit
+ *  delays measured, and the public calls made on a display.
+ *
+ *  (c) 2022/07/13 philippe.corbes@gmail.com
+ *
+ *  This library is free software; you can redistribute it and/or
+ *  modify it under the terms of the GNU Lesser General Public
+ *  License as published by the Free Software Foundation; either
+ *  version 2.1 of the License, or (at your option) any later version.
+ *
+ *  This library is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ *  Lesser General Public License for more details.
+ *
+ *  You should have received a copy of the GNU Lesser General Public
+ *  License along with this library; if not, write to the Free Software
+ *  Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  USA
+ */
+
+#ifndef __SIM_WORKLOAD_H__
+#define __SIM_WORKLOAD_H__
+
+#include <SC1628D.h>
+
+// The normal layout through the generic filter function path
+inline void SimCustomFilter(uint8_t digit[], uint16_t matrix[])
+{
+	SC1628D_RenderLayout_P(SC1628D_NORMAL_LAYOUT, digit, matrix);
+}
+
+struct SimLayout {
+	const char *name;
+	void (*filter)(uint8_t digit[], uint16_t matrix[]);
+};
+
+static const SimLayout SIM_LAYOUTS[] = {
+	{ "normal",   &SC1628D_NormalDisplay },
+	{ "inverted", &SC1628D_InvertedDisplay },
+	{ "filter",   &SimCustomFilter },
+};
+#define SIM_LAYOUT_COUNT (sizeof(SIM_LAYOUTS) / sizeof(SIM_LAYOUTS[0]))
+
+static const unsigned int SIM_BIT_DELAYS[] = { 5, 1, 0 };
+#define SIM_BIT_DELAY_COUNT (sizeof(SIM_BIT_DELAYS) / sizeof(SIM_BIT_DELAYS[0]))
+
+enum SimCall { DISPLAY_DIGIT, DISPLAY_DIGITS, DISPLAY_SEGMENTS, DISPLAY_NUMBER, DISPLAY_TEXT, GET_BUTTONS, CLEAR, SIM_CALLS };
+
+static const char *const SIM_CALL_NAMES[SIM_CALLS] = {
+	"displayDigit", "displayDigits", "displaySegments", "displayNumber", "displayText", "getButtons", "clear"
+};
+
+// Something to clear before each clear() call, not measured
+inline void SimPrepare(SC1628DDriver &display, SimCall c, unsigned long i)
+{
+	if (c == CLEAR)
+		display.displayDigit(8, i % 4);
+}
+
+// The call number i of a kind, with arguments changing at each call
+inline void SimRun(SC1628DDriver &display, SimCall c, unsigned long i)
+{
+	uint8_t digits[5] = {
+		(uint8_t)(i % 16), (uint8_t)((i + 1) % 16), (uint8_t)((i + 2) % 16), (uint8_t)((i + 3) % 16), DIGIT_BLANK
+	};
+	uint8_t segments[5] = {
+		(uint8_t)(i & 0x7f), (uint8_t)((i >> 1) & 0x7f), (uint8_t)((i >> 2) & 0x7f), (uint8_t)((i >> 3) & 0x7f), (uint8_t)((i >> 4) & 0x7f)
+	};
+	char text[6] = { (char)('A' + i % 26), (char)('a' + (i + 1) % 26), ':', (char)('0' + i % 10), 'r', 0 };
+
+	switch (c) {
+	case DISPLAY_DIGIT:    display.displayDigit(i % 16, i % 4); break;
+	case DISPLAY_DIGITS:   display.displayDigits(digits); break;
+	case DISPLAY_SEGMENTS: display.displaySegments(segments); break;
+	case DISPLAY_NUMBER:   display.displayNumber((long)(i * 7 % 2000) - 999); break;
+	case DISPLAY_TEXT:     display.displayText(text); break;
+	case GET_BUTTONS:      display.getButtons(); break;
+	case CLEAR:            display.clear(); break;
+	default:               break;
+	}
+}
+
+// Segments of the frame i of the waveform runs
+inline void SimWaveformSegments(unsigned long i, uint8_t segments[])
+{
+	for (uint8_t pos = 0; pos < 5; pos++)
+		segments[pos] = (uint8_t)((i + 1) * (pos * 2 + 37)) & 0x7f;
+}
+
+// Segments shown by the module m of a group at the frame i, different on each module
+inline void SimGroupSegments(uint8_t m, unsigned long i, uint8_t segments[])
+{
+	for (uint8_t p = 0; p < 5; p++)
+		segments[p] = (uint8_t)((i + m * 5 + p) * 37) & 0x7f;
+}
+
+#endif // __SIM_WORKLOAD_H__
@@ -0,0 +1,56 @@
+/*
+ *  Print.h
+ *
+ *  Simulated Arduino core for the host build: the Print base class of the
+ *  character outputs (Serial...), limited to the functions used by the
+ *  library and the host programs.
+ *
+ *  (c) 2022/07/13 philippe.corbes@gmail.com
+ *
+ *  This library is free software; you can redistribute it and/or
+ *  modify it under the terms of the GNU Lesser General Public
+ *  License as published by the Free Software Foundation; either
+ *  version 2.1 of the License, or (at your option) any later version.
+ *
+ *  This library is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ *  Lesser General Public License for more details.
+ *
+ *  You should have received a copy of the GNU Lesser General Public
+ *  License along with this library; if not, write to the Free Software
+ *  Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  USA
+ */
+
+#ifndef __SIM_PRINT_H__
+#define __SIM_PRINT_H__
+
+#include <stdint.h>
+#include <stddef.h>
+#include <string.h>
+
+class Print {
+
+public:
+	virtual ~Print() {}
+
+	// Write a character
+	//
+	// @return the number of characters written
+	//
+	virtual size_t write(uint8_t c) = 0;
+
+	virtual size_t write(const uint8_t *buffer, size_t size)
+	{
+		size_t n = 0;
+		while (size--)
+			n += write(*buffer++);
+		return n;
+	}
+
+	size_t print(const char *s) { return write((const uint8_t *)s, strlen(s)); }
+	size_t println() { return write('\r') + write('\n'); }
+	size_t println(const char *s) { return print(s) + println(); }
+};
+
+#endif // __SIM_PRINT_H__
@@ -0,0 +1,82 @@
+/*
+ *  SPI.cpp
+ *
+ *  Simulated SPI peripheral for the host build of the SC1628D library.
+ *
+ *  (c) 2022/07/13 philippe.corbes@gmail.com
+ *
+ *
+ *  This library is free software; you can redistribute it and/or
+ *  modify it under the terms of the GNU Lesser General Public
+ *  License as published by the Free Software Foundation; either
+ *  version 2.1 of the License, or (at your option) any later version.
+ *
+ *  This library is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ *  Lesser General Public License for more details.
+ *
+ *  You should have received a copy of the GNU Lesser General Public
+ *  License along with this library; if not, write to the Free Software
+ *  Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  USA
+ */
+
+#include <SPI.h>
+#include <SimArduino.h>
+
+SPIClass SPI;
+
+
+SPIClass::SPIClass()
+{
+}
+
+void SPIClass::begin()
+{
+	digitalWrite(SCK, HIGH);
+	pinMode(SCK, OUTPUT);
+	digitalWrite(MOSI, HIGH);
+	pinMode(MOSI, OUTPUT);
+}
+
+void SPIClass::end()
+{
+	pinMode(SCK, INPUT);
+	pinMode(MOSI, INPUT);
+}
+
+void SPIClass::beginTransaction(const SPISettings &settings)
+{
+	m_settings = settings;
+	digitalWrite(SCK, (m_settings.dataMode & SPI_MODE2) ? HIGH : LOW);
+}
+
+void SPIClass::endTransaction()
+{
+}
+
+uint8_t SPIClass::transfer(uint8_t data)
+{
+	uint8_t idle = (m_settings.dataMode & SPI_MODE2) ? HIGH : LOW;
+	bool late = (m_settings.dataMode & SPI_MODE1) != 0;
+	uint32_t half = m_settings.clock ? 500000000UL / m_settings.clock : 500;
+	uint8_t received = 0;
+
+	for (uint8_t i = 0; i < 8; i++) {
+		uint8_t bit = m_settings.bitOrder == LSBFIRST ? i : 7 - i;
+
+		// Modes 1 and 3 shift on the leading edge and sample on the trailing one
+		if (late)
+			digitalWrite(SCK, !idle);
+		if (SimArduino::mode(MOSI) == OUTPUT)
+			digitalWrite(MOSI, (data >> bit) & 1);
+		SimArduino::advance(half);
+		digitalWrite(SCK, late ? idle : !idle);
+		if (digitalRead(MISO))
+			received |= 1 << bit;
+		SimArduino::advance(half);
+		if (!late)
+			digitalWrite(SCK, idle);
+	}
+	return received;
+}
@@ -0,0 +1,81 @@
+/*
+ *  SPI.h
+ *
+ *  Simulated SPI peripheral for the host build of the SC1628D library.
+ *  The transfers clock the simulated SCK, MOSI and MISO pins. MOSI and
+ *  MISO are a single pin: on a real board the SC1628DSPITransport wiring
+ *  joins them to DIO through a resistor.
+ *
+ *  (c) 2022/07/13 philippe.corbes@gmail.com
+ *
+ *
+ *  This library is free software; you can redistribute it and/or
+ *  modify it under the terms of the GNU Lesser General Public
+ *  License as published by the Free Software Foundation; either
+ *  version 2.1 of the License, or (at your option) any later version.
+ *
+ *  This library is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ *  Lesser General Public License for more details.
+ *
+ *  You should have received a copy of the GNU Lesser General Public
+ *  License along with this library; if not, write to the Free Software
+ *  Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  USA
+ */
+
+#ifndef __SIM_SPI_H__
+#define __SIM_SPI_H__
+
+#include <Arduino.h>
+
+#define LSBFIRST        0
+#define MSBFIRST        1
+
+#define SPI_MODE0       0x00
+#define SPI_MODE1       0x04
+#define SPI_MODE2       0x08
+#define SPI_MODE3       0x0C
+
+// Simulated pins of the peripheral
+#define SCK             13
+#define MOSI            11
+#define MISO            11
+
+class SPISettings {
+
+public:
+	SPISettings(uint32_t clock = 4000000, uint8_t bitOrder = MSBFIRST, uint8_t dataMode = SPI_MODE0)
+		: clock(clock), bitOrder(bitOrder), dataMode(dataMode) {}
+
+	uint32_t clock;
+	uint8_t bitOrder;
+	uint8_t dataMode;
+};
+
+class SPIClass {
+
+public:
+	SPIClass();
+
+	// Set SCK and MOSI as outputs
+	//
+	void begin();
+	void end();
+
+	// Take the clock, bit order and mode, SCK goes to its idle level
+	//
+	void beginTransaction(const SPISettings &settings);
+	void endTransaction();
+
+	// Send a byte on MOSI while reading MISO, MOSI is only driven when it is an output
+	//
+	uint8_t transfer(uint8_t data);
+
+private:
+	SPISettings m_settings;
+};
+
+extern SPIClass SPI;
+
+#endif // __SIM_SPI_H__
@@ -0,0 +1,205 @@
+/*
+ *  SimArduino.cpp
+ *
+ *  Simulated Arduino core for the host build of the SC1628D library.
+ *
+ *  (c) 2022/07/13 philippe.corbes@gmail.com
+ *
+ *  This library is free software; you can redistribute it and/or
+ *  modify it under the terms of the GNU Lesser General Public
+ *  License as published by the Free Software Foundation; either
+ *  version 2.1 of the License, or (at your option) any later version.
+ *
+ *  This library is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ *  Lesser General Public License for more details.
+ *
+ *  You should have received a copy of the GNU Lesser General Public
+ *  License along with this library; if not, write to the Free Software
+ *  Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  USA
+ */
+
+#include <SimArduino.h>
+#include <algorithm>
+
+namespace {
+
+struct Pin {
+	uint8_t mode;
+	uint8_t output;		// Level written by the MCU
+	uint8_t driven;		// Level driven by a device when the pin is an input
+	uint8_t previous;	// Level driven before the last change,
+	uint64_t valid;		// until this time
+};
+
+Pin pins[SIM_PINS];
+uint64_t clock_ns;
+uint32_t access_ns;
+unsigned long edge_count;
+bool tracing;
+std::vector<SimEdge> edge_trace;
+std::vector<SimDevice *> devices;
+
+uint8_t wireLevel(const Pin &p)
+{
+	if (p.mode == OUTPUT)
+		return p.output;
+	return clock_ns < p.valid ? p.previous : p.driven;
+}
+
+void changed(uint8_t pin, uint8_t before)
+{
+	uint8_t after = wireLevel(pins[pin]);
+
+	if (after == before)
+		return;
+	edge_count++;
+	if (tracing) {
+		SimEdge e = { clock_ns, pin, after };
+		edge_trace.push_back(e);
+	}
+	for (size_t i = 0; i < devices.size(); i++)
+		devices[i]->pinChanged(pin, after);
+}
+
+}
+
+
+//-----------------------------------------------------------------
+
+
+void pinMode(uint8_t pin, uint8_t mode)
+{
+	uint8_t before = wireLevel(pins[pin]);
+
+	clock_ns += access_ns;
+	pins[pin].mode = mode;
+	changed(pin, before);
+}
+
+void digitalWrite(uint8_t pin, uint8_t val)
+{
+	uint8_t before = wireLevel(pins[pin]);
+
+	clock_ns += access_ns;
+	pins[pin].output = val ? HIGH : LOW;
+	changed(pin, before);
+}
+
+int digitalRead(uint8_t pin)
+{
+	clock_ns += access_ns;
+	return wireLevel(pins[pin]);
+}
+
+void delay(unsigned long ms)
+{
+	clock_ns += (uint64_t)ms * 1000000;
+}
+
+void delayMicroseconds(unsigned int us)
+{
+	clock_ns += (uint64_t)us * 1000;
+}
+
+void delayNanoseconds(unsigned long ns)
+{
+	clock_ns += ns;
+}
+
+unsigned long millis()
+{
+	return (unsigned long)(clock_ns / 1000000);
+}
+
+unsigned long micros()
+{
+	return (unsigned long)(clock_ns / 1000);
+}
+
+void noInterrupts()
+{
+}
+
+void interrupts()
+{
+}
+
+
+//-----------------------------------------------------------------
+
+
+void SimArduino::reset()
+{
+	for (int i = 0; i < SIM_PINS; i++) {
+		pins[i].mode = INPUT;
+		pins[i].output = LOW;
+		pins[i].driven = HIGH;		// Pull-up
+		pins[i].previous = HIGH;
+		pins[i].valid = 0;
+	}
+	clock_ns = 0;
+	access_ns = 0;
+	edge_count = 0;
+	tracing = false;
+	edge_trace.clear();
+	devices.clear();
+}
+
+uint64_t SimArduino::now()
+{
+	return clock_ns;
+}
+
+void SimArduino::advance(uint64_t ns)
+{
+	clock_ns += ns;
+}
+
+void SimArduino::setAccessTime(uint32_t ns)
+{
+	access_ns = ns;
+}
+
+void SimArduino::attach(SimDevice *device)
+{
+	devices.push_back(device);
+}
+
+void SimArduino::detach(SimDevice *device)
+{
+	devices.erase(std::remove(devices.begin(), devices.end(), device), devices.end());
+}
+
+void SimArduino::drive(uint8_t pin, uint8_t level, uint32_t delay)
+{
+	pins[pin].previous = clock_ns < pins[pin].valid ? pins[pin].previous : pins[pin].driven;
+	pins[pin].valid = clock_ns + delay;
+	pins[pin].driven = level ? HIGH : LOW;
+}
+
+uint8_t SimArduino::level(uint8_t pin)
+{
+	return wireLevel(pins[pin]);
+}
+
+uint8_t SimArduino::mode(uint8_t pin)
+{
+	return pins[pin].mode;
+}
+
+unsigned long SimArduino::edges()
+{
+	return edge_count;
+}
+
+void SimArduino::setTracing(bool on)
+{
+	tracing = on;
+}
+
+const std::vector<SimEdge> &SimArduino::trace()
+{
+	return edge_trace;
+}
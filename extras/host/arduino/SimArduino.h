@@ -0,0 +1,109 @@
+/*
+ *  SimArduino.h
+ *
+ *  Control of the simulated Arduino core: virtual clock, pin transitions
+ *  and simulated devices connected to the pins.
+ *
+ *  (c) 2022/07/13 philippe.corbes@gmail.com
+ *
+ *  This library is free software; you can redistribute it and/or
+ *  modify it under the terms of the GNU Lesser General Public
+ *  License as published by the Free Software Foundation; either
+ *  version 2.1 of the License, or (at your option) any later version.
+ *
+ *  This library is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ *  Lesser General Public License for more details.
+ *
+ *  You should have received a copy of the GNU Lesser General Public
+ *  License along with this library; if not, write to the Free Software
+ *  Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  USA
+ */
+
+#ifndef __SIM_ARDUINO_CONTROL_H__
+#define __SIM_ARDUINO_CONTROL_H__
+
+#include <Arduino.h>
+#include <vector>
+
+#define SIM_PINS        64
+
+// A device listening to the simulated pins
+class SimDevice {
+
+public:
+	virtual ~SimDevice() {}
+
+	// Called after each transition of an output pin
+	//
+	// @param pin The pin number
+	// @param level The new level
+	//
+	virtual void pinChanged(uint8_t pin, uint8_t level) = 0;
+};
+
+// A recorded pin transition
+struct SimEdge {
+	uint64_t time;		// Virtual time in nanoseconds
+	uint8_t pin;
+	uint8_t level;
+};
+
+class SimArduino {
+
+public:
+	// Restart the virtual clock, forget the pins, devices and trace
+	//
+	static void reset();
+
+	// Get the virtual time, in nanoseconds
+	//
+	static uint64_t now();
+
+	// Advance the virtual time
+	//
+	static void advance(uint64_t ns);
+
+	// Set the virtual duration of one digitalWrite/digitalRead call
+	//
+	// @param ns The duration in nanoseconds (0 by default)
+	//
+	static void setAccessTime(uint32_t ns);
+
+	// Connect a device to the pins
+	//
+	static void attach(SimDevice *device);
+
+	// Disconnect a device
+	//
+	static void detach(SimDevice *device);
+
+	// Set the level driven by a device on a pin, read by digitalRead in input mode
+	//
+	// @param delay The time in nanoseconds before the new level can be read
+	//
+	static void drive(uint8_t pin, uint8_t level, uint32_t delay = 0);
+
+	// Get the level of a pin as seen on the wire
+	//
+	static uint8_t level(uint8_t pin);
+
+	// Get the mode of a pin
+	//
+	static uint8_t mode(uint8_t pin);
+
+	// Get the number of transitions of the output pins since reset()
+	//
+	static unsigned long edges();
+
+	// Record the transitions in trace()
+	//
+	static void setTracing(bool on);
+
+	// Get the recorded transitions
+	//
+	static const std::vector<SimEdge> &trace();
+};
+
+#endif // __SIM_ARDUINO_CONTROL_H__
@@ -0,0 +1,550 @@
+/*
+ *  sc1628d_bench.cpp
+ *
+ *  Throughput benchmark of the SC1628D library on the simulated Arduino core.
+ *
+ *  For each public call, the bus time (virtual time between the first and
+ *  the last pin transition), the number of pin transitions, the number of
+ *  STB transactions and the host CPU time are reported, across layouts and
+ *  bit delays, followed by the cost of each feature. This is a report only:
+ *  the frames sent are checked by sc1628d_check.
+ *
+ *  Usage: sc1628d_bench [--quick] [--access-ns N]
+ *
+ *  (c) 2022/07/13 philippe.corbes@gmail.com
+ *
+ *  This library is free software; you can redistribute it and/or
+ *  modify it under the terms of the GNU Lesser General Public
+ *  License as published by the Free Software Foundation; either
+ *  version 2.1 of the License, or (at your option) any later version.
+ *
+ *  This library is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ *  Lesser General Public License for more details.
+ *
+ *  You should have received a copy of the GNU Lesser General Public
+ *  License along with this library; if not, write to the Free Software
+ *  Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  USA
+ */
+
+#include <SC1628DGroup.h>
+#include <SC1628DPages.h>
+#include <SC1628DStatic.h>
+#include <SimBoard.h>
+#include <SimGPIOLines.h>
+#include <SimWorkload.h>
+
+#include <chrono>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+namespace {
+
+struct Result {
+	uint64_t busNs;
+	unsigned long edges;
+	unsigned long transactions;
+	double cpuNs;
+};
+
+unsigned long iterations = 2000;
+uint32_t accessNs = 0;
+
+// Host CPU time, in nanoseconds
+class CpuTimer {
+public:
+	CpuTimer() : m_start(std::chrono::steady_clock::now()) {}
+	double ns() const { return std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - m_start).count(); }
+
+private:
+	std::chrono::steady_clock::time_point m_start;
+};
+
+Result measure(const SimLayout &layout, unsigned int bitDelay, SimCall c)
+{
+	Result r = { 0, 0, 0, 0 };
+	SimBoard board(bitDelay, accessNs);
+	board.display.setFilter(layout.filter);
+	board.display.setBrightness(2);
+	board.display.clear();
+
+	for (unsigned long i = 0; i < iterations; i++) {
+		SimPrepare(board.display, c, i);
+		unsigned long edges = SimArduino::edges();
+		size_t sent = board.sent();
+		uint64_t t0 = SimArduino::now();
+		CpuTimer cpu;
+		SimRun(board.display, c, i);
+		r.cpuNs += cpu.ns();
+		r.busNs += SimArduino::now() - t0;
+		r.edges += SimArduino::edges() - edges;
+		r.transactions += board.sent() - sent;
+	}
+	return r;
+}
+
+// Bytes sent per marquee step, against the full RAM burst
+void reportMarquee()
+{
+	SimBoard board(0, accessNs);
+	SC1628DMarquee marquee;
+	board.display.attachMarquee(&marquee);
+	const uint8_t text[] = { 0, 1, 2, 3, 4, 5, 6, 7, 8, 9, 10, 11, 12, 13, 14, 15 };
+	const int steps = 2 * (sizeof(text) + 4);
+	unsigned long bytes = 0;
+
+	board.display.displayMarqueeDigits(text, sizeof(text), 100, 4);
+	for (int step = 0; step < steps; step++) {
+		size_t sent = board.sent();
+		SimArduino::advance(100000000ULL);
+		board.display.tick();
+		for (size_t t = sent; t < board.sent(); t++)
+			bytes += board.chip.transactions[t].bytes.size();
+	}
+	printf("\nmarquee: %.1f bytes per step (full RAM burst: 16)\n", (double)bytes / steps);
+}
+
+struct Profile {
+	const char *name;
+	const SC1628DTiming *timing;
+};
+
+const Profile profiles[] = {
+	{ "legacy",    &SC1628D_TIMING_LEGACY },
+	{ "standard",  &SC1628D_TIMING_STANDARD },
+	{ "datasheet", &SC1628D_TIMING_DATASHEET },
+};
+
+// Frame and key scan time of each timing profile; calibrate() on a slow wiring
+void reportTiming()
+{
+	const uint8_t digits[2][5] = { { 1, 2, 3, 4, DIGIT_BLANK }, { 5, 6, 7, 8, DIGIT_BLANK } };
+
+	printf("\n%-10s %10s %14s %14s\n", "timing", "access ns", "frame us", "getButtons us");
+	for (size_t p = 0; p < sizeof(profiles) / sizeof(profiles[0]); p++) {
+		for (uint32_t access = 0; access <= 500; access += 500) {
+			SimBoard board(SC1628D_BIT_DELAY, access);
+			board.display.setTiming(*profiles[p].timing);
+			board.chip.setKeys(SIM_KEYS);
+			board.display.displayDigits(digits[1]);
+
+			uint64_t frameNs = 0, keysNs = 0;
+			for (unsigned long i = 0; i < iterations; i++) {
+				uint64_t t0 = SimArduino::now();
+				board.display.displayDigits(digits[i & 1]);
+				uint64_t t1 = SimArduino::now();
+				board.display.getButtons();
+				frameNs += t1 - t0;
+				keysNs += SimArduino::now() - t1;
+			}
+			printf("%-10s %10u %14.1f %14.1f\n", profiles[p].name, access,
+				frameNs / 1000.0 / iterations, keysNs / 1000.0 / iterations);
+		}
+	}
+
+	SimBoard board;
+	board.chip.setKeys(SIM_KEYS);
+	board.chip.setOutputDelay(1500);
+	printf("calibrate: datasheet timings x %u for key bits valid 1.5 us after CLK falls\n", board.display.calibrate());
+}
+
+// Frames and key scans on a display, with the datasheet timings
+template <class Display>
+void runFrames(Display &display, SimChip &chip, const char *name)
+{
+	double cpu = 0;
+
+	chip.setKeys(SIM_KEYS);
+	uint64_t t0 = SimArduino::now();
+	for (unsigned long i = 0; i < iterations; i++) {
+		uint8_t digits[5] = { (uint8_t)(i % 10), 2, 3, (uint8_t)(i % 7), DIGIT_BLANK };
+		CpuTimer timer;
+		display.displayDigits(digits);
+		display.getButtons();
+		cpu += timer.ns();
+	}
+	printf("%-22s %8u %10.1f %10.1f\n", name, (unsigned)sizeof(Display), (SimArduino::now() - t0) / 1000.0 / iterations, cpu / iterations);
+}
+
+// RAM of a display and of each tick() engine attached to it, on this host
+void reportSizes()
+{
+	printf("\n%-22s %8s\n", "host RAM", "sizeof");
+	printf("%-22s %8u\n", "SC1628DStatic", (unsigned)sizeof(SC1628DStatic<PIN_STB, PIN_CLK, PIN_DIO>));
+	printf("%-22s %8u\n", "SC1628DDriver", (unsigned)sizeof(SC1628DDriver));
+	printf("%-22s %8u\n", "+ SC1628DMarquee", (unsigned)sizeof(SC1628DMarquee));
+	printf("%-22s %8u\n", "+ SC1628DAnimation", (unsigned)sizeof(SC1628DAnimation));
+	printf("%-22s %8u\n", "+ SC1628DDimmer", (unsigned)sizeof(SC1628DDimmer));
+	printf("%-22s %8u\n", "+ SC1628DBlinker", (unsigned)sizeof(SC1628DBlinker));
+	printf("%-22s %8u\n", "+ SC1628DKeypad", (unsigned)sizeof(SC1628DKeypad));
+	printf("%-22s %8u\n", "+ SC1628DMailbox", (unsigned)sizeof(SC1628DMailbox));
+}
+
+// SC1628DStatic and the Linux GPIO transport against SC1628D
+void reportTransports()
+{
+	printf("\n%-22s %8s %10s %10s\n", "frame and key scan", "sizeof", "bus us", "cpu ns");
+	{
+		SimBoard board(SC1628D_BIT_DELAY, accessNs);
+		board.display.setTiming(SC1628D_TIMING_DATASHEET);
+		runFrames(board.display, board.chip, "SC1628D");
+	}
+	{
+		SimReset reset(accessNs);
+		SimChip chip(PIN_STB, PIN_CLK, PIN_DIO);
+		SC1628DStatic<PIN_STB, PIN_CLK, PIN_DIO> display;
+		runFrames(display, chip, "SC1628DStatic");
+	}
+#if defined(__linux__)
+	{
+		SimReset reset(accessNs);
+		SimChip chip(PIN_STB, PIN_CLK, PIN_DIO);
+		SimGPIOLines bus(PIN_STB, PIN_CLK, PIN_DIO);
+		bus.begin();
+		SC1628DDriver display(bus);
+		unsigned long calls = bus.calls(), accesses = bus.accesses();
+		runFrames(display, chip, "SC1628D linux gpio");
+		// One ioctl per half clock period where a line by line interface
+		// (sysfs, gpiod_line_set_value) needs one call per line access
+		printf("linux gpio: %.1f ioctls for %.1f line accesses per frame and key scan\n",
+			(double)(bus.calls() - calls) / iterations, (double)(bus.accesses() - accesses) / iterations);
+	}
+#endif
+}
+
+// Bus time range of a frame sent by a display function or as a waveform
+template <class Display>
+void runWaveform(Display &display, const char *name, int mode)
+{
+	const unsigned long frames = 10;
+	SC1628DWaveform cache[frames];
+	uint64_t busMin = ~0ULL, busMax = 0;
+	double cpu = 0;
+
+	for (unsigned long i = 0; mode == 2 && i < frames; i++) {
+		uint8_t segments[5];
+		SimWaveformSegments(i, segments);
+		display.compileSegments(cache[i], segments);
+	}
+	for (unsigned long i = 0; i < iterations; i++) {
+		uint8_t segments[5];
+		SC1628DWaveform wave;
+		SimWaveformSegments(i % frames, segments);
+
+		uint64_t t0 = SimArduino::now();
+		CpuTimer timer;
+		if (mode == 0)
+			display.displaySegments(segments);
+		else if (mode == 1) {
+			display.compileSegments(wave, segments);
+			display.sendWaveform(wave);
+		}
+		else
+			display.sendWaveform(cache[i % frames]);
+		cpu += timer.ns();
+		uint64_t bus = SimArduino::now() - t0;
+		if (bus < busMin) busMin = bus;
+		if (bus > busMax) busMax = bus;
+	}
+	printf("%-22s %10.1f %10.1f %10.1f\n", name, busMin / 1000.0, busMax / 1000.0, cpu / iterations);
+}
+
+// A compiled frame takes the same bus time whatever the frame
+void reportWaveform()
+{
+	static const char *const names[] = { "displaySegments", "compile and send", "cached waveforms" };
+
+	printf("\n%-22s %10s %10s %10s\n", "frame", "min us", "max us", "cpu ns");
+	for (int mode = 0; mode < 3; mode++) {
+		SimBoard board(SC1628D_BIT_DELAY, accessNs);
+		board.display.setTiming(SC1628D_TIMING_DATASHEET);
+		runWaveform(board.display, names[mode], mode);
+	}
+	{
+		SimReset reset(accessNs);
+		SimChip chip(PIN_STB, PIN_CLK, PIN_DIO);
+		SC1628DStatic<PIN_STB, PIN_CLK, PIN_DIO> display;
+		runWaveform(display, "SC1628DStatic cached", 2);
+	}
+#if defined(__linux__)
+	{
+		SimReset reset(accessNs);
+		SimChip chip(PIN_STB, PIN_CLK, PIN_DIO);
+		SimGPIOLines bus(PIN_STB, PIN_CLK, PIN_DIO);
+		bus.begin();
+		SC1628DDriver display(bus);
+		runWaveform(display, "linux gpio cached", 2);
+	}
+#endif
+}
+
+// Show one of the three screens, by drawing it again
+void drawScreen(SC1628DDriver &display, unsigned long screen)
+{
+	if (screen == 0)
+		display.displayNumber(215);
+	else if (screen == 1)
+		display.displayFixed(2150, 2);
+	else
+		display.displayText("On");
+}
+
+// Rotating three screens: showing their pages, or drawing each one again
+void reportPages()
+{
+	double cpu[3] = { 0, 0, 0 };
+	uint64_t bus[2] = { 0, 0 };
+
+	SimBoard board(SC1628D_BIT_DELAY, accessNs);
+	board.display.setTiming(SC1628D_TIMING_DATASHEET);
+	SC1628DPages pages(board.display, 3);
+
+	pages.displayNumber(0, 215);
+	CpuTimer timer;
+	pages.displayFixed(1, 2150, 2);
+	pages.displayText(2, "On");
+	cpu[2] = timer.ns();
+
+	for (int shown = 1; shown >= 0; shown--) {
+		uint64_t t0 = SimArduino::now();
+		for (unsigned long i = 0; i < iterations; i++) {
+			CpuTimer call;
+			if (shown)
+				pages.show(i % 3);
+			else
+				drawScreen(board.display, i % 3);
+			cpu[shown] += call.ns();
+		}
+		bus[shown] = SimArduino::now() - t0;
+	}
+	printf("\n%-22s %10s %10s\n", "screen switch", "bus us", "cpu ns");
+	printf("%-22s %10.1f %10.1f\n", "draw again", bus[0] / 1000.0 / iterations, cpu[0] / iterations);
+	printf("%-22s %10.1f %10.1f\n", "show page", bus[1] / 1000.0 / iterations, cpu[1] / iterations);
+	printf("%-22s %10.1f %10.1f\n", "hidden page update", 0.0, cpu[2] / 2);
+}
+
+// Bus bytes per blink phase change
+void reportBlink()
+{
+	const uint8_t blink[5] = { 0, 0xff, 0, SEG_A | SEG_D, 0 };
+	unsigned long flips = 0, bytes = 0, maxBytes = 0;
+
+	SimBoard board(SC1628D_BIT_DELAY, accessNs);
+	SC1628DBlinker blinker;
+	board.display.attachBlinker(&blinker);
+	board.display.setTiming(SC1628D_TIMING_DATASHEET);
+	board.display.displayNumber(1234);
+	board.display.setBlinkRate(500, 50);
+	for (uint8_t pos = 0; pos < 5; pos++)
+		board.display.setBlink(pos, blink[pos]);
+
+	for (unsigned long ms = 1; ms <= 2000; ms++) {
+		SimArduino::advance(1000000ULL);
+		size_t sent = board.sent();
+		board.display.tick();
+		if (board.sent() != sent) {
+			unsigned long flip = 0;
+			for (size_t t = sent; t < board.sent(); t++)
+				flip += board.chip.transactions[t].bytes.size();
+			flips++;
+			bytes += flip;
+			if (flip > maxBytes)
+				maxBytes = flip;
+		}
+	}
+	printf("\nblink: %lu phase changes in 2 s, %.1f bus bytes each (%lu at most), none between them\n",
+		flips, flips ? (double)bytes / flips : 0.0, maxBytes);
+}
+
+struct AccessTime {
+	const char *name;
+	uint32_t ns;
+};
+
+// Modeled duration of a pin access
+const AccessTime accessTimes[] = {
+	{ "AVR digitalWrite", 3400 },
+	{ "AVR port",          500 },
+	{ "ESP8266 GPOS",      100 },
+};
+
+// Bus time share of the per position intensity sub-frames
+void reportDimming()
+{
+	const uint8_t levels[5] = { 1, 2, SC1628D_DIM_LEVELS, 0, 3 };
+	const uint8_t digits[5] = { 8, 8, 8, 8, DIGIT_BLANK };
+	const unsigned long cycles = 50;
+
+	printf("\n%-17s %5s %12s\n", "dimming", "delay", "bus time %");
+	for (size_t a = 0; a < sizeof(accessTimes) / sizeof(accessTimes[0]); a++) {
+		for (size_t d = 0; d < SIM_BIT_DELAY_COUNT; d++) {
+			SimBoard board(SIM_BIT_DELAYS[d], accessTimes[a].ns);
+			SC1628DDimmer dimmer;
+			board.display.attachDimmer(&dimmer);
+			board.display.displayDigits(digits);
+			board.display.displaySegment(SEG_A, 4);
+			for (uint8_t pos = 0; pos < 5; pos++)
+				board.display.setIntensity(pos, levels[pos]);
+
+			uint64_t busNs = 0, t0 = SimArduino::now();
+			while (SimArduino::now() - t0 < cycles * SC1628D_DIM_LEVELS * SC1628D_DIM_PERIOD_US * 1000ULL) {
+				SimArduino::advance(100000);
+				uint64_t t = SimArduino::now();
+				board.display.tick();
+				busNs += SimArduino::now() - t;
+			}
+			printf("%-17s %5u %12.1f\n", accessTimes[a].name, SIM_BIT_DELAYS[d], 100.0 * busNs / (SimArduino::now() - t0));
+		}
+	}
+}
+
+struct RefreshLimit {
+	const char *name;
+	uint16_t interval;
+	uint8_t budget;
+};
+
+const RefreshLimit refreshLimits[] = {
+	{ "none",       0, 100 },
+	{ "20 ms",     20, 100 },
+	{ "10 % bus",   0,  10 },
+	{ "5 ms, 5 %",  5,   5 },
+};
+
+// Frame rate and bus time share of a number updated every 200 us
+void reportRefreshLimit()
+{
+	const unsigned long calls = 5000;
+
+	printf("\n%-17s %8s %12s\n", "refresh limit", "frames", "bus time %");
+	for (size_t l = 0; l < sizeof(refreshLimits) / sizeof(refreshLimits[0]); l++) {
+		SimBoard board(1, accessNs);
+		board.display.setRefreshLimit(refreshLimits[l].interval, refreshLimits[l].budget);
+
+		unsigned long frames = 0;
+		uint64_t busNs = 0, t0 = SimArduino::now();
+		for (unsigned long i = 0; i < calls; i++) {
+			SimArduino::advance(200000);
+			size_t sent = board.sent();
+			uint64_t t = SimArduino::now();
+			board.display.displayNumber(i);
+			board.display.tick();
+			busNs += SimArduino::now() - t;
+			frames += board.sent() != sent;
+		}
+		printf("%-17s %8lu %12.1f\n", refreshLimits[l].name, frames, 100.0 * busNs / (SimArduino::now() - t0));
+	}
+}
+
+// Refresh of a group of modules sharing CLK, against the same modules driven one by one
+void measureGroup(uint8_t count, unsigned int bitDelay, bool sharedSTB)
+{
+	uint8_t pinDIO[SC1628D_GROUP_MAX];
+	uint8_t pinSTB[SC1628D_GROUP_MAX];
+	SimChip *chips[SC1628D_GROUP_MAX];
+	uint8_t segments[5];
+	uint64_t groupNs = 0, singleNs = 0;
+
+	{
+		SimReset reset(accessNs);
+		for (uint8_t m = 0; m < count; m++) {
+			pinDIO[m] = PIN_GROUP_DIO + m;
+			pinSTB[m] = sharedSTB ? PIN_STB : PIN_GROUP_DIO + SC1628D_GROUP_MAX + m;
+			chips[m] = new SimChip(pinSTB[m], PIN_CLK, pinDIO[m]);
+		}
+		SC1628DGroup *group = sharedSTB ?
+			new SC1628DGroup(PIN_STB, PIN_CLK, pinDIO, count, bitDelay) :
+			new SC1628DGroup(pinSTB, PIN_CLK, pinDIO, count, bitDelay);
+		group->setBrightness(2);
+
+		for (unsigned long i = 0; i < iterations; i++) {
+			for (uint8_t m = 0; m < count; m++) {
+				SimGroupSegments(m, i, segments);
+				group->displaySegments(m, segments);
+			}
+			uint64_t t0 = SimArduino::now();
+			group->refresh();
+			groupNs += SimArduino::now() - t0;
+		}
+		delete group;
+		for (uint8_t m = 0; m < count; m++)
+			delete chips[m];
+	}
+
+	// The same frames sent to independent displays, one after the other
+	SimReset reset(accessNs);
+	SC1628D *displays[SC1628D_GROUP_MAX];
+	for (uint8_t m = 0; m < count; m++) {
+		chips[m] = new SimChip(PIN_GROUP_DIO + SC1628D_GROUP_MAX + m, PIN_CLK, PIN_GROUP_DIO + m);
+		displays[m] = new SC1628D(PIN_GROUP_DIO + SC1628D_GROUP_MAX + m, PIN_CLK, PIN_GROUP_DIO + m, bitDelay);
+		displays[m]->setBrightness(2);
+	}
+	for (unsigned long i = 0; i < iterations; i++) {
+		uint64_t t0 = SimArduino::now();
+		for (uint8_t m = 0; m < count; m++) {
+			SimGroupSegments(m, i, segments);
+			displays[m]->displaySegments(segments);
+		}
+		singleNs += SimArduino::now() - t0;
+	}
+	for (uint8_t m = 0; m < count; m++) {
+		delete displays[m];
+		delete chips[m];
+	}
+
+	printf("%7u %5u %-6s %14.1f %14.1f\n", count, bitDelay, sharedSTB ? "shared" : "one",
+		groupNs / 1000.0 / iterations, singleNs / 1000.0 / iterations);
+}
+
+}
+
+
+int main(int argc, char *argv[])
+{
+	const uint8_t groupSizes[] = { 1, 4, 8 };
+
+	for (int i = 1; i < argc; i++) {
+		if (!strcmp(argv[i], "--quick"))
+			iterations = 100;
+		else if (!strcmp(argv[i], "--access-ns") && i + 1 < argc)
+			accessNs = atoi(argv[++i]);
+		else {
+			printf("Usage: %s [--quick] [--access-ns N]\n", argv[0]);
+			return 2;
+		}
+	}
+
+	printf("%-9s %5s %-16s %12s %8s %6s %10s\n", "layout", "delay", "call", "bus us/call", "edges", "txn", "cpu ns");
+	for (size_t l = 0; l < SIM_LAYOUT_COUNT; l++) {
+		for (size_t d = 0; d < SIM_BIT_DELAY_COUNT; d++) {
+			for (int c = 0; c < SIM_CALLS; c++) {
+				Result r = measure(SIM_LAYOUTS[l], SIM_BIT_DELAYS[d], (SimCall)c);
+				printf("%-9s %5u %-16s %12.1f %8.1f %6.1f %10.1f\n",
+					SIM_LAYOUTS[l].name, SIM_BIT_DELAYS[d], SIM_CALL_NAMES[c],
+					r.busNs / 1000.0 / iterations, (double)r.edges / iterations,
+					(double)r.transactions / iterations, r.cpuNs / iterations);
+			}
+		}
+	}
+
+	reportMarquee();
+	reportTiming();
+	reportSizes();
+	reportTransports();
+	reportWaveform();
+	reportPages();
+	reportBlink();
+	reportDimming();
+	reportRefreshLimit();
+
+	printf("\n%7s %5s %-6s %14s %14s\n", "modules", "delay", "STB", "group us/frm", "single us/frm");
+	for (size_t n = 0; n < sizeof(groupSizes); n++) {
+		for (size_t d = 0; d < SIM_BIT_DELAY_COUNT; d++) {
+			measureGroup(groupSizes[n], SIM_BIT_DELAYS[d], true);
+			measureGroup(groupSizes[n], SIM_BIT_DELAYS[d], false);
+		}
+	}
+	return 0;
+}
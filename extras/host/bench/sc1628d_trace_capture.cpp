@@ -0,0 +1,102 @@
+/*
+ *  sc1628d_trace_capture.cpp
+ *
+ *  Bus trace of a display on the simulated chip, in the dumpTrace() format:
+ *  synchronous frames, a key scan, then asynchronous frames sent by tick().
+ *  After each "@=" line the decoder checks the display RAM it rebuilt
+ *  against the simulated chip.
+ *
+ *  Usage: sc1628d_trace_capture | extras/trace/sc1628d_trace.py --check
+ *
+ *  (c) 2022/07/13 philippe.corbes@gmail.com
+ *
+ *  This library is free software; you can redistribute it and/or
+ *  modify it under the terms of the GNU Lesser General Public
+ *  License as published by the Free Software Foundation; either
+ *  version 2.1 of the License, or (at your option) any later version.
+ *
+ *  This library is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ *  Lesser General Public License for more details.
+ *
+ *  You should have received a copy of the GNU Lesser General Public
+ *  License along with this library; if not, write to the Free Software
+ *  Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  USA
+ */
+
+#include <SC1628D.h>
+#include <SimArduino.h>
+#include <SimChip.h>
+
+#include <stdio.h>
+
+#define PIN_DIO 7
+#define PIN_STB 6
+#define PIN_CLK 5
+
+namespace {
+
+// Serial on the standard output
+class StdoutPrint : public Print {
+
+public:
+	virtual size_t write(uint8_t c)
+	{
+		// dumpTrace() ends its lines with CR LF, as Serial.println()
+		if (c != '\r')
+			putchar(c);
+		return 1;
+	}
+};
+
+StdoutPrint out;
+
+// Dump the trace, then the display RAM of the chip for the decoder to check
+void dump(SC1628DDriver &display, SimChip &chip)
+{
+	display.dumpTrace(out);
+	printf("@=");
+	for (uint8_t k = 0; k < 7; k++)
+		printf(" %02x%02x", chip.grid(k) & 0xff, chip.grid(k) >> 8);
+	printf("\n");
+}
+
+} // namespace
+
+int main()
+{
+	SimArduino::reset();
+	SimChip chip(PIN_STB, PIN_CLK, PIN_DIO);
+	SC1628D display(PIN_STB, PIN_CLK, PIN_DIO);
+	const uint8_t keys[SIM_CHIP_KEY_BYTES] = { 0x01, 0x00, 0x12, 0x00, 0x00 };
+	uint8_t digits[5] = { 1, 2, 3, 4, DIGIT_BLANK };
+
+	// Synchronous frames, 20 ms apart: the first one writes the whole RAM,
+	// the next ones the modified bytes only
+	display.clearTrace();
+	for (uint8_t i = 0; i < 4; i++) {
+		digits[3] = i;
+		display.displayDigits(digits);
+		SimArduino::advance(20000000ULL);
+	}
+	dump(display, chip);
+
+	display.setBrightness(3);
+	chip.setKeys(keys);
+	display.getButtons();
+	display.displayNumber(-12);
+	dump(display, chip);
+
+	// Frames sent a few bytes at a time by tick(), every millisecond
+	display.setAsync(true);
+	for (uint8_t i = 0; i < 3; i++) {
+		display.displayNumber(1000 + i * 111);
+		for (uint8_t t = 0; t < 20; t++) {
+			display.tick();
+			SimArduino::advance(1000000ULL);
+		}
+	}
+	dump(display, chip);
+	return chip.errors() ? 1 : 0;
+}
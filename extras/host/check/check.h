@@ -0,0 +1,62 @@
+/*
+ *  check.h
+ *
+ *  Pass/fail checks of the SC1628D library on the simulated Arduino core,
+ *  one per feature, run by sc1628d_check.
+ *
+ *  (c) 2022/07/13 philippe.corbes@gmail.com
+ *
+ *  This library is free software; you can redistribute it and/or
+ *  modify it under the terms of the GNU Lesser General Public
+ *  License as published by the Free Software Foundation; either
+ *  version 2.1 of the License, or (at your option) any later version.
+ *
+ *  This library is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ *  Lesser General Public License for more details.
+ *
+ *  You should have received a copy of the GNU Lesser General Public
+ *  License along with this library; if not, write to the Free Software
+ *  Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  USA
+ */
+
+#ifndef __SC1628D_CHECK_H__
+#define __SC1628D_CHECK_H__
+
+#include <SimBoard.h>
+#include <stdio.h>
+
+// Print the reason of a failure, return false
+bool fail(const char *format, ...) __attribute__((format(printf, 1, 2)));
+
+// Display functions and formatting (check_display.cpp)
+bool checkButtons();
+bool checkTables();
+bool checkBounds();
+bool checkCalls();
+bool checkNumbers();
+bool checkText();
+bool checkBatch();
+bool checkRefreshLimit();
+bool checkPages();
+
+// Modes driven by tick() (check_tick.cpp)
+bool checkMarquee();
+bool checkAnimation();
+bool checkMailbox();
+bool checkDimming();
+bool checkInterrupt();
+bool checkBlink();
+bool checkKeys();
+
+// Transports, timings and bus replays (check_bus.cpp)
+bool checkTiming();
+bool checkCalibrate();
+bool checkStatic();
+bool checkSPI();
+bool checkLinuxGPIO();
+bool checkWaveform();
+bool checkGroup();
+
+#endif // __SC1628D_CHECK_H__
@@ -0,0 +1,478 @@
+/*
+ *  check_bus.cpp
+ *
+ *  Checks of the bus: timing profiles and calibration, the compile time
+ *  pins, the SPI and Linux GPIO transports, waveforms and groups of modules.
+ *
+ *  (c) 2022/07/13 philippe.corbes@gmail.com
+ *
+ *  This library is free software; you can redistribute it and/or
+ *  modify it under the terms of the GNU Lesser General Public
+ *  License as published by the Free Software Foundation; either
+ *  version 2.1 of the License, or (at your option) any later version.
+ *
+ *  This library is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ *  Lesser General Public License for more details.
+ *
+ *  You should have received a copy of the GNU Lesser General Public
+ *  License along with this library; if not, write to the Free Software
+ *  Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  USA
+ */
+
+#include "check.h"
+
+#include <SC1628DGroup.h>
+#include <SC1628DMockTransport.h>
+#include <SC1628DSPITransport.h>
+#include <SC1628DStatic.h>
+#include <SimGPIOLines.h>
+#include <SimWorkload.h>
+#include <string.h>
+#include <vector>
+
+namespace {
+
+const unsigned long iterations = 100;
+
+const SC1628DTiming *const profiles[] = {
+	&SC1628D_TIMING_LEGACY, &SC1628D_TIMING_STANDARD, &SC1628D_TIMING_DATASHEET
+};
+
+// Frames and key scans on a display, with the datasheet timings: the keys
+// must be read back, and the last frame left on the chip
+template <class Display>
+bool runFrames(Display &display, SimChip &chip, uint16_t grid[])
+{
+	chip.setKeys(SIM_KEYS);
+	for (unsigned long i = 0; i < iterations; i++) {
+		uint8_t digits[5] = { (uint8_t)(i % 10), 2, 3, (uint8_t)(i % 7), DIGIT_BLANK };
+		display.displayDigits(digits);
+		if (display.getButtons() != SIM_BUTTONS)
+			return false;
+	}
+	for (uint8_t k = 0; k < 7; k++)
+		grid[k] = chip.grid(k);
+	return chip.errors() == 0 && chip.timingErrors() == 0;
+}
+
+// A product written for SC1628D, on any display with its API: numbers, text,
+// a batch, the refresh limit, the asynchronous mode and the tick() engines.
+// The bytes of all the transactions are returned, to compare the drivers.
+template <class Display>
+bool runProduct(Display &display, SimChip &chip, std::vector<uint8_t> &bus)
+{
+	SC1628DMarquee marquee;
+	SC1628DBlinker blinker;
+	SC1628DKeypad keypad;
+	SC1628DKeyEvent event;
+	const uint8_t digits[] = { 1, 2, 3, 4, 5, 6 };
+	unsigned events = 0;
+
+	chip.setKeys(SIM_KEYS);
+	display.attachMarquee(&marquee);
+	display.attachBlinker(&blinker);
+	display.attachKeypad(&keypad);
+	if (!display.setKeyScan(10) || !display.setBlink(SC1628D_SYM_POS, SC1628D_SYM_COLON))
+		return false;
+
+	display.displayNumber(-42);
+	display.displayText("HEAt");
+	display.displayFixed(1234, 2);
+	display.begin();
+	display.displayHex(0xbeef);
+	display.setBrightness(3);
+	display.requestButtons();
+	if (display.commit() != SIM_BUTTONS)
+		return false;
+
+	// Five updates per refresh interval, the keys scanned by tick()
+	display.setRefreshLimit(20);
+	for (int i = 0; i < 100; i++) {
+		display.displayNumber(i);
+		SimArduino::advance(4000000ULL);
+		display.tick();
+		while (display.pollKeyEvent(event))
+			events++;
+	}
+	display.setRefreshLimit(0);
+
+	display.displayMarqueeDigits(digits, sizeof(digits), 50);
+	for (int i = 0; i < 40; i++) {
+		SimArduino::advance(25000000ULL);
+		display.tick();
+	}
+	display.stopMarquee();
+	display.setBlink(SC1628D_SYM_POS, 0);
+
+	display.setAsync(true);
+	display.displayDigits(digits);
+	while (display.tick())
+		;
+	display.setAsync(false);
+
+	for (size_t t = 0; t < chip.transactions.size(); t++)
+		bus.insert(bus.end(), chip.transactions[t].bytes.begin(), chip.transactions[t].bytes.end());
+	return events != 0 && display.getKeys() == SIM_BUTTONS && chip.errors() == 0 && chip.timingErrors() == 0;
+}
+
+// Send frames with a display function, or with compiled waveforms, and check
+// that the display functions then find the same frame on the chip
+template <class Display>
+bool runWaveform(Display &display, SimChip &chip, int mode)
+{
+	const unsigned long frames = 10;
+	SC1628DWaveform cache[frames];
+
+	for (unsigned long i = 0; mode == 2 && i < frames; i++) {
+		uint8_t segments[5];
+		SimWaveformSegments(i, segments);
+		display.compileSegments(cache[i], segments);
+	}
+	for (unsigned long i = 0; i < iterations; i++) {
+		uint8_t segments[5];
+		SC1628DWaveform wave;
+		SimWaveformSegments(i % frames, segments);
+
+		if (mode == 0)
+			display.displaySegments(segments);
+		else if (mode == 1) {
+			display.compileSegments(wave, segments);
+			display.sendWaveform(wave);
+		}
+		else
+			display.sendWaveform(cache[i % frames]);
+
+		// Nothing left to send for these segments
+		size_t sent = chip.transactions.size();
+		display.displaySegments(segments);
+		if (chip.transactions.size() != sent)
+			return false;
+	}
+	return chip.errors() == 0 && chip.timingErrors() == 0;
+}
+
+// A group of modules sharing CLK must leave each module with its own frame and read its own keys
+bool runGroup(uint8_t count, unsigned int bitDelay, bool sharedSTB)
+{
+	uint8_t pinDIO[SC1628D_GROUP_MAX];
+	uint8_t pinSTB[SC1628D_GROUP_MAX];
+	SimChip *chips[SC1628D_GROUP_MAX];
+	uint8_t segments[5];
+	bool ok = true;
+
+	SimReset reset;
+	for (uint8_t m = 0; m < count; m++) {
+		pinDIO[m] = PIN_GROUP_DIO + m;
+		pinSTB[m] = sharedSTB ? PIN_STB : PIN_GROUP_DIO + SC1628D_GROUP_MAX + m;
+		chips[m] = new SimChip(pinSTB[m], PIN_CLK, pinDIO[m]);
+	}
+	SC1628DGroup *group = sharedSTB ?
+		new SC1628DGroup(PIN_STB, PIN_CLK, pinDIO, count, bitDelay) :
+		new SC1628DGroup(pinSTB, PIN_CLK, pinDIO, count, bitDelay);
+	group->setBrightness(2);
+
+	for (unsigned long i = 0; i < iterations; i++) {
+		for (uint8_t m = 0; m < count; m++) {
+			SimGroupSegments(m, i, segments);
+			group->displaySegments(m, segments);
+		}
+		group->refresh();
+	}
+
+	// The decoded display RAM of each module must hold its last frame
+	for (uint8_t m = 0; m < count; m++) {
+		SimGroupSegments(m, iterations - 1, segments);
+		ok = ok && SimShows(*chips[m], segments) && chips[m]->errors() == 0
+			&& (bitDelay == 0 || chips[m]->timingErrors() == 0);
+	}
+
+	// Each module scanned in parallel must return its own keys
+	uint32_t buttons[SC1628D_GROUP_MAX];
+	for (uint8_t m = 0; m < count; m++) {
+		uint8_t keys[SIM_CHIP_KEY_BYTES] = { 0, 0, 0, 0, 0 };
+		keys[m % SIM_CHIP_KEY_BYTES] = (uint8_t)(1 << (m / SIM_CHIP_KEY_BYTES));
+		chips[m]->setKeys(keys);
+	}
+	group->getButtons(buttons);
+	for (uint8_t m = 0; m < count; m++)
+		ok = ok && buttons[m] == SC1628D_KeyButtons((uint8_t)(1 << (m / SIM_CHIP_KEY_BYTES)), m % SIM_CHIP_KEY_BYTES)
+			&& chips[m]->errors() == 0;
+
+	delete group;
+	for (uint8_t m = 0; m < count; m++)
+		delete chips[m];
+	return ok;
+}
+
+} // namespace
+
+
+// Each timing profile must meet the chip timings, with fast and slow pin accesses
+bool checkTiming()
+{
+	const uint8_t digits[2][5] = { { 1, 2, 3, 4, DIGIT_BLANK }, { 5, 6, 7, 8, DIGIT_BLANK } };
+
+	for (size_t p = 0; p < sizeof(profiles) / sizeof(profiles[0]); p++) {
+		for (uint32_t access = 0; access <= 500; access += 500) {
+			SimBoard board(SC1628D_BIT_DELAY, access);
+			board.display.setTiming(*profiles[p]);
+			board.chip.setKeys(SIM_KEYS);
+			for (unsigned long i = 0; i < iterations; i++) {
+				board.display.displayDigits(digits[i & 1]);
+				if (board.display.getButtons() != SIM_BUTTONS)
+					return fail("timing profile %u (access %u ns): wrong buttons", (unsigned)p, access);
+			}
+			if (!board.clean())
+				return fail("timing profile %u (access %u ns): %lu violations", (unsigned)p, access, board.chip.timingErrors());
+		}
+	}
+	return true;
+}
+
+// Key bits valid 1.5 us after the CLK falling edge: the datasheet timings x 4 are needed
+bool checkCalibrate()
+{
+	SimBoard board;
+	board.chip.setKeys(SIM_KEYS);
+	board.chip.setOutputDelay(1500);
+	uint8_t scale = board.display.calibrate();
+	if (scale != 4)
+		return fail("datasheet timings x %u instead of x 4", scale);
+	if (board.display.getButtons() != SIM_BUTTONS || board.chip.timingErrors() != 0)
+		return fail("keys read after calibrate()");
+	return true;
+}
+
+// SC1628DStatic, and SC1628DDriver on SC1628DStaticTransport, must send the same frames as SC1628D,
+// and run the same product
+bool checkStatic()
+{
+	for (int inverted = 0; inverted < 2; inverted++) {
+		uint16_t dynamic[7], fixed[7];
+		{
+			SimBoard board;
+			board.display.setTiming(SC1628D_TIMING_DATASHEET);
+			if (inverted) {
+				board.display.setFilter(&SC1628D_InvertedDisplay);
+				board.display.setFont(SC1628D_INVERTED_FONT);
+			}
+			if (!runFrames(board.display, board.chip, dynamic))
+				return fail("SC1628D frames and key scans");
+		}
+		{
+			SimReset reset;
+			SimChip chip(PIN_STB, PIN_CLK, PIN_DIO);
+			bool ok;
+			if (inverted) {
+				SC1628DStatic<PIN_STB, PIN_CLK, PIN_DIO, SC1628DInvertedLayout, SC1628DDatasheetTiming, SC1628D_INVERTED_FONT> display;
+				ok = runFrames(display, chip, fixed);
+			}
+			else {
+				SC1628DStatic<PIN_STB, PIN_CLK, PIN_DIO> display;
+				ok = runFrames(display, chip, fixed);
+			}
+			if (!ok)
+				return fail("SC1628DStatic frames and key scans");
+		}
+		if (memcmp(dynamic, fixed, sizeof(fixed)))
+			return fail("SC1628DStatic display RAM (%s)", inverted ? "inverted" : "normal");
+		{
+			SimReset reset;
+			SimChip chip(PIN_STB, PIN_CLK, PIN_DIO);
+			SC1628DStaticTransport<PIN_STB, PIN_CLK, PIN_DIO> bus;
+			SC1628DDriver display(bus);
+			if (inverted) {
+				display.setFilter(&SC1628D_InvertedDisplay);
+				display.setFont(SC1628D_INVERTED_FONT);
+			}
+			if (!runFrames(display, chip, fixed))
+				return fail("SC1628DStaticTransport frames and key scans");
+		}
+		if (memcmp(dynamic, fixed, sizeof(fixed)))
+			return fail("SC1628DStaticTransport display RAM (%s)", inverted ? "inverted" : "normal");
+	}
+
+	// A product switched over with a typedef must send the same bytes
+	for (int inverted = 0; inverted < 2; inverted++) {
+		std::vector<uint8_t> dynamic, fixed, runtime;
+		{
+			SimBoard board;
+			board.display.setTiming(SC1628D_TIMING_DATASHEET);
+			if (inverted) {
+				board.display.setFilter(&SC1628D_InvertedDisplay);
+				board.display.setFont(SC1628D_INVERTED_FONT);
+			}
+			if (!runProduct(board.display, board.chip, dynamic))
+				return fail("SC1628D product");
+		}
+		{
+			SimReset reset;
+			SimChip chip(PIN_STB, PIN_CLK, PIN_DIO);
+			bool ok;
+			if (inverted) {
+				SC1628DStatic<PIN_STB, PIN_CLK, PIN_DIO, SC1628DInvertedLayout, SC1628DDatasheetTiming, SC1628D_INVERTED_FONT> display;
+				ok = runProduct(display, chip, fixed);
+			}
+			else {
+				SC1628DStatic<PIN_STB, PIN_CLK, PIN_DIO> display;
+				ok = runProduct(display, chip, fixed);
+			}
+			if (!ok)
+				return fail("SC1628DStatic product");
+		}
+		{
+			SimReset reset;
+			SimChip chip(PIN_STB, PIN_CLK, PIN_DIO);
+			SC1628DStatic<PIN_STB, PIN_CLK, PIN_DIO, SC1628DRuntimeLayout> display;
+			if (inverted) {
+				display.setFilter(&SC1628D_InvertedDisplay);
+				display.setFont(SC1628D_INVERTED_FONT);
+			}
+			if (!runProduct(display, chip, runtime))
+				return fail("SC1628DStatic product with SC1628DRuntimeLayout");
+		}
+		if (fixed != dynamic || runtime != dynamic)
+			return fail("SC1628DStatic product bytes (%s)", inverted ? "inverted" : "normal");
+	}
+	return true;
+}
+
+// The SPI transport must send the same frames as the pin transport, DIO on MOSI and MISO
+bool checkSPI()
+{
+	uint16_t pins[7], spi[7];
+	{
+		SimReset reset;
+		SimChip chip(PIN_STB, SCK, MOSI);
+		SC1628D display(PIN_STB, SCK, MOSI);
+		display.setTiming(SC1628D_TIMING_DATASHEET);
+		if (!runFrames(display, chip, pins))
+			return fail("SC1628D pins frames and key scans");
+	}
+	{
+		SimReset reset;
+		SimChip chip(PIN_STB, SCK, MOSI);
+		SC1628DSPITransport bus(PIN_STB);
+		bus.begin();
+		SC1628DDriver display(bus);
+		display.setTiming(SC1628D_TIMING_DATASHEET);
+		if (!runFrames(display, chip, spi))
+			return fail("SC1628DSPITransport frames and key scans");
+	}
+	if (memcmp(pins, spi, sizeof(spi)))
+		return fail("SC1628DSPITransport display RAM");
+	return true;
+}
+
+#if defined(__linux__)
+// The Linux GPIO transport must send the same frames as the pin transport
+bool checkLinuxGPIO()
+{
+	uint16_t pins[7], lines[7];
+	{
+		SimBoard board;
+		board.display.setTiming(SC1628D_TIMING_DATASHEET);
+		if (!runFrames(board.display, board.chip, pins))
+			return fail("SC1628D pins frames and key scans");
+	}
+	{
+		SimReset reset;
+		SimChip chip(PIN_STB, PIN_CLK, PIN_DIO);
+		SimGPIOLines bus(PIN_STB, PIN_CLK, PIN_DIO);
+		if (!bus.begin())
+			return fail("SC1628DLinuxGPIOTransport begin");
+		SC1628DDriver display(bus);
+		if (!runFrames(display, chip, lines))
+			return fail("SC1628DLinuxGPIOTransport frames and key scans");
+	}
+	if (memcmp(pins, lines, sizeof(lines)))
+		return fail("SC1628DLinuxGPIOTransport display RAM");
+	return true;
+}
+#endif
+
+// A compiled frame must show the same as the display functions, on every transport
+bool checkWaveform()
+{
+	static const char *const names[] = { "displaySegments", "compile and send", "cached waveforms" };
+
+	for (int mode = 0; mode < 3; mode++) {
+		SimBoard board;
+		board.display.setTiming(SC1628D_TIMING_DATASHEET);
+		if (!runWaveform(board.display, board.chip, mode))
+			return fail("%s", names[mode]);
+	}
+	{
+		SimReset reset;
+		SimChip chip(PIN_STB, PIN_CLK, PIN_DIO);
+		SC1628DStatic<PIN_STB, PIN_CLK, PIN_DIO> display;
+		if (!runWaveform(display, chip, 2))
+			return fail("SC1628DStatic cached waveforms");
+	}
+#if defined(__linux__)
+	{
+		SimReset reset;
+		SimChip chip(PIN_STB, PIN_CLK, PIN_DIO);
+		SimGPIOLines bus(PIN_STB, PIN_CLK, PIN_DIO);
+		bus.begin();
+		SC1628DDriver display(bus);
+		if (!runWaveform(display, chip, 2))
+			return fail("linux gpio cached waveforms");
+	}
+#endif
+
+	// The default replay sends the bytes of the waveform
+	SC1628DMockTransport mock;
+	SC1628DDriver display(mock);
+	SC1628DWaveform wave;
+	uint8_t segments[5];
+	SimWaveformSegments(3, segments);
+	display.setBrightness(5);
+	display.compileSegments(wave, segments);
+	display.sendWaveform(wave);
+	bool ok = wave.length() == SC1628D_WAVEFORM_STEPS && mock.transactions == 4 && mock.control == wave.control();
+	for (uint8_t k = 0; k < 7; k++)
+		ok = ok && mock.grid(k) == wave.matrix()[k];
+	unsigned long sent = mock.transactions;
+	display.displaySegments(segments);
+	if (!ok || mock.transactions != sent)
+		return fail("sendWaveform on SC1628DMockTransport");
+	return true;
+}
+
+// Groups of 1, 4 and 8 modules, sharing STB or with one STB each
+bool checkGroup()
+{
+	const uint8_t sizes[] = { 1, 4, 8 };
+
+	for (size_t n = 0; n < sizeof(sizes); n++)
+		for (size_t d = 0; d < SIM_BIT_DELAY_COUNT; d++)
+			for (int shared = 1; shared >= 0; shared--)
+				if (!runGroup(sizes[n], SIM_BIT_DELAYS[d], shared))
+					return fail("group of %u modules (bit delay %u, %s STB)", sizes[n], SIM_BIT_DELAYS[d], shared ? "shared" : "one");
+
+	// Writes running past the rightmost position of a module are cut there
+	SimReset reset;
+	uint8_t pinDIO[2] = { PIN_GROUP_DIO, PIN_GROUP_DIO + 1 };
+	SimChip first(PIN_STB, PIN_CLK, pinDIO[0]), second(PIN_STB, PIN_CLK, pinDIO[1]);
+	SC1628DGroup group(PIN_STB, PIN_CLK, pinDIO, 2, 0);
+	const uint8_t digits[5] = { 1, 2, 3, 4, 5 };
+	uint8_t expected[2][5];
+	for (uint8_t m = 0; m < 2; m++) {
+		SimGroupSegments(m, 0, expected[m]);
+		group.displaySegments(m, expected[m]);
+	}
+	group.displayDigits(0, digits, 2);
+	group.displaySegments(0, digits, 4);
+	group.displayDigits(1, digits, 5);
+	group.displaySegments(1, digits, 9, 3);
+	group.refresh();
+	expected[0][2] = SC1628D_NORMAL_FONT[1];
+	expected[0][3] = SC1628D_NORMAL_FONT[2];
+	expected[0][4] = digits[0];
+	if (!SimShows(first, expected[0]) || !SimShows(second, expected[1]))
+		return fail("group writes past the rightmost position");
+	return first.errors() == 0 && second.errors() == 0;
+}
@@ -0,0 +1,451 @@
+/*
+ *  check_display.cpp
+ *
+ *  Checks of the display functions: the frames and key scans they send,
+ *  the number and text formatting, batches, refresh limit and pages.
+ *
+ *  (c) 2022/07/13 philippe.corbes@gmail.com
+ *
+ *  This library is free software; you can redistribute it and/or
+ *  modify it under the terms of the GNU Lesser General Public
+ *  License as published by the Free Software Foundation; either
+ *  version 2.1 of the License, or (at your option) any later version.
+ *
+ *  This library is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ *  Lesser General Public License for more details.
+ *
+ *  You should have received a copy of the GNU Lesser General Public
+ *  License along with this library; if not, write to the Free Software
+ *  Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  USA
+ */
+
+#include "check.h"
+
+#include <SC1628DPages.h>
+#include <SimWorkload.h>
+#include <string.h>
+
+namespace {
+
+// Check the digits shown for a number against printf()
+bool numberShown(const SimBoard &board, bool hex, long value, uint8_t decimals, bool zeroPad)
+{
+	char text[16];
+	uint8_t segments[5];
+	int precision = zeroPad ? (value < 0 ? 3 : 4) : decimals + 1;
+
+	if (!hex && (value > 9999 || value < -999 || (value < 0 && decimals == 3)))
+		strcpy(text, "----");
+	else
+		snprintf(text, sizeof(text), hex ? "%4.*lX" : "%4.*ld", precision, value);
+	for (uint8_t i = 0; i < 4; i++)
+		segments[i] = SC1628D_NORMAL_FONT[text[i] == ' ' ? DIGIT_BLANK : text[i] == '-' ? DIGIT_MINUS :
+			text[i] <= '9' ? text[i] - '0' : text[i] - 'A' + 10];
+	segments[4] = decimals == 2 ? SC1628D_SYM_COLON : 0;
+	if (!board.shows(segments))
+		return fail("number %ld shown instead of \"%s\"", value, text);
+	return true;
+}
+
+// Show one of the three screens of the pages check, by drawing it again
+void drawScreen(SC1628DDriver &display, unsigned long screen)
+{
+	if (screen == 0)
+		display.displayNumber(215);
+	else if (screen == 1)
+		display.displayFixed(2150, 2);
+	else
+		display.displayText("On");
+}
+
+struct RefreshLimit {
+	const char *name;
+	uint16_t interval;
+	uint8_t budget;
+};
+
+const RefreshLimit refreshLimits[] = {
+	{ "none",       0, 100 },
+	{ "20 ms",     20, 100 },
+	{ "10 % bus",   0,  10 },
+	{ "5 ms, 5 %",  5,   5 },
+};
+
+} // namespace
+
+
+// The key bytes read by the simulated chip must be decoded by getButtons()
+bool checkButtons()
+{
+	SimBoard board;
+	board.chip.setKeys(SIM_KEYS);
+	uint32_t buttons = board.display.getButtons();
+	if (buttons != SIM_BUTTONS)
+		return fail("getButtons returned 0x%08lx instead of 0x%08lx", (unsigned long)buttons, (unsigned long)SIM_BUTTONS);
+	return board.clean() || fail("protocol error");
+}
+
+// Fonts and layouts in RAM must show the same as the built-in ones, read from flash memory
+bool checkTables()
+{
+	const uint8_t digits[5] = { 1, 2, 3, 4, DIGIT_BLANK };
+	uint8_t font[DIGIT_QUESTION + 1];
+	SC1628DLayout layout;
+	uint16_t flash[7] = { 0 };
+
+	memcpy_P(font, SC1628D_INVERTED_FONT, sizeof(font));
+	memcpy_P(&layout, &SC1628D_INVERTED_LAYOUT, sizeof(layout));
+	for (int ram = 0; ram < 2; ram++) {
+		SimBoard board(0);
+		if (ram) {
+			board.display.setFont(font);
+			board.display.setLayout(layout);
+		}
+		else {
+			board.display.setFont(SC1628D_INVERTED_FONT);
+			board.display.setFilter(&SC1628D_InvertedDisplay);
+		}
+		board.display.displayDigits(digits);
+		if (!ram)
+			for (uint8_t k = 0; k < 7; k++)
+				flash[k] = board.chip.grid(k);
+		else if (!board.shows(flash))
+			return fail("font and layout in RAM");
+	}
+	return true;
+}
+
+// Writes running past the rightmost position are cut there, writes starting
+// past it do nothing
+bool checkBounds()
+{
+	SimBoard board;
+	SC1628D &display = board.display;
+	const uint8_t digits[5] = { 1, 2, 3, 4, 5 };
+	const uint8_t segments[5] = { SEG_A, SEG_B, SEG_C, SEG_D, SEG_E };
+	uint8_t expected[5];
+
+	display.displayDigit(8, 0);
+	display.displayDigits(digits, 1);
+	expected[0] = SC1628D_NORMAL_FONT[8];
+	for (uint8_t i = 1; i < 5; i++)
+		expected[i] = SC1628D_NORMAL_FONT[digits[i - 1]];
+	if (!board.shows(expected))
+		return fail("displayDigits from position 1");
+
+	display.displaySegments(segments, 3);
+	expected[3] = segments[0];
+	expected[4] = segments[1];
+	if (!board.shows(expected))
+		return fail("displaySegments from position 3");
+
+	size_t sent = board.sent();
+	display.displayDigits(digits, 5);
+	display.displaySegments(segments, 7, 2);
+	display.displayDigit(1, 5);
+	display.displaySegment(SEG_G, 200);
+	if (board.sent() != sent || !board.shows(expected))
+		return fail("writes past the rightmost position");
+	return board.clean() || fail("protocol error");
+}
+
+// After each kind of call, on each layout and bit delay, the display RAM must
+// hold the last frame with the mode and the brightness set
+bool checkCalls()
+{
+	const unsigned long iterations = 50;
+
+	for (size_t l = 0; l < SIM_LAYOUT_COUNT; l++) {
+		for (size_t d = 0; d < SIM_BIT_DELAY_COUNT; d++) {
+			for (int c = 0; c < SIM_CALLS; c++) {
+				SimBoard board(SIM_BIT_DELAYS[d]);
+				SC1628D &display = board.display;
+				display.setFilter(SIM_LAYOUTS[l].filter);
+				display.setBrightness(2);
+				display.clear();
+				for (unsigned long i = 0; i < iterations; i++) {
+					SimPrepare(display, (SimCall)c, i);
+					SimRun(display, (SimCall)c, i);
+				}
+
+				uint8_t segments[5] = { SEG_A, SEG_B | SEG_C, SEG_D, SEG_E | SEG_F, SEG_G };
+				uint16_t expected[7];
+				display.displaySegments(segments);
+				display.displayDigit(8, 2);
+				segments[2] = SC1628D_NORMAL_FONT[8];
+				SIM_LAYOUTS[l].filter(segments, expected);
+				// Bit delay 0 measures the CPU cost only, the bus timings cannot be met
+				bool ok = board.chip.errors() == 0 && (SIM_BIT_DELAYS[d] == 0 || board.chip.timingErrors() == 0)
+					&& board.chip.mode == SC1628D_7GRID_11SEG && board.chip.control == (SC1628D_DISPLAY_CONTROL_CMD | 0x0a)
+					&& board.shows(expected);
+				if (!ok)
+					return fail("display RAM mismatch (%s, bit delay %u, %s)", SIM_LAYOUTS[l].name, SIM_BIT_DELAYS[d], SIM_CALL_NAMES[c]);
+			}
+		}
+	}
+	return true;
+}
+
+// displayNumber, displayFixed and displayHex against printf(), and the memoization
+bool checkNumbers()
+{
+	SimBoard board(0);
+	SC1628D &display = board.display;
+
+	for (long v = -1100; v <= 10100; v++) {
+		// displayNumber() keeps the colon of the last displayFixed()
+		display.displaySegment(0, SC1628D_SYM_POS);
+		display.displayNumber(v);
+		if (!numberShown(board, false, v, 0, false))
+			return false;
+		display.displayNumber(v, true);
+		if (!numberShown(board, false, v, 0, true))
+			return false;
+		if (v % 7 == 0) {
+			uint8_t decimals = (v / 7) & 3;
+			display.displayFixed(v, decimals);
+			if (!numberShown(board, false, v, decimals, false))
+				return false;
+			display.displayFixed(v, decimals, true);
+			if (!numberShown(board, false, v, decimals, true))
+				return false;
+		}
+	}
+	display.displaySegment(0, SC1628D_SYM_POS);
+	for (long v = 0; v <= 0xffff; v += 13) {
+		display.displayHex(v);
+		if (!numberShown(board, true, v, 0, false))
+			return false;
+		display.displayHex(v, true);
+		if (!numberShown(board, true, v, 0, true))
+			return false;
+	}
+
+	// An unchanged value is not sent again
+	display.displayFixed(1234, 2);
+	size_t sent = board.sent();
+	display.displayFixed(1234, 2);
+	if (board.sent() != sent)
+		return fail("unchanged number sent again");
+	return board.chip.errors() == 0 || fail("protocol error");
+}
+
+// Text on the digits: the ASCII font against the digits font, '.' and ':' on
+// the colon, the inverted fonts turned by 180 degrees
+bool checkText()
+{
+	const char hex[] = "0123456789AbcdEF";
+
+	for (uint8_t i = 0; i < DIGIT_QUESTION + 1; i++)
+		if (SC1628D_INVERTED_FONT[i] != SC1628D_ROT180(SC1628D_NORMAL_FONT[i]))
+			return fail("inverted digit %u", i);
+	for (uint8_t c = ' '; c <= '~'; c++)
+		if (SC1628D_INVERTED_ASCII_FONT[c - ' '] != SC1628D_ROT180(SC1628D_ASCII_FONT[c - ' ']))
+			return fail("inverted character '%c'", c);
+	for (uint8_t i = 0; i < 16; i++)
+		if (SC1628D_ASCII_FONT[hex[i] - ' '] != SC1628D_NORMAL_FONT[i])
+			return fail("character '%c' differs from the digit", hex[i]);
+
+	for (int inverted = 0; inverted < 2; inverted++) {
+		SimBoard board(0);
+		SC1628D &display = board.display;
+		const SC1628DLayout &layout = inverted ? SC1628D_INVERTED_LAYOUT : SC1628D_NORMAL_LAYOUT;
+		uint16_t expected[7];
+		if (inverted) {
+			display.setFont(SC1628D_INVERTED_FONT);
+			display.setFilter(&SC1628D_InvertedDisplay);
+		}
+
+		// The same as the fixed point number, with the colon
+		display.displayFixed(1230, 2);
+		for (uint8_t k = 0; k < 7; k++)
+			expected[k] = board.chip.grid(k);
+		const uint8_t blank[5] = { 0, 0, 0, 0, 0 };
+		display.displaySegments(blank);
+		display.displayText("12:30");
+		if (!board.shows(expected))
+			return fail("\"12:30\" differs from displayFixed(1230, 2)");
+
+		// The same text again: nothing sent
+		size_t sent = board.sent();
+		display.displayText_P(PSTR("1.2:30"));
+		if (board.sent() != sent)
+			return fail("unchanged text sent again");
+
+		// Letters, the remaining digits blanked, the other symbols kept
+		display.displaySegment(SEG_A | SC1628D_SYM_COLON, SC1628D_SYM_POS);
+		display.displayText("Err");
+		uint8_t segments[5] = {
+			SEG_A | SEG_D | SEG_E | SEG_F | SEG_G, SEG_E | SEG_G, SEG_E | SEG_G, 0, SEG_A
+		};
+		if (inverted)
+			for (uint8_t pos = 0; pos < 4; pos++)
+				segments[pos] = SC1628D_ROT180(segments[pos]);
+		if (!board.shows(segments, layout) || board.chip.errors() != 0)
+			return fail("\"Err\" on the %s layout", inverted ? "inverted" : "normal");
+	}
+	return true;
+}
+
+// A batch is sent as one frame followed by the key scan, without the commands the chip already has
+bool checkBatch()
+{
+	SimBoard board;
+	SC1628D &display = board.display;
+	const uint8_t keys[SIM_CHIP_KEY_BYTES] = { 0x02, 0x00, 0x00, 0x00, 0x00 };
+	const uint8_t digits[5] = { 1, 2, 3, 4, DIGIT_BLANK };
+
+	display.setBrightness(3);
+	display.clear();
+	size_t sent = board.sent();
+	board.chip.setKeys(keys);
+
+	display.begin();
+	display.displayDigits(digits);
+	display.displayDigit(7, 3);
+	display.setBrightness(5);
+	display.requestButtons();
+	uint32_t buttons = display.commit();
+
+	// Burst (Command 2 already sent by clear()), brightness, key scan
+	if (board.sent() - sent != 3 || buttons != (1UL << 16) || board.chip.control != (SC1628D_DISPLAY_CONTROL_CMD | 0x0d))
+		return fail("batch sent in %u transactions", (unsigned)(board.sent() - sent));
+
+	// After the key scan, the next delta needs Command 2 again
+	sent = board.sent();
+	display.displayDigit(8, 0);
+	if (board.sent() == sent || board.chip.transactions[sent].bytes[0] != (SC1628D_DATA_SETTING_CMD_WRITE | SC1628D_2_FIXED_ADDR))
+		return fail("no Command 2 after the key scan");
+
+	// Nothing changed, nothing sent
+	sent = board.sent();
+	display.displayDigit(8, 0);
+	if (board.sent() != sent)
+		return fail("unchanged digit sent again");
+
+	uint8_t segments[5] = {
+		SC1628D_NORMAL_FONT[8], SC1628D_NORMAL_FONT[2], SC1628D_NORMAL_FONT[3], SC1628D_NORMAL_FONT[7], 0
+	};
+	if (!board.shows(segments))
+		return fail("display RAM after the batch");
+
+	// A key scan between two transactions of an asynchronous frame
+	display.setAsync(true);
+	display.displayDigits(digits);
+	display.tick(3);
+	display.getButtons();
+	display.flush();
+	segments[0] = SC1628D_NORMAL_FONT[1];
+	segments[3] = SC1628D_NORMAL_FONT[4];
+	if (!board.shows(segments))
+		return fail("display RAM after a key scan within an asynchronous frame");
+	return board.chip.errors() == 0 || fail("protocol error");
+}
+
+// Refresh limit: five digit updates make one frame, the frame rate and the
+// bus time share of a number updated every 200 us stay in the limit, flush()
+// and commit() send at once
+bool checkRefreshLimit()
+{
+	const unsigned long calls = 5000;
+
+	for (size_t l = 0; l < sizeof(refreshLimits) / sizeof(refreshLimits[0]); l++) {
+		const RefreshLimit &limit = refreshLimits[l];
+		SimBoard board(1);
+		SC1628D &display = board.display;
+		display.setRefreshLimit(limit.interval, limit.budget);
+
+		// Back to back updates: nothing sent before tick(), then a single frame
+		size_t sent = board.sent();
+		for (uint8_t pos = 0; pos < 4; pos++)
+			display.displayDigit(pos + 1, pos);
+		display.displaySegment(SEG_A, 4);
+		if (limit.interval || limit.budget < 100) {
+			if (board.sent() != sent)
+				return fail("%s: sent before tick()", limit.name);
+			SimArduino::advance(limit.interval * 1000000ULL);
+			display.tick();
+			if (board.chip.transactions[sent].bytes[0] != SC1628D_DATA_SETTING_CMD_WRITE
+				|| board.chip.transactions[sent + 1].bytes.size() != 15)
+				return fail("%s: the updates are not sent as one burst", limit.name);
+		}
+
+		unsigned long frames = 0;
+		uint64_t busNs = 0, t0 = SimArduino::now();
+		for (unsigned long i = 0; i < calls; i++) {
+			SimArduino::advance(200000);
+			sent = board.sent();
+			uint64_t t = SimArduino::now();
+			display.displayNumber(i);
+			display.tick();
+			busNs += SimArduino::now() - t;
+			frames += board.sent() != sent;
+		}
+		double share = 100.0 * busNs / (SimArduino::now() - t0);
+		double seconds = (SimArduino::now() - t0) / 1e9;
+		if (limit.interval && frames > seconds * 1000 / limit.interval + 1)
+			return fail("%s: %lu frames in %.1f s", limit.name, frames, seconds);
+		if (limit.budget < 100 && share > limit.budget + 1)
+			return fail("%s: %.1f %% of the time on the bus", limit.name, share);
+
+		// flush() sends the last state without waiting
+		display.displayDigit(DIGIT_MINUS, 0);
+		display.flush();
+		uint8_t segments[5] = {
+			SC1628D_NORMAL_FONT[DIGIT_MINUS], SC1628D_NORMAL_FONT[(calls - 1) / 100 % 10],
+			SC1628D_NORMAL_FONT[(calls - 1) / 10 % 10], SC1628D_NORMAL_FONT[(calls - 1) % 10], SEG_A
+		};
+		if (!board.shows(segments) || board.chip.errors() != 0)
+			return fail("%s: display RAM after flush()", limit.name);
+
+		// commit() sends the batch without waiting either
+		display.begin();
+		display.displayDigit(7, 0);
+		display.commit();
+		segments[0] = SC1628D_NORMAL_FONT[7];
+		if (!board.shows(segments) || board.chip.errors() != 0)
+			return fail("%s: display RAM after commit()", limit.name);
+	}
+	return true;
+}
+
+// Hidden pages must be updated without bus transactions, and shown as the
+// display functions would show them
+bool checkPages()
+{
+	SimBoard board;
+	SC1628D &display = board.display;
+	display.setTiming(SC1628D_TIMING_DATASHEET);
+	SC1628DPages pages(display, 3);
+
+	pages.displayNumber(0, 215);
+	size_t sent = board.sent();
+	pages.displayFixed(1, 2150, 2);
+	pages.displayText(2, "On");
+	if (board.sent() != sent || !board.shows(pages.segments(0)))
+		return fail("hidden pages sent");
+
+	for (uint8_t page = 1; page < 3; page++) {
+		pages.show(page);
+		if (pages.visible() != page || !board.shows(pages.segments(page)))
+			return fail("page %u shown", page);
+
+		// The display functions find the page already on the chip
+		sent = board.sent();
+		drawScreen(display, page);
+		if (board.sent() != sent)
+			return fail("page %u drawn again", page);
+	}
+
+	// Hidden pages rendered again with a new layout
+	display.setLayout(SC1628D_INVERTED_LAYOUT);
+	pages.show(0);
+	if (!board.shows(pages.segments(0), SC1628D_INVERTED_LAYOUT))
+		return fail("page 0 with the inverted layout");
+	pages.show(1);
+	if (!board.shows(pages.segments(1), SC1628D_INVERTED_LAYOUT))
+		return fail("page 1 with the inverted layout");
+	return board.clean() || fail("protocol or timing error");
+}
@@ -0,0 +1,613 @@
+/*
+ *  check_tick.cpp
+ *
+ *  Checks of the modes driven by tick(): marquee, animations, mailbox,
+ *  per position intensity and blinking.
+ *
+ *  (c) 2022/07/13 philippe.corbes@gmail.com
+ *
+ *  This library is free software; you can redistribute it and/or
+ *  modify it under the terms of the GNU Lesser General Public
+ *  License as published by the Free Software Foundation; either
+ *  version 2.1 of the License, or (at your option) any later version.
+ *
+ *  This library is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ *  Lesser General Public License for more details.
+ *
+ *  You should have received a copy of the GNU Lesser General Public
+ *  License along with this library; if not, write to the Free Software
+ *  Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  USA
+ */
+
+#include "check.h"
+
+#include <atomic>
+#include <thread>
+#include <vector>
+#include <string.h>
+
+namespace {
+
+// A mailbox frame numbered n: the number on 4 bytes and a check byte, to detect mixed frames
+void mailboxFrame(uint32_t n, uint8_t segments[])
+{
+	for (uint8_t i = 0; i < 4; i++)
+		segments[i] = n >> (8 * i);
+	segments[4] = segments[0] ^ segments[1] ^ segments[2] ^ segments[3] ^ 0x5a;
+}
+
+// The same segments on the 4 digit positions
+void digitsFrame(uint8_t d, uint8_t segments[])
+{
+	memset(segments, SC1628D_NORMAL_FONT[d], 4);
+	segments[4] = 0;
+}
+
+const SC1628DFrame animFrames[] PROGMEM = {
+	{ 30, { 0, 0, 0, 0, SEG_A } },
+	{ 50, { 0, 0, 0, 0, SEG_B } },
+	{ 20, { 0, 0, 0, 0, SEG_C } },
+};
+
+const SC1628DMatrixFrame animMatrixFrames[] PROGMEM = {
+	{ 40, { 0x0001, 0x0002, 0x0004, 0x0008, 0x0010, 0x0020, 0x0040 } },
+	{ 40, { 0x0fff, 0, 0x0fff, 0, 0x0fff, 0, 0x0fff } },
+};
+
+// The segments frame shown on the position 4 over the digits 1234, -1 if none
+int animFrameShown(const SimBoard &board)
+{
+	for (int f = 0; f < 3; f++) {
+		uint8_t segments[5] = { SC1628D_NORMAL_FONT[1], SC1628D_NORMAL_FONT[2], SC1628D_NORMAL_FONT[3], SC1628D_NORMAL_FONT[4], 0 };
+		segments[4] = pgm_read_byte(&animFrames[f].segments[4]);
+		if (board.shows(segments))
+			return f;
+	}
+	return -1;
+}
+
+// A key event, with its time
+struct KeyEventAt {
+	unsigned long ms;
+	uint8_t type;
+	uint8_t key;
+};
+
+// An expected key event, with the range of its delay after the previous event
+struct KeyEventIn {
+	unsigned long min;
+	unsigned long max;
+	uint8_t type;
+	uint8_t key;
+};
+
+// tick() every millisecond, the key events polled after each one when a log is given
+void tickKeys(SimBoard &board, unsigned long ms, std::vector<KeyEventAt> *log)
+{
+	for (unsigned long i = 0; i < ms; i++) {
+		SimArduino::advance(1000000ULL);
+		board.display.tick();
+		SC1628DKeyEvent event;
+		while (log && board.display.pollKeyEvent(event)) {
+			KeyEventAt at = { millis(), event.type, event.key };
+			log->push_back(at);
+		}
+	}
+}
+
+// The events logged from the index first are the expected ones, the first
+// one timed from since. The bus time of the key scans moves the virtual
+// clock too: a tick every millisecond is not exactly a millisecond apart.
+bool keyEvents(const std::vector<KeyEventAt> &log, size_t first, unsigned long since, const KeyEventIn expected[], size_t count)
+{
+	if (log.size() - first != count)
+		return fail("%u key events instead of %u", (unsigned)(log.size() - first), (unsigned)count);
+	for (size_t e = 0; e < count; e++) {
+		const KeyEventAt &got = log[first + e];
+		unsigned long delay = got.ms - (e ? log[first + e - 1].ms : since);
+		if (got.type != expected[e].type || got.key != expected[e].key || delay < expected[e].min || delay > expected[e].max)
+			return fail("key event %u: type %u key %u after %lu ms instead of type %u key %u after %lu to %lu ms", (unsigned)e,
+				got.type, got.key, delay, expected[e].type, expected[e].key, expected[e].min, expected[e].max);
+	}
+	return true;
+}
+
+// A timer interrupt calling tick() on each CLK falling edge of a key read, a
+// dimming sub-frame later
+class KeyReadInterrupt : public SimDevice {
+
+public:
+	KeyReadInterrupt(SC1628DDriver &display) : calls(0), m_display(display), m_inside(false) {}
+
+	virtual void pinChanged(uint8_t pin, uint8_t level)
+	{
+		if (pin != PIN_CLK || level || m_inside || SimArduino::mode(PIN_DIO) == OUTPUT)
+			return;
+		m_inside = true;
+		SimArduino::advance(SC1628D_DIM_PERIOD_US * 1000ULL);
+		m_display.tick();
+		calls++;
+		m_inside = false;
+	}
+
+	unsigned long calls;
+
+private:
+	SC1628DDriver &m_display;
+	bool m_inside;
+};
+
+} // namespace
+
+
+// Marquee steps from tick(): the window of the string at each step, and the end of a single pass
+bool checkMarquee()
+{
+	SimBoard board(0);
+	SC1628D &display = board.display;
+	SC1628DMarquee marquee;
+	const uint8_t text[] = { 0, 1, 2, 3, 4, 5, 6, 7, 8, 9, 10, 11, 12, 13, 14, 15 };
+	const int length = sizeof(text), width = 4, steps = 2 * (length + width);
+
+	// Nothing without its state
+	size_t sent = board.sent();
+	if (display.displayMarqueeDigits(text, length, 100, width) || display.isScrolling() || board.sent() != sent)
+		return fail("marquee started without a SC1628DMarquee");
+
+	display.attachMarquee(&marquee);
+	if (!display.displayMarqueeDigits(text, length, 100, width))
+		return fail("marquee refused with a SC1628DMarquee");
+	for (int step = 0; step < steps; step++) {
+		SimArduino::advance(100000000ULL);
+		display.tick();
+
+		// Position j shows the string position entered (width - 1 - j) steps ago
+		uint8_t segments[5] = { 0, 0, 0, 0, 0 };
+		for (int j = 0; j < width; j++) {
+			int i = (step - (width - 1 - j)) % (length + width);
+			if (step >= width - 1 - j && i < length)
+				segments[j] = SC1628D_NORMAL_FONT[text[i]];
+		}
+		if (!board.shows(segments))
+			return fail("marquee step %d", step);
+	}
+	if (!display.isScrolling())
+		return fail("repeated marquee stopped");
+
+	// Not repeated: stops once the string has left the display
+	display.displayMarquee(text, 2, 10, 5, false);
+	for (int step = 0; step < 2 + 5; step++) {
+		SimArduino::advance(10000000ULL);
+		display.tick();
+	}
+	if (display.isScrolling())
+		return fail("single marquee still scrolling");
+	return board.chip.errors() == 0 || fail("protocol error");
+}
+
+// Animations from tick(): frames shown at their deadlines, ping-pong order, matrix frames
+bool checkAnimation()
+{
+	SimBoard board(0);
+	SC1628D &display = board.display;
+	SC1628DAnimation animation;
+	if (display.playAnimation(animFrames, 3) || display.playAnimation(animMatrixFrames, 2) || display.isAnimating())
+		return fail("animation started without a SC1628DAnimation");
+	display.attachAnimation(&animation);
+	const int order[] = { 0, 1, 2, 1, 0, 1, 2, 1 };
+	const uint8_t digits[5] = { 1, 2, 3, 4, DIGIT_BLANK };
+
+	// Ticks every 1 ms, then every 7 ms: each frame starts within a tick of its deadline
+	for (unsigned long period = 1; period <= 7; period += 6) {
+		display.displayDigits(digits);
+		display.playAnimation(animFrames, 3, SC1628D_ANIM_PINGPONG, 4, 1);
+		unsigned long deadline = millis();
+		for (uint8_t f = 0; f < sizeof(order) / sizeof(order[0]); f++) {
+			while (animFrameShown(board) != order[f] && millis() < deadline + period) {
+				SimArduino::advance(period * 1000000ULL);
+				display.tick();
+			}
+			if (animFrameShown(board) != order[f] || millis() < deadline || millis() - deadline >= period)
+				return fail("frame %u at %lu ms instead of %lu ms (tick every %lu ms)", f, millis(), deadline, period);
+			deadline += pgm_read_word(&animFrames[order[f]].duration);
+		}
+	}
+
+	// Matrix frames, played once, are sent without filter
+	display.playAnimation(animMatrixFrames, 2, SC1628D_ANIM_ONCE);
+	for (int i = 0; i < 20; i++) {
+		SimArduino::advance(5000000ULL);
+		display.tick();
+	}
+	if (display.isAnimating())
+		return fail("animation played once still running");
+	uint16_t matrix[7];
+	memcpy_P(matrix, animMatrixFrames[1].matrix, sizeof(matrix));
+	if (!board.shows(matrix))
+		return fail("last matrix frame");
+
+	// A digit update shows the segments again
+	display.displayDigits(digits);
+	uint8_t segments[5] = { SC1628D_NORMAL_FONT[1], SC1628D_NORMAL_FONT[2], SC1628D_NORMAL_FONT[3], SC1628D_NORMAL_FONT[4], 0 };
+	if (!board.shows(segments))
+		return fail("digits after the animation");
+
+	// Frames running past the rightmost position are cut there, none start past it
+	if (!display.playAnimation(animFrames, 3, SC1628D_ANIM_LOOP, 4))
+		return fail("animation from the position 4 refused");
+	for (int i = 0; i < 20; i++) {
+		SimArduino::advance(5000000ULL);
+		display.tick();
+		if (animFrameShown(board) < 0)
+			return fail("animation from the position 4");
+	}
+	display.stopAnimation();
+	if (display.playAnimation(animFrames, 3, SC1628D_ANIM_LOOP, 5) || display.isAnimating())
+		return fail("animation from the position 5");
+	return board.chip.errors() == 0 || fail("protocol error");
+}
+
+// A thread publishing frames while another one takes them: never a mixed
+// frame, always newer ones, the last one received. Then a thread publishing
+// digits to a display refreshed by tick().
+bool checkMailbox()
+{
+	const uint32_t frames = 100000;
+	SC1628DMailbox mailbox;
+	std::atomic<bool> go(false);
+	bool ok = true;
+
+	std::thread producer([&mailbox, &go, frames]() {
+		while (!go)
+			;
+		for (uint32_t n = 1; n <= frames; n++) {
+			if (n & 1) {
+				mailboxFrame(n, mailbox.frame());
+				mailbox.publish();
+			}
+			else {
+				uint8_t segments[5];
+				mailboxFrame(n, segments);
+				mailbox.publish(segments);
+			}
+			// Let the consumer run on a single core host
+			if ((n & 15) == 0)
+				std::this_thread::yield();
+		}
+	});
+	uint32_t last = 0;
+	go = true;
+	while (last != frames) {
+		uint8_t segments[5], check[5];
+		if (!mailbox.take(segments)) {
+			std::this_thread::yield();
+			continue;
+		}
+		uint32_t n = segments[0] | (segments[1] << 8) | (segments[2] << 16) | ((uint32_t)segments[3] << 24);
+		mailboxFrame(n, check);
+		if (check[4] != segments[4] || n <= last)
+			ok = false;
+		last = n;
+	}
+	producer.join();
+	if (!ok || mailbox.available())
+		return fail("mixed, older or extra frames taken");
+
+	// The display shows the same digit on its 4 positions, at every refresh
+	SimBoard board(0);
+	board.display.attachMailbox(&mailbox);
+	std::atomic<bool> done(false);
+	go = false;
+	std::thread digits([&mailbox, &go, &done, frames]() {
+		while (!go)
+			;
+		for (uint32_t n = 0; n < frames / 10; n++) {
+			digitsFrame(n % 10, mailbox.frame());
+			mailbox.publish();
+			std::this_thread::yield();
+		}
+		done = true;
+	});
+	go = true;
+	for (bool last = false; !last; ) {
+		last = done;
+		size_t sent = board.sent();
+		board.display.tick();
+		if (board.sent() == sent) {
+			std::this_thread::yield();
+			continue;
+		}
+		bool uniform = false;
+		for (uint8_t d = 0; d < 10 && !uniform; d++) {
+			uint8_t segments[5];
+			digitsFrame(d, segments);
+			uniform = board.shows(segments);
+		}
+		ok = ok && uniform;
+	}
+	digits.join();
+	if (!ok)
+		return fail("a refresh showed a mixed frame");
+
+	uint8_t segments[5];
+	digitsFrame((frames / 10 - 1) % 10, segments);
+	if (!board.shows(segments))
+		return fail("last frame published not shown");
+	return board.chip.errors() == 0 || fail("protocol error");
+}
+
+// Per position intensity: each position is shown level / SC1628D_DIM_LEVELS
+// of the time, with pin accesses fast enough for the sub-frames, also when
+// the levels are set again before each tick()
+bool checkDimming()
+{
+	const uint8_t levels[5] = { 1, 2, SC1628D_DIM_LEVELS, 0, 3 };
+	const uint8_t digits[5] = { 8, 8, 8, 8, DIGIT_BLANK };
+	const uint32_t accessTimes[] = { 500, 100 };
+	const unsigned int bitDelays[] = { 1, 0 };
+	const unsigned long cycles = 50;
+
+	// Refused without its state
+	{
+		SimBoard board;
+		if (board.display.setIntensity(0, 1) || board.display.setDimPeriod())
+			return fail("intensity set without a SC1628DDimmer");
+	}
+
+	for (int repeat = 0; repeat < 2; repeat++) {
+		for (size_t a = 0; a < sizeof(accessTimes) / sizeof(accessTimes[0]); a++) {
+			for (size_t d = 0; d < sizeof(bitDelays) / sizeof(bitDelays[0]); d++) {
+				SimBoard board(bitDelays[d], accessTimes[a]);
+				SC1628D &display = board.display;
+				SC1628DDimmer dimmer;
+				display.attachDimmer(&dimmer);
+				display.displayDigits(digits);
+				display.displaySegment(SEG_A, 4);
+				for (uint8_t pos = 0; pos < 5; pos++)
+					if (!display.setIntensity(pos, levels[pos]))
+						return fail("intensity refused with a SC1628DDimmer");
+
+				// tick() every 100 us, the RAM is sampled after each one
+				unsigned long samples = 0, lit[5] = { 0, 0, 0, 0, 0 };
+				uint64_t t0 = SimArduino::now();
+				while (SimArduino::now() - t0 < cycles * SC1628D_DIM_LEVELS * SC1628D_DIM_PERIOD_US * 1000ULL) {
+					SimArduino::advance(100000);
+					for (uint8_t pos = 0; repeat && pos < 5; pos++)
+						display.setIntensity(pos, levels[pos]);
+					display.tick();
+
+					for (uint8_t pos = 0; pos < 5; pos++) {
+						uint8_t segments[5] = { 0, 0, 0, 0, 0 };
+						uint16_t expected[7];
+						segments[pos] = pos < 4 ? SC1628D_NORMAL_FONT[8] : SEG_A;
+						SC1628D_NormalDisplay(segments, expected);
+						bool on = true;
+						for (uint8_t k = 0; k < 7; k++)
+							on = on && (board.chip.grid(k) & expected[k]) == expected[k];
+						lit[pos] += on;
+					}
+					samples++;
+				}
+
+				for (uint8_t pos = 0; pos < 5; pos++) {
+					double duty = (double)lit[pos] / samples, target = (double)levels[pos] / SC1628D_DIM_LEVELS;
+					if (duty < target - 0.05 || duty > target + 0.05)
+						return fail("position %u lit %.0f %% of the time instead of %.0f %% (access %u ns, bit delay %u%s)",
+							pos, 100 * duty, 100 * target, accessTimes[a], bitDelays[d], repeat ? ", levels set at each tick" : "");
+				}
+				if (board.chip.errors() != 0)
+					return fail("protocol error");
+			}
+		}
+	}
+	return true;
+}
+
+// tick() interrupting a key read in synchronous mode: the dimming frames
+// wait for the next tick() instead of breaking the read, which keeps the bus
+// lock until it ends
+bool checkInterrupt()
+{
+	SimBoard board;
+	SC1628D &display = board.display;
+	SC1628DDimmer dimmer;
+	const uint8_t digits[5] = { 8, 8, 8, 8, DIGIT_BLANK };
+	KeyReadInterrupt timer(display);
+
+	display.attachDimmer(&dimmer);
+	display.displayDigits(digits);
+	display.setIntensity(0, 1);
+	display.setIntensity(1, 2);
+	board.chip.setKeys(SIM_KEYS);
+
+	SimArduino::attach(&timer);
+	uint32_t buttons = display.getButtons();
+	SimArduino::detach(&timer);
+	if (timer.calls == 0)
+		return fail("no tick() during the key read");
+	if (buttons != SIM_BUTTONS || !board.clean())
+		return fail("key read broken by tick(): buttons 0x%08lx, %lu errors", (unsigned long)buttons, board.chip.errors());
+
+	// The lock is released: the next ticks send the dimming sub-frames
+	size_t sent = board.sent();
+	for (int i = 0; i < 10; i++) {
+		SimArduino::advance(SC1628D_DIM_PERIOD_US * 1000ULL);
+		display.tick();
+	}
+	if (board.sent() == sent)
+		return fail("no dimming frame after the key read");
+	return board.clean() || fail("protocol error");
+}
+
+// Blinking segments must only be hidden during the off part of the period,
+// with the RAM bytes they touch as the only writes, and keep their phase
+// when the value changes
+bool checkBlink()
+{
+	const uint8_t blink[5] = { 0, 0xff, 0, SEG_A | SEG_D, 0 };
+	unsigned long flips = 0;
+
+	SimBoard board;
+	SC1628D &display = board.display;
+	SC1628DBlinker blinker;
+	if (display.setBlink(1) || display.setBlinkRate())
+		return fail("blink set without a SC1628DBlinker");
+	display.attachBlinker(&blinker);
+	display.setTiming(SC1628D_TIMING_DATASHEET);
+	display.displayNumber(1234);
+	bool set = display.setBlinkRate(500, 50);
+	size_t frame = board.sent();
+	for (uint8_t pos = 0; pos < 5; pos++)
+		set = display.setBlink(pos, blink[pos]) && set;
+	if (!set)
+		return fail("blink refused with a SC1628DBlinker");
+	if (board.sent() != frame)
+		return fail("setBlink() sent a frame");
+
+	// tick() every millisecond for 2 s, the value changes during an off part
+	unsigned long start = millis();
+	for (unsigned long ms = 1; ms <= 2000; ms++) {
+		SimArduino::advance(1000000ULL);
+		size_t sent = board.sent();
+		if (ms == 800)
+			display.displayNumber(1235);
+		size_t updated = board.sent();
+		display.tick();
+		if (ms == 800 && board.sent() == sent)
+			return fail("new value not sent during an off part");
+
+		if (board.sent() != updated) {
+			for (size_t t = updated; t < board.sent(); t++)
+				if (board.chip.transactions[t].bytes.size() > 2)
+					return fail("phase change at %lu ms sent %u bytes at once", ms, (unsigned)board.chip.transactions[t].bytes.size());
+			flips++;
+		}
+
+		bool off = (millis() - start) % 500 >= 250;
+		uint8_t segments[5];
+		for (uint8_t pos = 0; pos < 4; pos++)
+			segments[pos] = SC1628D_NORMAL_FONT[ms < 800 ? pos + 1 : pos + 1 + (pos == 3)];
+		segments[4] = 0;
+		for (uint8_t pos = 0; pos < 5; pos++)
+			if (off)
+				segments[pos] &= ~blink[pos];
+		if (!board.shows(segments))
+			return fail("display RAM at %lu ms", ms);
+	}
+	if (flips != 8)
+		return fail("%lu phase changes in 2 s instead of 8", flips);
+
+	// Detached during an off part: the blinking segments are shown again
+	while ((millis() - start) % 500 < 250)
+		SimArduino::advance(1000000ULL);
+	display.tick();
+	display.attachBlinker(NULL);
+	uint8_t segments[5] = { SC1628D_NORMAL_FONT[1], SC1628D_NORMAL_FONT[2], SC1628D_NORMAL_FONT[3], SC1628D_NORMAL_FONT[5], 0 };
+	if (!board.shows(segments))
+		return fail("blinking segments hidden after attachBlinker(NULL)");
+	return board.clean() || fail("protocol or timing error");
+}
+
+// Scheduled key scan driven by tick(): only the key bytes of the scanned KS
+// lines read, the debounce, press and release events, the long press and
+// repeat timings, and the events lost when the queue is full
+bool checkKeys()
+{
+	const uint8_t none[SIM_CHIP_KEY_BYTES] = { 0, 0, 0, 0, 0 };
+	// K1/KS1, K2/KS3, and K1/KS5 outside of the scanned lines
+	const uint8_t pressed[SIM_CHIP_KEY_BYTES] = { 0x01, 0x02, 0x01, 0, 0 };
+	const uint8_t k1[SIM_CHIP_KEY_BYTES] = { 0x01, 0, 0, 0, 0 };
+	const unsigned long interval = 10;
+	// A change is seen by the third scan after it
+	const unsigned long debounceMin = 2 * interval, debounceMax = 3 * interval + 3;
+	std::vector<KeyEventAt> log;
+
+	SimBoard board;
+	SC1628D &display = board.display;
+	SC1628DKeypad keypad;
+
+	// Refused without its state
+	if (display.setKeyScan(interval) || display.setKeyTiming())
+		return fail("key scan started without a SC1628DKeypad");
+
+	display.attachKeypad(&keypad);
+	if (!display.setKeyTiming(3, 800, 200) || !display.setKeyScan(interval, SC1628D_KS(1) | SC1628D_KS(3)))
+		return fail("key scan refused with a SC1628DKeypad");
+	size_t sent = board.sent();
+
+	// Three scans of the same keys make a change, one event per key
+	unsigned long since = millis();
+	board.chip.setKeys(pressed);
+	tickKeys(board, 5 * interval, &log);
+	for (size_t t = sent; t < board.sent(); t++)
+		if (board.chip.transactions[t].keys.size() != 2)
+			return fail("%u key bytes read for KS1 and KS3", (unsigned)board.chip.transactions[t].keys.size());
+	if (board.sent() - sent < 4)
+		return fail("%u key scans in %lu ms", (unsigned)(board.sent() - sent), 5 * interval);
+	if (display.getKeys() != ((1UL << 0) | (1UL << 18)))
+		return fail("keys state 0x%08lx", (unsigned long)display.getKeys());
+	const KeyEventIn press[] = {
+		{ debounceMin, debounceMax, SC1628D_KEY_PRESS, 0 }, { 0, 0, SC1628D_KEY_PRESS, 18 }
+	};
+	if (!keyEvents(log, 0, since, press, 2))
+		return false;
+
+	// Released for two scans at most: no event
+	board.chip.setKeys(none);
+	tickKeys(board, 2 * interval - 3, &log);
+	board.chip.setKeys(pressed);
+	tickKeys(board, 3 * interval, &log);
+	if (log.size() != 2 || display.getKeys() != ((1UL << 0) | (1UL << 18)))
+		return fail("release shorter than the debounce seen");
+
+	// Released: one event per key
+	since = millis();
+	board.chip.setKeys(none);
+	tickKeys(board, 5 * interval, &log);
+	const KeyEventIn release[] = {
+		{ debounceMin, debounceMax, SC1628D_KEY_RELEASE, 0 }, { 0, 0, SC1628D_KEY_RELEASE, 18 }
+	};
+	if (!keyEvents(log, 2, since, release, 2))
+		return false;
+
+	// Held: long press 800 ms after the press event, then a repeat every
+	// 200 ms, each within a tick, none after the release
+	since = millis();
+	board.chip.setKeys(k1);
+	tickKeys(board, 1300, &log);
+	board.chip.setKeys(none);
+	tickKeys(board, 1000, &log);
+	const KeyEventIn held[] = {
+		{ debounceMin, debounceMax, SC1628D_KEY_PRESS, 0 },
+		{ 800, 801, SC1628D_KEY_LONG, 0 },
+		{ 200, 201, SC1628D_KEY_REPEAT, 0 },
+		{ 200, 201, SC1628D_KEY_REPEAT, 0 },
+		{ 100 - debounceMax, 100 + debounceMax, SC1628D_KEY_RELEASE, 0 },
+	};
+	if (!keyEvents(log, 4, since, held, 5))
+		return false;
+
+	// Not polled: the queue keeps the first SC1628D_KEY_QUEUE_SIZE - 1 events, in order
+	for (int i = 0; i < 10; i++) {
+		board.chip.setKeys(k1);
+		tickKeys(board, 4 * interval, NULL);
+		board.chip.setKeys(none);
+		tickKeys(board, 4 * interval, NULL);
+	}
+	SC1628DKeyEvent event;
+	int queued = 0;
+	for (; display.pollKeyEvent(event); queued++)
+		if (event.type != (queued & 1 ? SC1628D_KEY_RELEASE : SC1628D_KEY_PRESS) || event.key != 0)
+			return fail("queued event %d: type %u key %u", queued, event.type, event.key);
+	if (queued != SC1628D_KEY_QUEUE_SIZE - 1)
+		return fail("%d events queued instead of %d", queued, SC1628D_KEY_QUEUE_SIZE - 1);
+
+	// The queue is used again once read
+	board.chip.setKeys(k1);
+	tickKeys(board, 4 * interval, NULL);
+	if (!display.pollKeyEvent(event) || event.type != SC1628D_KEY_PRESS || display.pollKeyEvent(event))
+		return fail("no press event after the queue was read");
+	return board.chip.errors() == 0 || fail("protocol error");
+}
@@ -0,0 +1,106 @@
+/*
+ *  sc1628d_check.cpp
+ *
+ *  Pass/fail checks of the SC1628D library on the simulated Arduino core.
+ *  The display RAM and the commands decoded by the simulated chip are
+ *  compared with the expected frames, each feature has its own check so
+ *  that a failure points to the feature that broke.
+ *
+ *  Usage: sc1628d_check [--list] [NAME...]    (all the checks by default)
+ *
+ *  (c) 2022/07/13 philippe.corbes@gmail.com
+ *
+ *  This library is free software; you can redistribute it and/or
+ *  modify it under the terms of the GNU Lesser General Public
+ *  License as published by the Free Software Foundation; either
+ *  version 2.1 of the License, or (at your option) any later version.
+ *
+ *  This library is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ *  Lesser General Public License for more details.
+ *
+ *  You should have received a copy of the GNU Lesser General Public
+ *  License along with this library; if not, write to the Free Software
+ *  Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  USA
+ */
+
+#include "check.h"
+
+#include <string.h>
+
+namespace {
+
+struct Check {
+	const char *name;
+	bool (*run)();
+};
+
+const Check checks[] = {
+	{ "buttons",    &checkButtons },
+	{ "tables",     &checkTables },
+	{ "bounds",     &checkBounds },
+	{ "calls",      &checkCalls },
+	{ "numbers",    &checkNumbers },
+	{ "text",       &checkText },
+	{ "batch",      &checkBatch },
+	{ "limit",      &checkRefreshLimit },
+	{ "pages",      &checkPages },
+	{ "marquee",    &checkMarquee },
+	{ "animation",  &checkAnimation },
+	{ "mailbox",    &checkMailbox },
+	{ "dimming",    &checkDimming },
+	{ "interrupt",  &checkInterrupt },
+	{ "blink",      &checkBlink },
+	{ "keys",       &checkKeys },
+	{ "timing",     &checkTiming },
+	{ "calibrate",  &checkCalibrate },
+	{ "static",     &checkStatic },
+	{ "spi",        &checkSPI },
+#if defined(__linux__)
+	{ "linux_gpio", &checkLinuxGPIO },
+#endif
+	{ "waveform",   &checkWaveform },
+	{ "group",      &checkGroup },
+};
+
+const size_t checkCount = sizeof(checks) / sizeof(checks[0]);
+
+bool run(const Check &check)
+{
+	bool ok = check.run();
+	printf("%s %s\n", ok ? "PASS" : "FAIL", check.name);
+	return ok;
+}
+
+} // namespace
+
+
+int main(int argc, char *argv[])
+{
+	int failures = 0;
+
+	if (argc == 2 && !strcmp(argv[1], "--list")) {
+		for (size_t c = 0; c < checkCount; c++)
+			printf("%s\n", checks[c].name);
+		return 0;
+	}
+	if (argc == 1) {
+		for (size_t c = 0; c < checkCount; c++)
+			failures += !run(checks[c]);
+	}
+	for (int i = 1; i < argc; i++) {
+		size_t c = 0;
+		while (c < checkCount && strcmp(argv[i], checks[c].name))
+			c++;
+		if (c == checkCount) {
+			printf("Unknown check %s, see %s --list\n", argv[i], argv[0]);
+			return 2;
+		}
+		failures += !run(checks[c]);
+	}
+
+	if (failures)
+		printf("%d check(s) failed\n", failures);
+	return failures ? 1 : 0;
+}
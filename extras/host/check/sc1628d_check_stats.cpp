@@ -0,0 +1,173 @@
+/*
+ *  sc1628d_check_stats.cpp
+ *
+ *  Check of the performance counters (SC1628D_STATS) on the simulated
+ *  Arduino core: the counters must match the transactions decoded by the
+ *  simulated chip, and each outermost public call must add one latency
+ *  sample to its histogram.
+ *
+ *  Built against the library with SC1628D_STATS defined.
+ *
+ *  (c) 2022/07/13 philippe.corbes@gmail.com
+ *
+ *  This library is free software; you can redistribute it and/or
+ *  modify it under the terms of the GNU Lesser General Public
+ *  License as published by the Free Software Foundation; either
+ *  version 2.1 of the License, or (at your option) any later version.
+ *
+ *  This library is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ *  Lesser General Public License for more details.
+ *
+ *  You should have received a copy of the GNU Lesser General Public
+ *  License along with this library; if not, write to the Free Software
+ *  Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  USA
+ */
+
+#include "check.h"
+
+#ifndef SC1628D_STATS
+#error "sc1628d_check_stats needs the library built with SC1628D_STATS"
+#endif
+
+namespace {
+
+// Counters expected from the transactions decoded by the chip
+struct Counts {
+	uint32_t frames;
+	uint32_t bytes;
+	uint32_t bits;
+	uint32_t commands;
+	uint32_t keyScans;
+};
+
+// Add the transactions decoded since the index first
+void decoded(const SimChip &chip, size_t first, Counts &counts)
+{
+	for (size_t t = first; t < chip.transactions.size(); t++) {
+		const SimTransaction &txn = chip.transactions[t];
+		counts.commands++;
+		counts.bytes += txn.bytes.size() + txn.keys.size();
+		counts.bits += txn.bits;
+	}
+}
+
+// Longest transaction decoded since the index first, in bytes
+size_t longest(const SimChip &chip, size_t first)
+{
+	size_t bytes = 0;
+	for (size_t t = first; t < chip.transactions.size(); t++)
+		if (chip.transactions[t].bytes.size() > bytes)
+			bytes = chip.transactions[t].bytes.size();
+	return bytes;
+}
+
+// The counters match the expected ones
+bool counted(const SC1628DStats &stats, const Counts &counts, const char *after)
+{
+	if (stats.frames != counts.frames || stats.bytes != counts.bytes || stats.bits != counts.bits
+		|| stats.commands != counts.commands || stats.keyScans != counts.keyScans)
+		return fail("after %s: frames %lu bytes %lu bits %lu commands %lu keyScans %lu"
+			" instead of %lu %lu %lu %lu %lu", after,
+			(unsigned long)stats.frames, (unsigned long)stats.bytes, (unsigned long)stats.bits,
+			(unsigned long)stats.commands, (unsigned long)stats.keyScans,
+			(unsigned long)counts.frames, (unsigned long)counts.bytes, (unsigned long)counts.bits,
+			(unsigned long)counts.commands, (unsigned long)counts.keyScans);
+	return true;
+}
+
+// Calls recorded in the histogram of a call, or of all of them
+unsigned long samples(const SC1628DStats &stats, int call = -1)
+{
+	unsigned long count = 0;
+	for (int c = 0; c < SC1628D_CALLS; c++)
+		for (uint8_t b = 0; b < SC1628D_HISTOGRAM_BUCKETS; b++)
+			if (call < 0 || c == call)
+				count += stats.histogram[c][b];
+	return count;
+}
+
+// The histogram got one sample, in the row of the call
+bool sampled(const SC1628DStats &stats, unsigned long before, SC1628DCall call, unsigned long callBefore, const char *name)
+{
+	if (samples(stats) != before + 1 || samples(stats, call) != callBefore + 1)
+		return fail("%s: %lu histogram samples added, %lu to its row", name,
+			samples(stats) - before, samples(stats, call) - callBefore);
+	return true;
+}
+
+// A full frame, a delta frame, a key scan, then a public call made of another one
+bool checkStats()
+{
+	SimBoard board;
+	SC1628D &display = board.display;
+	const SC1628DStats &stats = display.getStats();
+	const uint8_t digits[5] = { 1, 2, 3, 4, DIGIT_BLANK };
+	Counts counts = { 0, 0, 0, 0, 0 };
+
+	display.resetStats();
+	if (!counted(stats, counts, "resetStats()") || samples(stats) != 0)
+		return fail("counters not cleared");
+
+	// A full frame: an incremental burst
+	size_t sent = board.sent();
+	unsigned long before = samples(stats), callBefore = samples(stats, SC1628D_CALL_DISPLAY_DIGITS);
+	display.displayDigits(digits);
+	if (longest(board.chip, sent) != 15)
+		return fail("the first frame is not a full burst");
+	counts.frames++;
+	decoded(board.chip, sent, counts);
+	if (!counted(stats, counts, "a full frame") || !sampled(stats, before, SC1628D_CALL_DISPLAY_DIGITS, callBefore, "displayDigits"))
+		return false;
+
+	// A delta frame: one digit at fixed addresses
+	sent = board.sent();
+	before = samples(stats);
+	callBefore = samples(stats, SC1628D_CALL_DISPLAY_DIGIT);
+	display.displayDigit(7, 3);
+	if (board.sent() == sent || board.chip.transactions[sent].bytes[0] != (SC1628D_DATA_SETTING_CMD_WRITE | SC1628D_2_FIXED_ADDR)
+		|| longest(board.chip, sent) != 2)
+		return fail("one digit is not sent at fixed addresses");
+	counts.frames++;
+	decoded(board.chip, sent, counts);
+	if (!counted(stats, counts, "a delta frame") || !sampled(stats, before, SC1628D_CALL_DISPLAY_DIGIT, callBefore, "displayDigit"))
+		return false;
+
+	// A key scan: 5 key bytes read
+	board.chip.setKeys(SIM_KEYS);
+	sent = board.sent();
+	before = samples(stats);
+	callBefore = samples(stats, SC1628D_CALL_GET_BUTTONS);
+	if (display.getButtons() != SIM_BUTTONS)
+		return fail("getButtons");
+	counts.keyScans++;
+	decoded(board.chip, sent, counts);
+	if (!counted(stats, counts, "getButtons()") || !sampled(stats, before, SC1628D_CALL_GET_BUTTONS, callBefore, "getButtons"))
+		return false;
+
+	// clear() calls displayDigits(): one sample, in the row of clear()
+	sent = board.sent();
+	before = samples(stats);
+	callBefore = samples(stats, SC1628D_CALL_CLEAR);
+	display.clear();
+	counts.frames++;
+	decoded(board.chip, sent, counts);
+	if (!counted(stats, counts, "clear()") || !sampled(stats, before, SC1628D_CALL_CLEAR, callBefore, "clear"))
+		return false;
+
+	// The bus time is within the time of the calls
+	if (stats.busMicros == 0 || stats.busMaxMicros > stats.busMicros)
+		return fail("bus time %lu us, longest transaction %lu us", (unsigned long)stats.busMicros, (unsigned long)stats.busMaxMicros);
+	return board.clean() || fail("protocol or timing error");
+}
+
+} // namespace
+
+
+int main()
+{
+	bool ok = checkStats();
+	printf("%s stats\n", ok ? "PASS" : "FAIL");
+	return ok ? 0 : 1;
+}
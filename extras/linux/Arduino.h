@@ -0,0 +1,63 @@
+/*
+ *  Arduino.h
+ *
+ *  Minimal Arduino core to build the SC1628D library as a Linux program,
+ *  with the SC1628DLinuxGPIOTransport: the clock functions read the
+ *  monotonic clock, the interrupt functions do nothing and the program
+ *  memory is ordinary memory. There are no Arduino pins: the pin functions
+ *  do nothing, only the transports which do not use them work.
+ *
+ *  (c) 2022/07/13 philippe.corbes@gmail.com
+ *
+ *
+ *  This library is free software; you can redistribute it and/or
+ *  modify it under the terms of the GNU Lesser General Public
+ *  License as published by the Free Software Foundation; either
+ *  version 2.1 of the License, or (at your option) any later version.
+ *
+ *  This library is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ *  Lesser General Public License for more details.
+ *
+ *  You should have received a copy of the GNU Lesser General Public
+ *  License along with this library; if not, write to the Free Software
+ */
+
+#ifndef __LINUX_ARDUINO_H__
+#define __LINUX_ARDUINO_H__
+
+#include <stdint.h>
+#include <stddef.h>
+#include <string.h>
+#include <stdlib.h>
+
+#define HIGH            0x1
+#define LOW             0x0
+
+#define INPUT           0x0
+#define OUTPUT          0x1
+#define INPUT_PULLUP    0x2
+
+#define PROGMEM
+#define pgm_read_byte(addr)   (*(const uint8_t *)(addr))
+#define pgm_read_word(addr)   (*(const uint16_t *)(addr))
+#define pgm_read_dword(addr)  (*(const uint32_t *)(addr))
+#define pgm_read_ptr(addr)    (*(const void * const *)(addr))
+#define memcpy_P(dst, src, n) memcpy((dst), (src), (n))
+#define PSTR(s)               (s)
+
+void pinMode(uint8_t pin, uint8_t mode);
+void digitalWrite(uint8_t pin, uint8_t val);
+int digitalRead(uint8_t pin);
+
+void delay(unsigned long ms);
+void delayMicroseconds(unsigned int us);
+unsigned long millis();
+unsigned long micros();
+
+// A Linux process is not interrupted by the driver
+inline void noInterrupts() {}
+inline void interrupts() {}
+
+#endif // __LINUX_ARDUINO_H__
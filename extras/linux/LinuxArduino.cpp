@@ -0,0 +1,75 @@
+/*
+ *  LinuxArduino.cpp
+ *
+ *  Minimal Arduino core to build the SC1628D library as a Linux program.
+ *
+ *  (c) 2022/07/13 philippe.corbes@gmail.com
+ *
+ *
+ *  This library is free software; you can redistribute it and/or
+ *  modify it under the terms of the GNU Lesser General Public
+ *  License as published by the Free Software Foundation; either
+ *  version 2.1 of the License, or (at your option) any later version.
+ *
+ *  This library is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ *  Lesser General Public License for more details.
+ *
+ *  You should have received a copy of the GNU Lesser General Public
+ *  License along with this library; if not, write to the Free Software
+ */
+
+#include <Arduino.h>
+#include <time.h>
+
+// Monotonic time since the first call, in microseconds
+static uint64_t LinuxArduino_Micros()
+{
+	static uint64_t origin = 0;
+	struct timespec now;
+
+	clock_gettime(CLOCK_MONOTONIC, &now);
+	uint64_t us = (uint64_t)now.tv_sec * 1000000ULL + now.tv_nsec / 1000;
+	if (!origin)
+		origin = us;
+	return us - origin;
+}
+
+void pinMode(uint8_t, uint8_t)
+{
+}
+
+void digitalWrite(uint8_t, uint8_t)
+{
+}
+
+int digitalRead(uint8_t)
+{
+	return LOW;
+}
+
+void delay(unsigned long ms)
+{
+	struct timespec t = { (time_t)(ms / 1000), (long)(ms % 1000) * 1000000L };
+	while (nanosleep(&t, &t))
+		;
+}
+
+void delayMicroseconds(unsigned int us)
+{
+	// Busy wait, as the Arduino cores: a sleep would last much longer
+	uint64_t start = LinuxArduino_Micros();
+	while (LinuxArduino_Micros() - start < us)
+		;
+}
+
+unsigned long millis()
+{
+	return (unsigned long)(LinuxArduino_Micros() / 1000);
+}
+
+unsigned long micros()
+{
+	return (unsigned long)LinuxArduino_Micros();
+}
@@ -0,0 +1,62 @@
+/*
+ *  sc1628d_linux.cpp
+ *
+ *  Linux test program of the SC1628D LED Driver IC, on three lines of a
+ *  GPIO character device: counts the seconds and prints the pressed keys.
+ *
+ *    sc1628d_linux /dev/gpiochip0 17 27 22 [seconds]
+ *
+ *  Built with the minimal Arduino core of this directory, without pins.
+ *
+ *  (c) 2022/07/13 philippe.corbes@gmail.com
+ *
+ *
+ *  This library is free software; you can redistribute it and/or
+ *  modify it under the terms of the GNU Lesser General Public
+ *  License as published by the Free Software Foundation; either
+ *  version 2.1 of the License, or (at your option) any later version.
+ *
+ *  This library is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ *  Lesser General Public License for more details.
+ *
+ *  You should have received a copy of the GNU Lesser General Public
+ *  License along with this library; if not, write to the Free Software
+ */
+
+#include <Arduino.h>
+#include <SC1628D.h>
+#include <SC1628DLinuxGPIOTransport.h>
+#include <stdio.h>
+
+int main(int argc, char *argv[])
+{
+	if (argc < 5) {
+		fprintf(stderr, "usage: %s chip stb clk dio [seconds]\n", argv[0]);
+		return 2;
+	}
+	SC1628DLinuxGPIOTransport bus(argv[1], strtoul(argv[2], NULL, 0), strtoul(argv[3], NULL, 0), strtoul(argv[4], NULL, 0));
+	unsigned long seconds = argc > 5 ? strtoul(argv[5], NULL, 0) : 10;
+
+	if (!bus.begin()) {
+		perror(argv[1]);
+		return 1;
+	}
+	SC1628DDriver display(bus);
+	display.setBrightness(2);
+
+	uint32_t pressed = 0;
+	unsigned long start = millis();
+	for (unsigned long s = 0; s <= seconds; ) {
+		display.displayNumber((int32_t)s);
+		uint32_t buttons = display.getButtons();
+		if (buttons != pressed)
+			printf("buttons %08lx\n", (unsigned long)buttons);
+		pressed = buttons;
+		delay(20);
+		s = (millis() - start) / 1000;
+	}
+	display.clear();
+	return 0;
+}
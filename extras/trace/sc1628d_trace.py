@@ -0,0 +1,219 @@
+#!/usr/bin/env python3
+#
+#  sc1628d_trace.py
+#
+#  Decoder of the SC1628D bus traces written by dumpTrace() (library built
+#  with SC1628D_TRACE): prints the commands of each transaction, rebuilds
+#  the display RAM frames, and reports the time between frames and the bus
+#  utilization.
+#
+#  The trace lines start with "@" and may be mixed with other output of the
+#  sketch: a Serial log can be decoded as it is. The RAM writes closer than
+#  --gap microseconds make a frame.
+#
+#  Usage: extras/trace/sc1628d_trace.py [--gap US] [--quiet] [--check] [FILE]
+#
+#  (c) 2022/07/13 philippe.corbes@gmail.com
+#
+#  This library is free software; you can redistribute it and/or
+#  modify it under the terms of the GNU Lesser General Public
+#  License as published by the Free Software Foundation; either
+#  version 2.1 of the License, or (at your option) any later version.
+#
+
+import argparse
+import re
+import sys
+
+RAM_SIZE = 14
+
+# "@W 0001e240 0012 c03f000600", "@L 0003", "@= 3f00 0600 ..." (host checks)
+RECORD_RE = re.compile(r"@([WRL=])\s*([0-9a-fA-F ]*)(\+?)")
+
+
+def buttons(keys):
+    """Names of the pressed keys, as getButtons(): byte i holds KS(2i+1) and KS(2i+2)"""
+    names = []
+    for i, key in enumerate(keys):
+        for bit, k, ks in ((0x01, 1, 2 * i + 1), (0x02, 2, 2 * i + 1), (0x08, 1, 2 * i + 2), (0x10, 2, 2 * i + 2)):
+            if key & bit:
+                names.append("K%d/KS%d" % (k, ks))
+    return " ".join(names) or "none"
+
+
+def grids(ram):
+    """The RAM as 7 grid words, low byte first, "??" for the bytes not written yet"""
+    text = ["??" if b is None else "%02x" % b for b in ram]
+    return " ".join(text[k] + text[k + 1] for k in range(0, RAM_SIZE, 2))
+
+
+class Decoder:
+
+    def __init__(self, gap, quiet):
+        self.gap = gap
+        self.quiet = quiet
+        self.ram = [None] * RAM_SIZE
+        self.fixed = False
+        self.reading = False
+        self.origin = None          # Time of the first transaction
+        self.last = None            # Unwrapped time of the previous transaction
+        self.end = 0
+        self.busy = 0
+        self.transactions = 0
+        self.reads = 0
+        self.bytes = 0
+        self.lost = 0
+        self.errors = 0
+        self.checks = 0
+        self.failed = 0
+        self.frames = []            # Start times of the frames
+        self.frameWrite = None      # End of the last RAM write of the current frame
+        self.frameBytes = 0
+
+    def out(self, text):
+        if not self.quiet:
+            print(text)
+
+    def error(self, text):
+        self.errors += 1
+        print("ERROR: " + text)
+
+    def time(self, micros):
+        """Unwrap the 32-bit micros() time"""
+        if self.last is None:
+            self.origin = self.last = micros
+            return micros
+        self.last += (micros - self.last) & 0xffffffff
+        return self.last
+
+    def closeFrame(self):
+        if self.frameWrite is None:
+            return
+        self.out("%12s        -- frame %d, %d bytes: %s" % ("", len(self.frames), self.frameBytes, grids(self.ram)))
+        self.frameWrite = None
+
+    def command(self, data):
+        """Decode a write transaction, return its description"""
+        command = data[0]
+        kind = command & 0xc0
+        if kind == 0x00:
+            if len(data) > 1:
+                self.error("bytes after the display mode command")
+            return "MODE  %d grids, %d segments" % (4 + (command & 3), 14 - (command & 3))
+        if kind == 0x40:
+            self.reading = bool(command & 0x02)
+            self.fixed = bool(command & 0x04)
+            return "DATA  %s, %s address%s" % ("read keys" if self.reading else "write",
+                                                "fixed" if self.fixed else "increment",
+                                                ", test mode" if command & 0x08 else "")
+        if kind == 0x80:
+            return "CTRL  display %s, brightness %d" % ("on" if command & 0x08 else "off", command & 0x07)
+        address = command & 0x0f
+        if self.reading:
+            self.error("RAM write in read mode")
+        for i, b in enumerate(data[1:]):
+            where = address if self.fixed else address + i
+            if where >= RAM_SIZE:
+                self.error("RAM address 0x%02x" % where)
+                continue
+            self.ram[where] = b
+        return "ADDR  0x%02x: %s" % (address, " ".join("%02x" % b for b in data[1:]))
+
+    def transaction(self, kind, fields, truncated):
+        if len(fields) < 3:
+            self.error("incomplete record")
+            return
+        start = self.time(int(fields[0], 16))
+        duration = int(fields[1], 16)
+        data = bytes.fromhex(fields[2])
+        if not data:
+            self.error("transaction without command")
+            return
+        self.transactions += 1
+        self.bytes += len(data)
+        self.busy += duration
+        self.end = max(self.end, start + duration)
+        if self.frameWrite is not None and start - self.frameWrite > self.gap:
+            self.closeFrame()
+
+        if kind == "R":
+            self.reads += 1
+            self.reading = True
+            text = "KEYS  %s: %s" % (" ".join("%02x" % b for b in data[1:]), buttons(data[1:]))
+            if data[0] & 0xc2 != 0x42:
+                self.error("key read without the read command")
+        else:
+            write = data[0] & 0xc0 == 0xc0
+            text = self.command(data)
+            if write:
+                if self.frameWrite is None:
+                    self.frames.append(start)
+                    self.frameBytes = 0
+                self.frameWrite = start + duration
+                self.frameBytes += len(data) - 1
+        if truncated:
+            text += " ... (truncated)"
+        self.out("%12.3f %6d  %s" % ((start - self.origin) / 1000.0, duration, text))
+
+    def check(self, expected):
+        self.closeFrame()
+        self.checks += 1
+        if self.ram == list(expected):
+            self.out("%12s        -- RAM check passed" % "")
+        else:
+            self.failed += 1
+            print("CHECK FAILED: RAM %s instead of %s" % (grids(self.ram), grids(list(expected))))
+
+    def record(self, line):
+        match = RECORD_RE.search(line)
+        if not match:
+            return
+        kind, fields, truncated = match.group(1), match.group(2).split(), match.group(3)
+        if kind == "L":
+            lost = int(fields[0], 16) if fields else 0
+            self.lost += lost
+            self.closeFrame()
+            self.ram = [None] * RAM_SIZE
+            self.out("%12s        -- %d transactions lost" % ("", lost))
+        elif kind == "=":
+            self.check(bytes.fromhex("".join(fields)))
+        else:
+            self.transaction(kind, fields, truncated)
+
+    def summary(self):
+        self.closeFrame()
+        span = self.end - self.origin if self.origin is not None else 0
+        print("\n%d transactions (%d key reads), %d bytes, %d lost" % (self.transactions, self.reads, self.bytes, self.lost))
+        intervals = [b - a for a, b in zip(self.frames, self.frames[1:])]
+        if intervals:
+            print("%d frames, interval min %.3f ms, average %.3f ms, max %.3f ms" % (
+                len(self.frames), min(intervals) / 1000.0, sum(intervals) / 1000.0 / len(intervals), max(intervals) / 1000.0))
+        else:
+            print("%d frames" % len(self.frames))
+        if span:
+            print("bus busy %d us in %.3f ms: %.2f %%" % (self.busy, span / 1000.0, 100.0 * self.busy / span))
+        if self.checks:
+            print("%d of %d RAM checks passed" % (self.checks - self.failed, self.checks))
+
+
+def main():
+    parser = argparse.ArgumentParser(description="SC1628D bus trace decoder")
+    parser.add_argument("file", nargs="?", help="dumpTrace() output, the standard input by default")
+    parser.add_argument("--gap", type=int, default=5000, help="longest time between the RAM writes of a frame, in us")
+    parser.add_argument("--quiet", action="store_true", help="only print the summary")
+    parser.add_argument("--check", action="store_true", help="exit with 1 on a decoding error or a failed RAM check")
+    args = parser.parse_args()
+
+    decoder = Decoder(args.gap, args.quiet)
+    source = open(args.file) if args.file else sys.stdin
+    with source:
+        for line in source:
+            decoder.record(line)
+    decoder.summary()
+    if args.check and (decoder.errors or decoder.failed or not decoder.checks):
+        return 1
+    return 0
+
+
+if __name__ == "__main__":
+    sys.exit(main())